@@ -1,5 +1,5 @@
 #include "abstract_solver.h"
-#include <exception>
+#include <stdexcept>
 
 void AbstractSolver::setParameters(HeatDiffusionParameters problemParameters) {
   if (problemParameters.checkInitialization()) {
@@ -12,4 +12,50 @@ void AbstractSolver::setParameters(HeatDiffusionParameters problemParameters) {
 
 std::string AbstractSolver::getSchemeName() const { return (schemeName); };
 
+std::string AbstractSolver::getConfigurationName() const {
+  return (schemeName);
+};
+
+double AbstractSolver::getStepsPerSecond() const { return (stepsPerSecond); };
+
+void AbstractSolver::recordStepRate(
+    int numberOfSteps, std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  stepsPerSecond =
+      (elapsed.count() > 0) ? numberOfSteps / elapsed.count() : 0;
+}
+
+int AbstractSolver::computeNumberOfTimeSteps() const {
+  return (parameters.getNumberOfTimeSteps(deltaT));
+}
+
+void AbstractSolver::initialStateOnMesh(
+    const SpaceMesh &mesh, std::vector<double> *temperatures) const {
+  int numberOfPoints = mesh.getNumberOfPoints();
+  (*temperatures).assign(numberOfPoints, parameters.getInternalTemperature());
+  (*temperatures)[0] = parameters.getSurfaceTemperature();
+  (*temperatures)[numberOfPoints - 1] = parameters.getSurfaceTemperature();
+}
+
+SpaceMesh AbstractSolver::initialMesh(const SpaceMesh &mesh,
+                                      const MeshRefinement &refinement) const {
+  if (mesh.getNumberOfPoints() < 3) {
+    throw(std::invalid_argument("the mesh should have at least 3 points"));
+  }
+  SpaceMesh currentMesh = mesh;
+  std::vector<double> initialState;
+  for (int i = 0; i < MAXIMUM_INITIAL_REFINEMENTS && refinement.isEnabled();
+       i++) {
+    initialStateOnMesh(currentMesh, &initialState);
+    SpaceMesh refinedMesh =
+        refinement.refine(currentMesh, initialState.data());
+    if (refinedMesh == currentMesh) {
+      break;
+    }
+    currentMesh = refinedMesh;
+  }
+  return currentMesh;
+}
+
 AbstractSolver::~AbstractSolver(){};
@@ -1,6 +1,10 @@
 #pragma once // Include guard
 #include "heat_diffusion_parameters.h"
+#include "solution_grid.h"
+#include "space_mesh.h"
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 /**
@@ -12,6 +16,14 @@
 
 class AbstractSolver {
 public:
+  /**
+   * @brief Function receiving each time step of the solution as soon as it
+   * has been computed : (time index, temperatures at this time, number of
+   * space points). The temperatures are only valid during the call.
+   *
+   */
+  typedef std::function<void(int, const double *, int)> RowSink;
+
   /**
    * @brief Set up parameters of the problem to solve
    *
@@ -26,13 +38,49 @@ public:
    *
    * @param deltaX : size if the space step
    * @param deltaT : size of the time step
-   * @param TSolutionPtr : pointer to a vector of vector of double to store the
-   * solution
+   * @param TSolutionPtr : pointer to the grid where the solution is stored.
+   * It is resized to the number of time steps x number of space points and
+   * filled in place.
+   *
+   */
+  virtual void solveRegularMeshes(double deltaX, double deltaT,
+                                  SolutionGrid *TSolutionPtr) = 0;
+
+  /**
+   * @brief Solve the issue without storing the whole solution. Only the time
+   * levels required by the scheme are kept in a rolling window and each
+   * completed time step is handed to sink, starting with t=0. The memory used
+   * does not depend on the time limit.
+   *
+   * Can throw exception if not all attributes have been properly initialized
    *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order
    */
-  virtual void
-  solveRegularMeshes(double deltaX, double deltaT,
-                     std::vector<std::vector<double> > *TSolutionPtr) = 0;
+  virtual void solveStreaming(double deltaX, double deltaT, RowSink sink) = 0;
+
+  /**
+   * @brief Solve the issue on a mesh that is not necessarily evenly spaced,
+   * for example refined near the surfaces (see SpaceMesh::graded). Like
+   * solveStreaming, only the time levels required by the scheme are kept and
+   * each time step is handed to sink with its mesh, starting with t=0.
+   *
+   * With an enabled refinement, the mesh is first adapted to the initial
+   * state, then after every refinement period (see MeshRefinement); the
+   * time steps handed to sink can then have different meshes.
+   *
+   * Can throw exception if not all attributes have been properly initialized
+   * or if the scheme cannot be used on such a mesh
+   *
+   * @param mesh : points of the wall, from 0 to the width
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order
+   * @param refinement : how the mesh is adapted during the solve
+   */
+  virtual void solveOnMesh(const SpaceMesh &mesh, double deltaT,
+                           MeshRowSink sink,
+                           const MeshRefinement &refinement) = 0;
 
   /**
    * @brief Get the name of the scheme used by the solver
@@ -41,6 +89,33 @@ public:
    */
   std::string getSchemeName() const;
 
+  /**
+   * @brief Get a name telling apart the solvers giving different results for
+   * the same problem : the name of the scheme, followed by the settings
+   * changing the results if any. Settings only changing the speed (threads,
+   * tiles) are left out.
+   *
+   * @return std::string name of the scheme and its settings
+   */
+  virtual std::string getConfigurationName() const;
+
+  /**
+   * @brief Create a new solver of the same scheme with the same settings, for
+   * example to run several solves of a scheme at once. The parameters of the
+   * problem are not copied.
+   *
+   * @return std::unique_ptr<AbstractSolver> the new solver
+   */
+  virtual std::unique_ptr<AbstractSolver> clone() const = 0;
+
+  /**
+   * @brief Get the number of time steps computed per second during the last
+   * call to solveRegularMeshes
+   *
+   * @return double steps per second, 0 if no step has been computed yet
+   */
+  double getStepsPerSecond() const;
+
   /**
    * @brief Destroy the Abstract Solve object
    *
@@ -72,4 +147,49 @@ protected:
    * derived classes
    */
   std::string schemeName;
+
+  /**
+   * @brief Number of time steps per second measured during the last solve
+   *
+   */
+  double stepsPerSecond = 0;
+
+  /**
+   * @brief Store the step rate of a solve that started at start and computed
+   * numberOfSteps time steps
+   *
+   * @param numberOfSteps : number of time steps computed
+   * @param start : time at which the time loop started
+   */
+  void recordStepRate(int numberOfSteps,
+                      std::chrono::steady_clock::time_point start);
+
+  /**
+   * @brief Number of time steps of the solution, including t=0, for the
+   * current deltaT : time step n is computed while n * deltaT <= timeStop
+   *
+   * @return int number of time steps
+   */
+  int computeNumberOfTimeSteps() const;
+
+  /**
+   * @brief Store in temperatures the initial state on a mesh : the surface
+   * temperature at both ends, the internal temperature elsewhere
+   *
+   */
+  void initialStateOnMesh(const SpaceMesh &mesh,
+                          std::vector<double> *temperatures) const;
+
+  /**
+   * @brief Mesh of the first time step of solveOnMesh : mesh adapted to the
+   * initial state by refinement until it does not change anymore (at most
+   * MAXIMUM_INITIAL_REFINEMENTS times). The initial state is not
+   * interpolated between the refinements but set again on each mesh, so that
+   * the jump of temperature at the surfaces stays a jump.
+   *
+   */
+  SpaceMesh initialMesh(const SpaceMesh &mesh,
+                        const MeshRefinement &refinement) const;
+
+  static const int MAXIMUM_INITIAL_REFINEMENTS = 64;
 };
@@ -0,0 +1,130 @@
+#include "adaptive_comparison.h"
+#include "error_accumulator.h"
+#include "exact_solver.h"
+#include "solution_grid.h"
+#include <iomanip>
+
+namespace {
+/**
+ * @brief Tolerance of the analytical solution used as a reference, well
+ * below the errors measured
+ *
+ */
+const double REFERENCE_TOLERANCE = 1e-12;
+/**
+ * @brief Uniform norm of the errors of a temperature profile at time t
+ *
+ */
+double errorAt(ExactSolver *exactSolver, double deltaX, double t,
+               const double *numericalRow, int numberOfColumns) {
+  SolutionGrid analyticalSolution;
+  (*exactSolver).solveAtTimes(deltaX, std::vector<double>(1, t),
+                              &analyticalSolution);
+  ErrorAccumulator errors;
+  errors.addRow(numericalRow, analyticalSolution.row(0), numberOfColumns);
+  return errors.getUniformNorm();
+}
+
+/**
+ * @brief Uniform norm of the errors at the time limit of a solve with a
+ * uniform time step. Only the last time step is kept.
+ *
+ */
+double uniformSolveError(ImplicitSolver *solver, ExactSolver *exactSolver,
+                         double deltaX, double deltaT, double timeStop) {
+  std::vector<double> lastRow;
+  (*solver).solveStreaming(
+      deltaX, deltaT, [&](int, const double *row, int numberOfColumns) {
+        lastRow.assign(row, row + numberOfColumns);
+      });
+  return errorAt(exactSolver, deltaX, timeStop, lastRow.data(),
+                 lastRow.size());
+}
+} // namespace
+
+long long AdaptiveComparison::adaptiveLinearSolves() const {
+  return 3LL * (adaptiveSteps + rejectedSteps);
+}
+
+long long AdaptiveComparison::uniformLinearSolves() const {
+  return uniformSteps;
+}
+
+AdaptiveComparison
+compareAdaptiveWithUniform(ImplicitSolver *solver,
+                           const HeatDiffusionParameters &parameters,
+                           double deltaX, double initialDeltaT,
+                           double tolerance,
+                           AdaptiveSolution *adaptiveSolution) {
+  AdaptiveSolution localSolution;
+  if (!adaptiveSolution) {
+    adaptiveSolution = &localSolution;
+  }
+  (*solver).setParameters(parameters);
+  ExactSolver exactSolver;
+  exactSolver.setParameters(parameters);
+  exactSolver.setTolerance(REFERENCE_TOLERANCE);
+
+  AdaptiveComparison comparison;
+  comparison.schemeName = (*solver).getSchemeName();
+  comparison.tolerance = tolerance;
+  (*solver).solveAdaptive(deltaX, initialDeltaT, tolerance, adaptiveSolution);
+  comparison.adaptiveSteps = (*adaptiveSolution).acceptedSteps;
+  comparison.rejectedSteps = (*adaptiveSolution).rejectedSteps;
+  comparison.adaptiveFactorizations = (*adaptiveSolution).factorizations;
+  double timeStop = parameters.getTimeStop();
+  const SolutionGrid &temperatures = (*adaptiveSolution).temperatures;
+  comparison.adaptiveError =
+      errorAt(&exactSolver, deltaX, timeStop,
+              temperatures.row(temperatures.getNumberOfRows() - 1),
+              temperatures.getNumberOfColumns());
+
+  // deltaT = time limit / 2^k, so that the last time step ends exactly at
+  // the time limit
+  for (int steps = 1; steps <= AdaptiveComparison::MAXIMUM_UNIFORM_STEPS;
+       steps *= 2) {
+    comparison.uniformDeltaT = timeStop / steps;
+    comparison.uniformSteps = steps;
+    comparison.uniformError = uniformSolveError(
+        solver, &exactSolver, deltaX, comparison.uniformDeltaT, timeStop);
+    if (comparison.uniformError <= comparison.adaptiveError) {
+      comparison.uniformErrorReached = true;
+      break;
+    }
+  }
+  return comparison;
+}
+
+void writeAdaptiveReport(std::ostream &outputStream,
+                         const std::vector<AdaptiveComparison> &comparisons) {
+  std::ios::fmtflags flags = outputStream.flags();
+  std::streamsize precision = outputStream.precision();
+  outputStream << std::setprecision(3);
+  for (const AdaptiveComparison &comparison : comparisons) {
+    outputStream << comparison.schemeName << " adaptive (tolerance "
+                 << comparison.tolerance << ") : " << comparison.adaptiveSteps
+                 << " steps (" << comparison.rejectedSteps << " rejected, "
+                 << comparison.adaptiveLinearSolves() << " linear solves, "
+                 << comparison.adaptiveFactorizations
+                 << " factorizations), error " << comparison.adaptiveError
+                 << "\n";
+    outputStream << comparison.schemeName << " uniform deltaT = "
+                 << comparison.uniformDeltaT << " : "
+                 << comparison.uniformSteps << " steps, error "
+                 << comparison.uniformError;
+    if (comparison.uniformErrorReached) {
+      outputStream << " -> "
+                   << comparison.uniformSteps - comparison.adaptiveSteps
+                   << " steps saved ("
+                   << comparison.uniformLinearSolves() -
+                          comparison.adaptiveLinearSolves()
+                   << " linear solves)\n";
+    } else {
+      outputStream << " -> error of the adaptive solve not reached with "
+                   << AdaptiveComparison::MAXIMUM_UNIFORM_STEPS
+                   << " uniform steps\n";
+    }
+  }
+  outputStream.flags(flags);
+  outputStream.precision(precision);
+}
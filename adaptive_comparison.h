@@ -0,0 +1,86 @@
+#pragma once // Include guard
+#include "heat_diffusion_parameters.h"
+#include "implicit_solver.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cost of an adaptive solve compared to the uniform solve reaching
+ * the same error (see compareAdaptiveWithUniform)
+ *
+ */
+struct AdaptiveComparison {
+  std::string schemeName;
+  double tolerance = 0;
+  /**
+   * @brief Time steps kept and rejected by the adaptive solve, and uniform
+   * norm of its errors at the time limit
+   *
+   */
+  int adaptiveSteps = 0;
+  int rejectedSteps = 0;
+  int adaptiveFactorizations = 0;
+  double adaptiveError = 0;
+  /**
+   * @brief Largest uniform deltaT (the time limit divided by a power of 2)
+   * giving an error at most adaptiveError, its number of time steps and its
+   * error. If no deltaT down to the time limit divided by
+   * MAXIMUM_UNIFORM_STEPS reaches adaptiveError, uniformErrorReached is
+   * false and the values are the ones of the smallest deltaT tried.
+   *
+   */
+  double uniformDeltaT = 0;
+  int uniformSteps = 0;
+  double uniformError = 0;
+  bool uniformErrorReached = false;
+
+  static const int MAXIMUM_UNIFORM_STEPS = 1 << 18;
+
+  /**
+   * @brief Number of linear solves of each run : one per uniform step, three
+   * per adaptive step tried (one step of deltaT and two of deltaT / 2)
+   *
+   */
+  long long adaptiveLinearSolves() const;
+  long long uniformLinearSolves() const;
+};
+
+/**
+ * @brief Solve the issue with solveAdaptive, then with uniform time steps
+ * halved until the uniform solve is at least as accurate, and compare their
+ * number of time steps. Both errors are the uniform norm of analytical -
+ * numerical at the time limit, the analytical solution being computed by an
+ * ExactSolver with a tolerance well below the errors. The errors of the first
+ * time steps are not compared : right after the jump of temperature at the
+ * walls they come from the space step and hardly depend on deltaT.
+ *
+ * The uniform solves are streamed, only their last time step is kept.
+ *
+ * Can throw an invalid_argument exception if the parameters are not
+ * initialized
+ *
+ * @param solver : implicit solver, its parameters are replaced by parameters
+ * @param parameters : parameters of the issue
+ * @param deltaX : size of the space step
+ * @param initialDeltaT : first time step tried by the adaptive solve
+ * @param tolerance : tolerance on the local error of the adaptive solve
+ * @param adaptiveSolution : where the adaptive solution is stored, can be
+ * null
+ * @return AdaptiveComparison : the comparison
+ */
+AdaptiveComparison
+compareAdaptiveWithUniform(ImplicitSolver *solver,
+                           const HeatDiffusionParameters &parameters,
+                           double deltaX, double initialDeltaT,
+                           double tolerance,
+                           AdaptiveSolution *adaptiveSolution = nullptr);
+
+/**
+ * @brief Write one line per comparison : steps and linear solves of both
+ * runs (and factorizations of the adaptive one), their errors and the steps
+ * saved by the adaptive solve
+ *
+ */
+void writeAdaptiveReport(std::ostream &outputStream,
+                         const std::vector<AdaptiveComparison> &comparisons);
@@ -0,0 +1,214 @@
+#include "adi_solver.h"
+#include "batched_thomas.h"
+#include "exact_solver.h"
+#include "instrumentation.h"
+#include "solver_engine.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Size of the square tiles of a transposition : a tile of the source
+ * and of the destination stay in cache together
+ *
+ */
+const int TRANSPOSE_TILE = 32;
+
+/**
+ * @brief Call body(first, last) on the blocks of ADISolver::LINES_PER_TASK
+ * indices of [begin, end), in parallel
+ *
+ */
+void forEachBlock(int begin, int end,
+                  const std::function<void(int, int)> &body) {
+  int numberOfLines = std::max(0, end - begin);
+  int numberOfBlocks = (numberOfLines + ADISolver::LINES_PER_TASK - 1) /
+                       ADISolver::LINES_PER_TASK;
+  ThreadPool::shared().parallelFor(0, numberOfBlocks, [&](int block) {
+    int first = begin + block * ADISolver::LINES_PER_TASK;
+    body(first, std::min(end, first + ADISolver::LINES_PER_TASK));
+  });
+}
+
+/**
+ * @brief destination(j, i) = source(i, j), by tiles. destination should have
+ * the transposed size of source.
+ *
+ */
+void transpose(const SolutionGrid &source, SolutionGrid *destination) {
+  HEAT_TIMED_SCOPE("adi.transpose");
+  int numberOfRows = source.getNumberOfRows();
+  int numberOfColumns = source.getNumberOfColumns();
+  int numberOfTileRows = (numberOfRows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+  ThreadPool::shared().parallelFor(0, numberOfTileRows, [&](int tileRow) {
+    int firstRow = tileRow * TRANSPOSE_TILE;
+    int lastRow = std::min(numberOfRows, firstRow + TRANSPOSE_TILE);
+    for (int firstColumn = 0; firstColumn < numberOfColumns;
+         firstColumn += TRANSPOSE_TILE) {
+      int lastColumn = std::min(numberOfColumns, firstColumn + TRANSPOSE_TILE);
+      for (int j = firstColumn; j < lastColumn; j++) {
+        double *destinationRow = (*destination).row(j);
+        for (int i = firstRow; i < lastRow; i++) {
+          destinationRow[i] = source(i, j);
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Half step along the columns of a grid : the right hand side of the
+ * inner columns is computed from temperatures in rightHandSide, by blocks of
+ * rows, then transposed in solved where the columns are solved
+ *
+ */
+void halfStep(const SolutionGrid &temperatures, SolutionGrid *rightHandSide,
+              SolutionGrid *solved, double c, const double *lowerDiagonal,
+              const double *pivots, const double *modifiedUpperDiagonal) {
+  int numberOfRows = temperatures.getNumberOfRows();
+  int numberOfLines = temperatures.getNumberOfColumns() - 2;
+  std::ptrdiff_t stride = temperatures.getRowStride();
+  forEachBlock(1, numberOfRows - 1, [&](int firstRow, int lastRow) {
+    batched::crankNicholsonSharedRightHandSide(
+        temperatures.row(firstRow - 1) + 1,
+        (*rightHandSide).row(firstRow - 1) + 1, lastRow - firstRow + 2,
+        numberOfLines, stride, c);
+  });
+  transpose(*rightHandSide, solved);
+  int numberOfUnknowns = (*solved).getNumberOfRows();
+  std::ptrdiff_t solvedStride = (*solved).getRowStride();
+  forEachBlock(1, (*solved).getNumberOfColumns() - 1,
+               [&](int firstLine, int lastLine) {
+                 batched::solveSharedFactorized(
+                     numberOfUnknowns, lastLine - firstLine, solvedStride,
+                     lowerDiagonal, pivots, modifiedUpperDiagonal,
+                     (*solved).row(0) + firstLine);
+               });
+}
+
+/**
+ * @brief Factorized matrix of the Crank-Nicholson scheme for lines of
+ * numberOfPoints points
+ *
+ */
+void factorizeLines(double c, int numberOfPoints,
+                    std::vector<double> *lowerDiagonal,
+                    std::vector<double> *pivots,
+                    std::vector<double> *modifiedUpperDiagonal) {
+  std::vector<double> mainDiagonal(numberOfPoints);
+  std::vector<double> upperDiagonal(numberOfPoints);
+  (*lowerDiagonal).resize(numberOfPoints);
+  (*pivots).resize(numberOfPoints);
+  (*modifiedUpperDiagonal).resize(numberOfPoints);
+  ImplicitKernels<scheme::CrankNicholson>::fillDiagonals(
+      c, numberOfPoints, (*lowerDiagonal).data(), mainDiagonal.data(),
+      upperDiagonal.data());
+  factorizeTridiagonal(numberOfPoints, (*lowerDiagonal).data(),
+                       mainDiagonal.data(), upperDiagonal.data(),
+                       (*pivots).data(), (*modifiedUpperDiagonal).data());
+}
+
+} // namespace
+
+void ADISolver::setParameters(const HeatDiffusionParameters &pparameters,
+                              double pheight) {
+  if (!pparameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  if (pheight <= 0) {
+    throw(std::invalid_argument("the height should be positive"));
+  }
+  parameters = pparameters;
+  height = pheight;
+}
+
+void ADISolver::checkProblem(double deltaX) const {
+  if (height <= 0) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  if (deltaX <= 0) {
+    throw(std::invalid_argument("deltaX should be positive"));
+  }
+}
+
+void ADISolver::initialize(double deltaX, double c) {
+  HeatDiffusionParameters heightParameters(parameters);
+  heightParameters.setWidth(height);
+  int numberOfColumns = parameters.getNumberOfSpacePoints(deltaX);
+  int numberOfRows = heightParameters.getNumberOfSpacePoints(deltaX);
+
+  // The surfaces are set once in every grid : the half steps only write the
+  // inner points
+  temperaturesYX.resize(numberOfRows, numberOfColumns);
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  double internalTemperature = parameters.getInternalTemperature();
+  for (int j = 0; j < numberOfRows; j++) {
+    double *line = temperaturesYX.row(j);
+    bool surface = (j == 0 || j == numberOfRows - 1);
+    std::fill(line, line + numberOfColumns,
+              surface ? surfaceTemperature : internalTemperature);
+    line[0] = surfaceTemperature;
+    line[numberOfColumns - 1] = surfaceTemperature;
+  }
+  rightHandSideYX = temperaturesYX;
+  temperaturesXY.resize(numberOfColumns, numberOfRows);
+  transpose(temperaturesYX, &temperaturesXY);
+  rightHandSideXY = temperaturesXY;
+
+  factorizeLines(c, numberOfColumns, &lowerDiagonalX, &pivotsX,
+                 &modifiedUpperDiagonalX);
+  factorizeLines(c, numberOfRows, &lowerDiagonalY, &pivotsY,
+                 &modifiedUpperDiagonalY);
+}
+
+void ADISolver::step(double c) {
+  HEAT_TIMED_SCOPE("adi.step");
+  // Implicit along x : the lines along x are the columns of temperaturesXY
+  halfStep(temperaturesYX, &rightHandSideYX, &temperaturesXY, c,
+           lowerDiagonalX.data(), pivotsX.data(),
+           modifiedUpperDiagonalX.data());
+  // Implicit along y : the columns of temperaturesYX
+  halfStep(temperaturesXY, &rightHandSideXY, &temperaturesYX, c,
+           lowerDiagonalY.data(), pivotsY.data(),
+           modifiedUpperDiagonalY.data());
+}
+
+void ADISolver::solveStreaming(double deltaX, double deltaT, FieldSink sink) {
+  checkProblem(deltaX);
+  if (deltaT <= 0) {
+    throw(std::invalid_argument("deltaT should be positive"));
+  }
+  double c = scheme::CrankNicholson::coupling(parameters.getDiffusivity(),
+                                              deltaT, deltaX);
+  initialize(deltaX, c);
+  if (sink) {
+    sink(0, temperaturesYX);
+  }
+  double timeStop = parameters.getTimeStop();
+  int timeIndex = 1;
+  for (; (timeIndex * deltaT) <= timeStop; timeIndex++) {
+    step(c);
+    if (sink) {
+      sink(timeIndex, temperaturesYX);
+    }
+  }
+  HEAT_COUNT("adi.steps", timeIndex - 1);
+}
+
+void ADISolver::solve(double deltaX, double deltaT,
+                      SolutionGrid *temperatures) {
+  solveStreaming(deltaX, deltaT, FieldSink());
+  *temperatures = temperaturesYX;
+}
+
+void ADISolver::exactSolution(double deltaX, double time,
+                              SolutionGrid *temperatures) const {
+  checkProblem(deltaX);
+  ExactSolver exactSolver;
+  exactSolver.setParameters(parameters);
+  exactSolver.solveBoxAt(deltaX, height, 0, time, temperatures);
+}
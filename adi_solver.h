@@ -0,0 +1,141 @@
+#pragma once // Include guard
+#include "heat_diffusion_parameters.h"
+#include "solution_grid.h"
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Solver of the 2D heat conduction problem on a rectangular
+ * cross-section of the wall, with the alternating direction implicit scheme
+ * of Peaceman and Rachford
+ *
+ * The cross-section is width x height, with the surface temperature on its
+ * four sides and the internal temperature inside at t=0. Both directions use
+ * the same space step deltaX. Each time step is split into two half steps,
+ * implicit in one direction and explicit in the other :
+ * (I - c dx2) T* = (I + c dy2) T(n)
+ * (I - c dy2) T(n+1) = (I + c dx2) T*
+ * with c = diffusivity * deltaT / (2 deltaX^2) and dx2, dy2 the three points
+ * second differences. Each half step is a Crank-Nicholson step along the
+ * lines of one direction : the lines share the tridiagonal matrix of the
+ * Crank-Nicholson scheme, factorized once with the Thomas algorithm. The
+ * scheme is unconditionally stable and of order 2 in time and space.
+ *
+ * The temperatures are stored in a SolutionGrid where row j holds the line
+ * y = j * deltaX and column i the line x = i * deltaX, and in a transposed
+ * copy. The lines of each half step are the columns of one of them : they are
+ * solved together by the vectorized kernels of batched_thomas.h, by blocks of
+ * LINES_PER_TASK lines spread over the threads of ThreadPool::shared(). The
+ * grids are transposed by tiles between the half steps, so that all the
+ * sweeps read the memory contiguously.
+ */
+class ADISolver {
+public:
+  /**
+   * @brief Function called with each time step computed, given by its index
+   * (time timeIndex * deltaT) and its temperatures (row j : y = j * deltaX)
+   *
+   */
+  typedef std::function<void(int timeIndex, const SolutionGrid &temperatures)>
+      FieldSink;
+
+  /**
+   * @brief Number of lines solved by one task of the thread pool
+   *
+   */
+  static const int LINES_PER_TASK = 64;
+
+  /**
+   * @brief Set up the parameters of the problem : the width of the
+   * cross-section is the width of parameters
+   *
+   * Can throw an invalid_argument exception if parameters are not all
+   * initialized or if height is not positive
+   *
+   * @param parameters : parameters of the problem
+   * @param height : height of the cross-section
+   */
+  void setParameters(const HeatDiffusionParameters &parameters, double height);
+
+  /**
+   * @brief Solve the problem up to the time limit
+   *
+   * Can throw an invalid_argument exception if the parameters are not set or
+   * if deltaX or deltaT are not positive
+   *
+   * @param deltaX : size of the space step, in both directions
+   * @param deltaT : size of the time step
+   * @param temperatures : where the temperatures at the last time step are
+   * stored
+   */
+  void solve(double deltaX, double deltaT, SolutionGrid *temperatures);
+
+  /**
+   * @brief Solve the problem up to the time limit, handing each time step to
+   * sink, the initial state included. Only the current time step is kept in
+   * memory.
+   *
+   * Can throw an invalid_argument exception if the parameters are not set or
+   * if deltaX or deltaT are not positive
+   *
+   * @param deltaX : size of the space step, in both directions
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order, can be
+   * empty
+   */
+  void solveStreaming(double deltaX, double deltaT, FieldSink sink);
+
+  /**
+   * @brief Analytical solution at a given time, on the grid of solve (see
+   * ExactSolver::solveBoxAt)
+   *
+   * Can throw an invalid_argument exception if the parameters are not set
+   *
+   * @param deltaX : size of the space step
+   * @param time : time of the solution
+   * @param temperatures : where the solution is stored
+   */
+  void exactSolution(double deltaX, double time,
+                     SolutionGrid *temperatures) const;
+
+private:
+  HeatDiffusionParameters parameters;
+  double height = 0;
+
+  /**
+   * @brief Diagonals of the matrices of the lines along x (numberOfColumns
+   * unknowns) and along y (numberOfRows unknowns), factorized by
+   * factorizeTridiagonal
+   *
+   */
+  std::vector<double> lowerDiagonalX, pivotsX, modifiedUpperDiagonalX;
+  std::vector<double> lowerDiagonalY, pivotsY, modifiedUpperDiagonalY;
+
+  /**
+   * @brief Temperatures (row j : y = j * deltaX) and their transposed copy
+   * (row i : x = i * deltaX), with the right hand side of the half steps in
+   * the same layouts
+   *
+   */
+  SolutionGrid temperaturesYX, temperaturesXY, rightHandSideYX,
+      rightHandSideXY;
+
+  /**
+   * @brief Throw an invalid_argument exception if the parameters are not set
+   * or if deltaX is not positive
+   *
+   */
+  void checkProblem(double deltaX) const;
+
+  /**
+   * @brief Set the initial state and factorize the matrices
+   *
+   */
+  void initialize(double deltaX, double c);
+
+  /**
+   * @brief Compute T(n+1) in temperaturesYX from T(n) in temperaturesYX
+   *
+   */
+  void step(double c);
+};
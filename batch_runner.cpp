@@ -0,0 +1,494 @@
+#include "batch_runner.h"
+#include "abstract_solver.h"
+#include "explicit_solver.h"
+#include "instrumentation.h"
+#include "result_cache.h"
+#include "result_file.h"
+#include "result_output.h"
+#include "solution_grid.h"
+#include "sweep_engine.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace {
+
+/**
+ * @brief Keys of a study, with the values read in the batch file and the line
+ * where each of them was read
+ */
+typedef std::map<std::string, std::pair<std::string, int>> Section;
+
+std::string trim(const std::string &text) {
+  std::size_t first = text.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return "";
+  }
+  std::size_t last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+std::vector<std::string> splitList(const std::string &text) {
+  std::vector<std::string> items;
+  std::stringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    item = trim(item);
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+std::invalid_argument invalidLine(const std::string &name, int line,
+                                  const std::string &message) {
+  return std::invalid_argument(name + ":" + std::to_string(line) + ": " +
+                               message);
+}
+
+double parseNumber(const std::string &name, int line,
+                   const std::string &text) {
+  char *end;
+  double value = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0') {
+    throw(invalidLine(name, line, "\"" + text + "\" is not a number"));
+  }
+  return value;
+}
+
+bool parseBoolean(const std::string &name, int line, const std::string &text) {
+  if (text == "true" || text == "yes" || text == "1") {
+    return true;
+  } else if (text == "false" || text == "no" || text == "0") {
+    return false;
+  }
+  throw(invalidLine(name, line, "\"" + text + "\" is not a boolean"));
+}
+
+/**
+ * @brief Build a study from its keys (the defaults included)
+ */
+BatchStudy makeStudy(const std::string &name, const std::string &studyName,
+                     int studyLine, const Section &keys) {
+  const char *required[] = {"diffusivity", "surface_temperature",
+                            "internal_temperature", "width", "time_limit",
+                            "delta_x", "delta_t", "schemes", "output"};
+  for (const char *key : required) {
+    if (keys.find(key) == keys.end()) {
+      throw(invalidLine(name, studyLine,
+                        "the study \"" + studyName + "\" has no " + key));
+    }
+  }
+  BatchStudy study;
+  study.name = studyName;
+  for (auto &entry : keys) {
+    const std::string &key = entry.first;
+    const std::string &value = entry.second.first;
+    int line = entry.second.second;
+    try {
+      if (key == "diffusivity") {
+        study.parameters.setDiffusivity(parseNumber(name, line, value));
+      } else if (key == "surface_temperature") {
+        study.parameters.setSurfaceTemperature(parseNumber(name, line, value));
+      } else if (key == "internal_temperature") {
+        study.parameters.setInternalTemperature(
+            parseNumber(name, line, value));
+      } else if (key == "width") {
+        study.parameters.setWidth(parseNumber(name, line, value));
+      } else if (key == "time_limit") {
+        study.parameters.setTimeLimit(parseNumber(name, line, value));
+      } else if (key == "delta_x") {
+        study.deltaX = parseNumber(name, line, value);
+      } else if (key == "delta_t") {
+        for (const std::string &item : splitList(value)) {
+          study.deltaTs.push_back(parseNumber(name, line, item));
+        }
+      } else if (key == "schemes") {
+        study.schemes = splitList(value);
+        for (const std::string &scheme : study.schemes) {
+          SweepEngine::createSolver(scheme);
+        }
+      } else if (key == "first_step") {
+        study.firstStepSchemeName = value;
+        SweepEngine::createSolver(value);
+      } else if (key == "first_step_extrapolation") {
+        study.firstStepWithRichardsonsExtrapolation =
+            parseBoolean(name, line, value);
+      } else if (key == "output") {
+        study.outputDirectory = value;
+      } else if (key == "format") {
+        if (value != "csv" && value != "binary") {
+          throw(std::invalid_argument("the format should be csv or binary"));
+        }
+        study.binaryOutput = value == "binary";
+      } else {
+        throw(std::invalid_argument("unknown key " + key));
+      }
+    } catch (const std::invalid_argument &error) {
+      std::string message = error.what();
+      // Errors of parseNumber already give the line
+      if (message.compare(0, name.size() + 1, name + ":") == 0) {
+        throw;
+      }
+      throw(invalidLine(name, line, message));
+    }
+  }
+  if (study.deltaX <= 0 || study.deltaTs.empty() || study.schemes.empty()) {
+    throw(invalidLine(name, studyLine,
+                      "the study \"" + studyName +
+                          "\" needs a positive delta_x, and at least one "
+                          "delta_t and one scheme"));
+  }
+  for (double deltaT : study.deltaTs) {
+    if (deltaT <= 0) {
+      throw(invalidLine(name, studyLine,
+                        "the time steps of \"" + studyName +
+                            "\" should be positive"));
+    }
+  }
+  return study;
+}
+
+/**
+ * @brief Solve of the graph of a batch, and the outputs still needing it
+ */
+struct SolveNode {
+  SweepJob job;
+  std::string configuration;
+  std::size_t estimatedBytes;
+  int remainingUses;
+  int numberOfUses;
+  bool resident;
+  SolutionGrid solution;
+  double seconds;
+};
+
+/**
+ * @brief File to write, from a numerical and an analytical solve
+ */
+struct OutputNode {
+  int study;
+  std::string path;
+  std::string schemeName;
+  int solve;
+  int reference;
+};
+
+/**
+ * @brief Key of a solve : the key of the result cache, which tells apart the
+ * solves giving different results
+ */
+std::string solveKey(const SweepJob &job, std::string *configuration) {
+  std::unique_ptr<AbstractSolver> solver =
+      SweepEngine::createSolver(job.schemeName);
+  std::unique_ptr<AbstractSolver> firstStepSolver =
+      SweepEngine::createSolver(job.firstStepSchemeName);
+  ExplicitSolver *explicitSolver =
+      dynamic_cast<ExplicitSolver *>(solver.get());
+  if (explicitSolver) {
+    (*explicitSolver)
+        .setFirstStepSolver(firstStepSolver.get(),
+                            job.firstStepWithRichardsonsExtrapolation);
+  }
+  *configuration = (*solver).getConfigurationName();
+  return ResultCache::keyOf(*solver, job.parameters, job.deltaX, job.deltaT);
+}
+
+std::size_t solutionBytes(const SolutionGrid &solution) {
+  return (std::size_t)solution.getNumberOfRows() * solution.getRowStride() *
+         sizeof(double);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+BatchFile readBatchFile(const std::string &filename) {
+  std::ifstream input(filename);
+  if (!input) {
+    throw(std::runtime_error("cannot open " + filename));
+  }
+  return parseBatchFile(input, filename);
+}
+
+BatchFile parseBatchFile(std::istream &input, const std::string &name) {
+  BatchFile batch;
+  Section defaults;
+  std::vector<std::pair<std::string, int>> studyNames;
+  std::vector<Section> studies;
+  // Section the next keys belong to : 0 batch, 1 defaults, 2 study, -1 none
+  int section = -1;
+  std::string text;
+  int line = 0;
+  while (std::getline(input, text)) {
+    line++;
+    std::size_t comment = text.find_first_of(";#");
+    text = trim(text.substr(0, comment));
+    if (text.empty()) {
+      continue;
+    }
+    if (text[0] == '[') {
+      if (text.back() != ']') {
+        throw(invalidLine(name, line, "a section should end with ]"));
+      }
+      std::string title = trim(text.substr(1, text.size() - 2));
+      if (title == "batch") {
+        section = 0;
+      } else if (title == "defaults") {
+        section = 1;
+      } else if (title.compare(0, 6, "study ") == 0 &&
+                 !trim(title.substr(6)).empty()) {
+        section = 2;
+        studyNames.push_back(std::make_pair(trim(title.substr(6)), line));
+        studies.push_back(Section());
+      } else {
+        throw(invalidLine(name, line, "unknown section [" + title + "]"));
+      }
+      continue;
+    }
+    std::size_t equal = text.find('=');
+    if (equal == std::string::npos) {
+      throw(invalidLine(name, line, "expected key = value"));
+    }
+    std::string key = trim(text.substr(0, equal));
+    std::string value = trim(text.substr(equal + 1));
+    if (section == 0) {
+      if (key == "threads") {
+        batch.settings.numberOfThreads = (int)parseNumber(name, line, value);
+      } else if (key == "memory_mb") {
+        batch.settings.maximumMemory =
+            (std::size_t)(parseNumber(name, line, value) * 1024 * 1024);
+      } else if (key == "summary") {
+        batch.settings.summaryFilename = value;
+      } else {
+        throw(invalidLine(name, line, "unknown key " + key));
+      }
+    } else if (section == 1) {
+      defaults[key] = std::make_pair(value, line);
+    } else if (section == 2) {
+      studies.back()[key] = std::make_pair(value, line);
+    } else {
+      throw(invalidLine(name, line, "a key should be in a section"));
+    }
+  }
+  for (std::size_t i = 0; i < studies.size(); i++) {
+    Section keys = defaults;
+    for (auto &entry : studies[i]) {
+      keys[entry.first] = entry.second;
+    }
+    batch.studies.push_back(
+        makeStudy(name, studyNames[i].first, studyNames[i].second, keys));
+  }
+  return batch;
+}
+
+void writeBatchSummary(std::ostream &output, const BatchSummary &summary) {
+  output << "total seconds:," << summary.seconds << "\n";
+  output << "requested solves:," << summary.numberOfRequestedSolves
+         << ",unique solves:," << summary.solves.size() << "\n";
+  output << "groups:," << summary.numberOfBatches << ",peak memory (bytes):,"
+         << summary.peakMemory << "\n\n";
+  output << "solve,deltaX,deltaT,seconds,uses\n";
+  for (const BatchSolveSummary &solve : summary.solves) {
+    output << "\"" << solve.configuration << "\"," << solve.deltaX << ","
+           << solve.deltaT << "," << solve.seconds << "," << solve.numberOfUses
+           << "\n";
+  }
+  output << "\nstudy,output,seconds\n";
+  for (const BatchOutputSummary &outputFile : summary.outputs) {
+    output << "\"" << outputFile.study << "\",\"" << outputFile.path << "\","
+           << outputFile.seconds << "\n";
+  }
+}
+
+BatchRunner::BatchRunner(const BatchSettings &psettings)
+    : settings(psettings){};
+
+void BatchRunner::createDirectories(const std::string &path) {
+  std::size_t position = 0;
+  while (position != std::string::npos) {
+    position = path.find('/', position + 1);
+    std::string directory = path.substr(0, position);
+    if (directory.empty()) {
+      continue;
+    }
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      throw(std::runtime_error("cannot create the directory " + directory));
+    }
+  }
+}
+
+BatchSummary BatchRunner::run(const std::vector<BatchStudy> &studies) {
+  HEAT_TIMED_SCOPE("batch.run");
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  BatchSummary summary;
+
+  // ===== Graph of the solves =====
+  std::vector<SolveNode> solves;
+  std::map<std::string, int> solveIndices;
+  auto addSolve = [&](const SweepJob &job) {
+    std::string configuration;
+    std::string key = solveKey(job, &configuration);
+    std::map<std::string, int>::iterator found = solveIndices.find(key);
+    if (found != solveIndices.end()) {
+      return (*found).second;
+    }
+    int rows = job.parameters.getNumberOfTimeSteps(job.deltaT);
+    int columns = job.parameters.getNumberOfSpacePoints(job.deltaX);
+    SolveNode node = {job, configuration, 0, 0, 0, false, SolutionGrid(), 0};
+    node.estimatedBytes = (std::size_t)rows * columns * sizeof(double);
+    solves.push_back(node);
+    solveIndices[key] = solves.size() - 1;
+    return (int)solves.size() - 1;
+  };
+
+  std::vector<OutputNode> outputs;
+  for (std::size_t s = 0; s < studies.size(); s++) {
+    const BatchStudy &study = studies[s];
+    for (const std::string &scheme : study.schemes) {
+      for (double deltaT : study.deltaTs) {
+        OutputNode output;
+        output.study = s;
+        output.schemeName = scheme;
+        output.path = study.outputDirectory + "/" + scheme;
+        if (study.deltaTs.size() > 1) {
+          output.path += " Deltat = " + std::to_string(deltaT);
+        }
+        output.path += study.binaryOutput ? ".bin" : ".csv";
+        output.solve = addSolve(SweepJob(
+            scheme, study.parameters, study.deltaX, deltaT,
+            study.firstStepSchemeName,
+            study.firstStepWithRichardsonsExtrapolation));
+        output.reference = addSolve(SweepJob("Analytical", study.parameters,
+                                             study.deltaX, deltaT));
+        solves[output.solve].numberOfUses++;
+        solves[output.reference].numberOfUses++;
+        outputs.push_back(output);
+        summary.numberOfRequestedSolves += 2;
+      }
+    }
+  }
+  // The outputs sharing a reference are run together so that it can be freed
+  // early
+  std::stable_sort(outputs.begin(), outputs.end(),
+                   [](const OutputNode &a, const OutputNode &b) {
+                     return a.reference < b.reference;
+                   });
+  for (SolveNode &node : solves) {
+    node.remainingUses = node.numberOfUses;
+  }
+  for (const BatchStudy &study : studies) {
+    createDirectories(study.outputDirectory);
+  }
+
+  // ===== Groups of outputs within the memory bound =====
+  SweepEngine sweepEngine(settings.numberOfThreads);
+  std::size_t residentBytes = 0;
+  std::size_t firstOutput = 0;
+  while (firstOutput < outputs.size()) {
+    std::vector<int> groupSolves;
+    std::size_t groupBytes = 0;
+    std::size_t endOutput = firstOutput;
+    while (endOutput < outputs.size()) {
+      const OutputNode &output = outputs[endOutput];
+      std::size_t extraBytes = 0;
+      std::vector<int> extraSolves;
+      for (int solve : {output.solve, output.reference}) {
+        if (!solves[solve].resident &&
+            std::find(groupSolves.begin(), groupSolves.end(), solve) ==
+                groupSolves.end() &&
+            std::find(extraSolves.begin(), extraSolves.end(), solve) ==
+                extraSolves.end()) {
+          extraSolves.push_back(solve);
+          extraBytes += solves[solve].estimatedBytes;
+        }
+      }
+      if (endOutput > firstOutput &&
+          residentBytes + groupBytes + extraBytes > settings.maximumMemory) {
+        break;
+      }
+      groupSolves.insert(groupSolves.end(), extraSolves.begin(),
+                         extraSolves.end());
+      groupBytes += extraBytes;
+      endOutput++;
+    }
+    summary.numberOfBatches++;
+
+    std::vector<SweepJob> jobs;
+    for (int solve : groupSolves) {
+      jobs.push_back(solves[solve].job);
+    }
+    std::vector<SweepResult> results = sweepEngine.run(jobs);
+    for (std::size_t i = 0; i < groupSolves.size(); i++) {
+      SolveNode &node = solves[groupSolves[i]];
+      node.solution = std::move(results[i].solution);
+      node.seconds = results[i].seconds;
+      node.resident = true;
+      residentBytes += solutionBytes(node.solution);
+    }
+    summary.peakMemory = std::max(summary.peakMemory, residentBytes);
+
+    // The outputs of the group only read the solutions : they are written in
+    // parallel
+    std::vector<double> outputSeconds(endOutput - firstOutput);
+    ThreadPool::shared().parallelFor(
+        firstOutput, endOutput, [&](int o) {
+          const OutputNode &output = outputs[o];
+          const BatchStudy &study = studies[output.study];
+          std::chrono::steady_clock::time_point outputStart =
+              std::chrono::steady_clock::now();
+          SolutionGrid &numerical = solves[output.solve].solution;
+          SolutionGrid &analytical = solves[output.reference].solution;
+          double deltaT = solves[output.solve].job.deltaT;
+          if (study.binaryOutput) {
+            writeResultFile(output.path, output.schemeName, numerical,
+                            &analytical, study.deltaX, deltaT);
+          } else {
+            resultToFile(output.path, &numerical, &analytical, study.deltaX,
+                         deltaT);
+          }
+          outputSeconds[o - firstOutput] = secondsSince(outputStart);
+        });
+
+    for (std::size_t o = firstOutput; o < endOutput; o++) {
+      const OutputNode &output = outputs[o];
+      BatchOutputSummary outputSummary = {studies[output.study].name,
+                                          output.path,
+                                          outputSeconds[o - firstOutput]};
+      summary.outputs.push_back(outputSummary);
+      for (int solve : {output.solve, output.reference}) {
+        SolveNode &node = solves[solve];
+        node.remainingUses--;
+        if (node.remainingUses == 0 && node.resident) {
+          residentBytes -= solutionBytes(node.solution);
+          node.solution = SolutionGrid();
+          node.resident = false;
+        }
+      }
+    }
+    firstOutput = endOutput;
+  }
+
+  for (const SolveNode &node : solves) {
+    BatchSolveSummary solveSummary = {node.configuration, node.job.deltaX,
+                                      node.job.deltaT, node.seconds,
+                                      node.numberOfUses};
+    summary.solves.push_back(solveSummary);
+  }
+  summary.seconds = secondsSince(start);
+  return summary;
+}
@@ -0,0 +1,237 @@
+#pragma once // Include guard
+#include "heat_diffusion_parameters.h"
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One study of a batch : a problem solved with several schemes and
+ * time steps on the same space step. Each solution is written with its errors
+ * compared to the analytical solution on the same grid, in
+ * outputDirectory/<scheme>.csv, or outputDirectory/<scheme> Deltat = <deltaT>
+ * .csv when the study has several time steps (.bin for binary result files),
+ * deltaT being written by std::to_string as in the main programm.
+ *
+ */
+struct BatchStudy {
+  std::string name;
+  HeatDiffusionParameters parameters;
+  double deltaX = 0;
+  std::vector<double> deltaTs;
+  /**
+   * @brief names of the schemes, as accepted by SweepEngine::createSolver
+   *
+   */
+  std::vector<std::string> schemes;
+  /**
+   * @brief first step of the three-level schemes (see SweepJob)
+   *
+   */
+  std::string firstStepSchemeName = "Laasonen";
+  bool firstStepWithRichardsonsExtrapolation = true;
+  std::string outputDirectory;
+  /**
+   * @brief whether the solutions are written in binary result files (see
+   * result_file.h) instead of CSV files
+   *
+   */
+  bool binaryOutput = false;
+};
+
+/**
+ * @brief Settings of a whole batch
+ *
+ */
+struct BatchSettings {
+  /**
+   * @brief Default bound on the memory used by the solutions : 1 GiB
+   *
+   */
+  static const std::size_t DEFAULT_MAXIMUM_MEMORY = (std::size_t)1 << 30;
+
+  /**
+   * @brief number of threads solving, 0 for one per hardware thread
+   *
+   */
+  int numberOfThreads = 0;
+  /**
+   * @brief bound in bytes on the solutions kept in memory at once. A single
+   * output needing more is still run, alone.
+   *
+   */
+  std::size_t maximumMemory = DEFAULT_MAXIMUM_MEMORY;
+  /**
+   * @brief file where the run summary is written
+   *
+   */
+  std::string summaryFilename = "batch_summary.csv";
+};
+
+/**
+ * @brief Content of a batch file
+ *
+ */
+struct BatchFile {
+  BatchSettings settings;
+  std::vector<BatchStudy> studies;
+};
+
+/**
+ * @brief Read a batch file, in the INI format :
+ *
+ *     ; comment
+ *     [batch]
+ *     threads = 4
+ *     memory_mb = 512
+ *     summary = Results/batch_summary.csv
+ *
+ *     [defaults]
+ *     diffusivity = 93
+ *     width = 31
+ *
+ *     [study full solutions]
+ *     surface_temperature = 149
+ *     internal_temperature = 38
+ *     time_limit = 0.5
+ *     delta_x = 0.05
+ *     delta_t = 0.01, 0.025
+ *     schemes = Laasonen, Crank-Nicholson, Dufort-Frankel
+ *     first_step = Laasonen
+ *     first_step_extrapolation = true
+ *     output = Results/full solutions
+ *     format = csv
+ *
+ * The keys of [defaults] apply to every study that does not set them. All
+ * the keys of a study but first_step, first_step_extrapolation and format
+ * are required; lists are separated by commas.
+ *
+ * Can throw a runtime_error exception if the file cannot be read, or an
+ * invalid_argument exception (giving the line) if it is not valid
+ *
+ * @param filename : name of the batch file
+ * @return BatchFile : settings and studies of the batch
+ */
+BatchFile readBatchFile(const std::string &filename);
+
+/**
+ * @brief Read a batch file from a stream (see readBatchFile)
+ *
+ * @param input : content of the batch file
+ * @param name : name of the batch file, for the error messages
+ */
+BatchFile parseBatchFile(std::istream &input, const std::string &name);
+
+/**
+ * @brief Solve of a batch run, shared by all the outputs needing it
+ *
+ */
+struct BatchSolveSummary {
+  /**
+   * @brief name of the scheme and of its settings (see
+   * AbstractSolver::getConfigurationName)
+   *
+   */
+  std::string configuration;
+  double deltaX;
+  double deltaT;
+  /**
+   * @brief time spent solving
+   *
+   */
+  double seconds;
+  /**
+   * @brief number of outputs using the solution, as numerical or as
+   * analytical solution
+   *
+   */
+  int numberOfUses;
+};
+
+/**
+ * @brief File written by a batch run
+ *
+ */
+struct BatchOutputSummary {
+  std::string study;
+  std::string path;
+  /**
+   * @brief time spent writing the file
+   *
+   */
+  double seconds;
+};
+
+/**
+ * @brief What a batch run did, and how long it took
+ *
+ */
+struct BatchSummary {
+  std::vector<BatchSolveSummary> solves;
+  std::vector<BatchOutputSummary> outputs;
+  /**
+   * @brief number of solves needed by the outputs before the shared ones are
+   * merged : a numerical and an analytical solve per output
+   *
+   */
+  int numberOfRequestedSolves = 0;
+  /**
+   * @brief number of groups of solves run at once to stay within the memory
+   * bound
+   *
+   */
+  int numberOfBatches = 0;
+  /**
+   * @brief largest memory used at once by the solutions, in bytes
+   *
+   */
+  std::size_t peakMemory = 0;
+  double seconds = 0;
+};
+
+/**
+ * @brief Write a summary as CSV : the totals, then one line per solve and per
+ * output
+ *
+ */
+void writeBatchSummary(std::ostream &output, const BatchSummary &summary);
+
+/**
+ * @brief Run the studies of a batch
+ *
+ * The outputs of all the studies are first turned into a graph of solves :
+ * each output depends on its numerical solve and on the analytical solve of
+ * its grid, and identical solves (same scheme and settings, problem and
+ * grid) are merged, across the studies too. The outputs are then run by
+ * groups : the solves of a group, which are not already in memory, are run in
+ * parallel by a SweepEngine, the outputs of the group are written in parallel,
+ * and the solutions needed by no remaining output are freed. A group takes
+ * outputs in order as long as the solutions it needs fit in the memory bound
+ * together with the ones kept from the previous groups.
+ */
+class BatchRunner {
+public:
+  explicit BatchRunner(const BatchSettings &settings);
+
+  /**
+   * @brief Run the studies, creating their output directories
+   *
+   * Can throw an invalid_argument exception if a study is not valid, or the
+   * exceptions of the solvers and of the outputs
+   *
+   * @param studies : studies to run
+   * @return BatchSummary : solves and outputs of the run with their timings
+   */
+  BatchSummary run(const std::vector<BatchStudy> &studies);
+
+  /**
+   * @brief Create a directory and its parents if they do not exist
+   *
+   * Can throw a runtime_error exception if a directory cannot be created
+   */
+  static void createDirectories(const std::string &path);
+
+private:
+  BatchSettings settings;
+};
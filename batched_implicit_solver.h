@@ -0,0 +1,169 @@
+#pragma once // Include guard
+#include "batched_thomas.h"
+#include "heat_diffusion_parameters.h"
+#include "solution_grid.h"
+#include "solver_engine.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief Solver of several independent heat conduction problems at once with
+ * an implicit scheme policy (scheme::Laasonen or scheme::CrankNicholson).
+ *
+ * The problems can have different diffusivities and temperatures but must
+ * share the same mesh : same number of space points and of time steps. Their
+ * tridiagonal systems are interleaved so that each time step is solved for all
+ * the problems with the vectorized kernels of batched_thomas.h. Each solution
+ * is bit-identical to the one of the corresponding single problem solver.
+ */
+template <class Scheme> class BatchedImplicitSolver {
+  static_assert(Scheme::isImplicit,
+                "BatchedImplicitSolver needs an implicit scheme");
+
+public:
+  /**
+   * @brief Set up the parameters of the problems to solve, one per system
+   *
+   * Can throw an invalid_argument exception if one of them is not
+   * initialized or if there is no problem
+   */
+  void setParameters(const std::vector<HeatDiffusionParameters> &parameterSets) {
+    if (parameterSets.empty()) {
+      throw(std::invalid_argument("at least one problem should be given"));
+    }
+    for (const HeatDiffusionParameters &problemParameters : parameterSets) {
+      if (!problemParameters.checkInitialization()) {
+        throw(std::invalid_argument(
+            "Parameters have not yet been properly initialized"));
+      }
+    }
+    parameters = parameterSets;
+  }
+
+  /**
+   * @brief Get the number of problems solved at once
+   *
+   */
+  int getNumberOfSystems() const { return (int)parameters.size(); }
+
+  /**
+   * @brief Solve all the problems on the same regular mesh
+   *
+   * Can throw an invalid_argument exception if the parameters are not set or
+   * if the problems do not lead to the same grid size
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param solutions : grids where the solutions are stored, in the order of
+   * the parameters
+   */
+  void solveRegularMeshes(double deltaX, double deltaT,
+                          std::vector<SolutionGrid> *solutions) {
+    if (parameters.empty()) {
+      throw(std::invalid_argument(
+          "Parameters have not yet been properly initialized"));
+    }
+    int K = getNumberOfSystems();
+    int numberOfSpacePoints = parameters[0].getNumberOfSpacePoints(deltaX);
+    int numberOfTimeSteps = parameters[0].getNumberOfTimeSteps(deltaT);
+    for (const HeatDiffusionParameters &problemParameters : parameters) {
+      if (problemParameters.getNumberOfSpacePoints(deltaX) !=
+              numberOfSpacePoints ||
+          problemParameters.getNumberOfTimeSteps(deltaT) != numberOfTimeSteps) {
+        throw(std::invalid_argument(
+            "all the problems of a batch should have the same grid size"));
+      }
+    }
+
+    int n = numberOfSpacePoints;
+    std::size_t batchSize = (std::size_t)n * K;
+    (*solutions).resize(K);
+    for (int k = 0; k < K; k++) {
+      (*solutions)[k].resize(numberOfTimeSteps, n);
+    }
+    couplings.resize(K);
+    lowerDiagonal.resize(batchSize);
+    mainDiagonal.resize(batchSize);
+    upperDiagonal.resize(batchSize);
+    pivots.resize(batchSize);
+    modifiedUpperDiagonal.resize(batchSize);
+    matrixB.resize(batchSize);
+    previousTimeStep.resize(batchSize);
+    currentTimeStep.resize(batchSize);
+
+    // Matrix A and initial state of each problem, interleaved
+    std::vector<double> lower(n), main(n), upper(n);
+    for (int k = 0; k < K; k++) {
+      couplings[k] = Scheme::coupling(parameters[k].getDiffusivity(), deltaT,
+                                      deltaX);
+      ImplicitKernels<Scheme>::fillDiagonals(couplings[k], n, lower.data(),
+                                             main.data(), upper.data());
+      double *TInitialState = (*solutions)[k].row(0);
+      std::fill(TInitialState, TInitialState + n,
+                parameters[k].getInternalTemperature());
+      TInitialState[0] = parameters[k].getSurfaceTemperature();
+      TInitialState[n - 1] = parameters[k].getSurfaceTemperature();
+      for (int i = 0; i < n; i++) {
+        lowerDiagonal[i * K + k] = lower[i];
+        mainDiagonal[i * K + k] = main[i];
+        upperDiagonal[i * K + k] = upper[i];
+        previousTimeStep[i * K + k] = TInitialState[i];
+      }
+    }
+    batched::factorize(n, K, lowerDiagonal.data(), mainDiagonal.data(),
+                       upperDiagonal.data(), pivots.data(),
+                       modifiedUpperDiagonal.data());
+
+    for (int timeIndex = 1; timeIndex < numberOfTimeSteps; timeIndex++) {
+      rightHandSide(previousTimeStep.data(), matrixB.data(), n, K, Scheme());
+      batched::solveFactorized(n, K, lowerDiagonal.data(), pivots.data(),
+                               modifiedUpperDiagonal.data(), matrixB.data(),
+                               currentTimeStep.data());
+      // Copying back to each solution by blocks of points, so that the
+      // interleaved values read stay in cache
+      for (int firstPoint = 0; firstPoint < n;
+           firstPoint += SCATTER_BLOCK_SIZE) {
+        int lastPoint = std::min(n, firstPoint + SCATTER_BLOCK_SIZE);
+        for (int k = 0; k < K; k++) {
+          double *TSolutionAtOneTime = (*solutions)[k].row(timeIndex);
+          for (int i = firstPoint; i < lastPoint; i++) {
+            TSolutionAtOneTime[i] = currentTimeStep[i * K + k];
+          }
+        }
+      }
+      std::swap(previousTimeStep, currentTimeStep);
+    }
+  }
+
+private:
+  /**
+   * @brief number of points copied back to each solution at once
+   *
+   */
+  static const int SCATTER_BLOCK_SIZE = 256;
+
+  std::vector<HeatDiffusionParameters> parameters;
+  /**
+   * @brief coupling coefficient of the scheme for each problem
+   *
+   */
+  std::vector<double> couplings;
+  /**
+   * @brief interleaved matrices, right hand sides and time steps : value i of
+   * problem k is at index i * K + k
+   *
+   */
+  std::vector<double> lowerDiagonal, mainDiagonal, upperDiagonal, pivots,
+      modifiedUpperDiagonal, matrixB, previousTimeStep, currentTimeStep;
+
+  void rightHandSide(const double *previous, double *B, int n, int K,
+                     scheme::Laasonen) const {
+    std::copy(previous, previous + (std::size_t)n * K, B);
+  }
+
+  void rightHandSide(const double *previous, double *B, int n, int K,
+                     scheme::CrankNicholson) const {
+    batched::crankNicholsonRightHandSide(previous, B, n, K, couplings.data());
+  }
+};
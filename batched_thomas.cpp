@@ -0,0 +1,384 @@
+#include "batched_thomas.h"
+#include "simd_dispatch.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// All the versions apply to each system the operations of the sequential
+// Thomas algorithm in the same order, without fused multiply-add, so that
+// they give bit-identical results.
+
+namespace batched {
+
+namespace {
+
+/**
+ * @brief Systems [firstSystem, K) of solveFactorized, without vector
+ * instructions. The K systems are still swept together, so that the
+ * divisions of different systems do not wait for each other.
+ *
+ */
+void solveFactorizedScalar(int size, int K, int firstSystem, const double *a,
+                           const double *pivot, const double *cPrime,
+                           double *B, double *X) {
+  for (int k = firstSystem; k < K; k++) {
+    B[k] = B[k] / pivot[k];
+  }
+  for (int i = 1; i < size; i++) {
+    for (int k = firstSystem; k < K; k++) {
+      int index = i * K + k;
+      B[index] = (B[index] - a[index] * B[index - K]) / pivot[index];
+    }
+  }
+  for (int k = firstSystem; k < K; k++) {
+    X[(size - 1) * K + k] = B[(size - 1) * K + k];
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    for (int k = firstSystem; k < K; k++) {
+      int index = i * K + k;
+      X[index] = B[index] - X[index + K] * cPrime[index];
+    }
+  }
+}
+
+void crankNicholsonRightHandSideScalar(const double *T, double *B, int size,
+                                       int K, int firstSystem,
+                                       const double *c) {
+  for (int i = 1; i < size - 1; i++) {
+    for (int k = firstSystem; k < K; k++) {
+      B[i * K + k] = (1 - (2 * c[k])) * T[i * K + k] + c[k] * T[(i + 1) * K + k] +
+                     c[k] * T[(i - 1) * K + k];
+    }
+  }
+}
+
+/**
+ * @brief Systems [firstSystem, numberOfSystems) of solveSharedFactorized,
+ * without vector instructions
+ *
+ */
+void solveSharedFactorizedScalar(int size, int numberOfSystems,
+                                 int firstSystem, std::ptrdiff_t stride,
+                                 const double *a, const double *pivot,
+                                 const double *cPrime, double *B) {
+  for (int k = firstSystem; k < numberOfSystems; k++) {
+    B[k] = B[k] / pivot[0];
+  }
+  for (int i = 1; i < size; i++) {
+    double *line = B + i * stride;
+    for (int k = firstSystem; k < numberOfSystems; k++) {
+      line[k] = (line[k] - a[i] * line[k - stride]) / pivot[i];
+    }
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    double *line = B + i * stride;
+    for (int k = firstSystem; k < numberOfSystems; k++) {
+      line[k] = line[k] - line[k + stride] * cPrime[i];
+    }
+  }
+}
+
+void crankNicholsonSharedRightHandSideScalar(const double *T, double *B,
+                                             int size, int numberOfSystems,
+                                             int firstSystem,
+                                             std::ptrdiff_t stride, double c) {
+  for (int i = 1; i < size - 1; i++) {
+    const double *line = T + i * stride;
+    double *result = B + i * stride;
+    for (int k = firstSystem; k < numberOfSystems; k++) {
+      result[k] = (1 - (2 * c)) * line[k] + c * line[k + stride] +
+                  c * line[k - stride];
+    }
+  }
+}
+
+#ifdef HEAT_SIMD_X86
+// The vectorized versions go through the rows one by one and handle all the
+// systems of a row before the next one : the systems are independent, so the
+// divisions of a row are not delayed by each other and the memory is read
+// contiguously. They return the first system left to the scalar version.
+
+__attribute__((target("avx2"))) int
+solveFactorizedAVX2(int size, int K, const double *a, const double *pivot,
+                    const double *cPrime, double *B, double *X) {
+  int vectorSystems = K - K % 4;
+  for (int k = 0; k < vectorSystems; k += 4) {
+    _mm256_storeu_pd(B + k, _mm256_div_pd(_mm256_loadu_pd(B + k),
+                                          _mm256_loadu_pd(pivot + k)));
+  }
+  for (int i = 1; i < size; i++) {
+    for (int k = 0; k < vectorSystems; k += 4) {
+      int index = i * K + k;
+      __m256d value = _mm256_div_pd(
+          _mm256_sub_pd(_mm256_loadu_pd(B + index),
+                        _mm256_mul_pd(_mm256_loadu_pd(a + index),
+                                      _mm256_loadu_pd(B + index - K))),
+          _mm256_loadu_pd(pivot + index));
+      _mm256_storeu_pd(B + index, value);
+    }
+  }
+  for (int k = 0; k < vectorSystems; k += 4) {
+    _mm256_storeu_pd(X + (size - 1) * K + k,
+                     _mm256_loadu_pd(B + (size - 1) * K + k));
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    for (int k = 0; k < vectorSystems; k += 4) {
+      int index = i * K + k;
+      __m256d value = _mm256_sub_pd(
+          _mm256_loadu_pd(B + index),
+          _mm256_mul_pd(_mm256_loadu_pd(X + index + K),
+                        _mm256_loadu_pd(cPrime + index)));
+      _mm256_storeu_pd(X + index, value);
+    }
+  }
+  return vectorSystems;
+}
+
+__attribute__((target("sse2"))) int
+solveFactorizedSSE2(int size, int K, const double *a, const double *pivot,
+                    const double *cPrime, double *B, double *X) {
+  int vectorSystems = K - K % 2;
+  for (int k = 0; k < vectorSystems; k += 2) {
+    _mm_storeu_pd(B + k,
+                  _mm_div_pd(_mm_loadu_pd(B + k), _mm_loadu_pd(pivot + k)));
+  }
+  for (int i = 1; i < size; i++) {
+    for (int k = 0; k < vectorSystems; k += 2) {
+      int index = i * K + k;
+      __m128d value = _mm_div_pd(
+          _mm_sub_pd(_mm_loadu_pd(B + index),
+                     _mm_mul_pd(_mm_loadu_pd(a + index),
+                                _mm_loadu_pd(B + index - K))),
+          _mm_loadu_pd(pivot + index));
+      _mm_storeu_pd(B + index, value);
+    }
+  }
+  for (int k = 0; k < vectorSystems; k += 2) {
+    _mm_storeu_pd(X + (size - 1) * K + k,
+                  _mm_loadu_pd(B + (size - 1) * K + k));
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    for (int k = 0; k < vectorSystems; k += 2) {
+      int index = i * K + k;
+      __m128d value =
+          _mm_sub_pd(_mm_loadu_pd(B + index),
+                     _mm_mul_pd(_mm_loadu_pd(X + index + K),
+                                _mm_loadu_pd(cPrime + index)));
+      _mm_storeu_pd(X + index, value);
+    }
+  }
+  return vectorSystems;
+}
+
+__attribute__((target("avx2"))) int
+crankNicholsonRightHandSideAVX2(const double *T, double *B, int size, int K,
+                                const double *c) {
+  const __m256d one = _mm256_set1_pd(1);
+  const __m256d two = _mm256_set1_pd(2);
+  int vectorSystems = K - K % 4;
+  for (int i = 1; i < size - 1; i++) {
+    for (int k = 0; k < vectorSystems; k += 4) {
+      int index = i * K + k;
+      __m256d vc = _mm256_loadu_pd(c + k);
+      __m256d centre = _mm256_sub_pd(one, _mm256_mul_pd(two, vc));
+      __m256d value = _mm256_add_pd(
+          _mm256_add_pd(_mm256_mul_pd(centre, _mm256_loadu_pd(T + index)),
+                        _mm256_mul_pd(vc, _mm256_loadu_pd(T + index + K))),
+          _mm256_mul_pd(vc, _mm256_loadu_pd(T + index - K)));
+      _mm256_storeu_pd(B + index, value);
+    }
+  }
+  return vectorSystems;
+}
+__attribute__((target("avx2"))) int
+solveSharedFactorizedAVX2(int size, int numberOfSystems, std::ptrdiff_t stride,
+                          const double *a, const double *pivot,
+                          const double *cPrime, double *B) {
+  int vectorSystems = numberOfSystems - numberOfSystems % 4;
+  __m256d vpivot = _mm256_set1_pd(pivot[0]);
+  for (int k = 0; k < vectorSystems; k += 4) {
+    _mm256_storeu_pd(B + k, _mm256_div_pd(_mm256_loadu_pd(B + k), vpivot));
+  }
+  for (int i = 1; i < size; i++) {
+    double *line = B + i * stride;
+    __m256d va = _mm256_set1_pd(a[i]);
+    vpivot = _mm256_set1_pd(pivot[i]);
+    for (int k = 0; k < vectorSystems; k += 4) {
+      __m256d value = _mm256_div_pd(
+          _mm256_sub_pd(_mm256_loadu_pd(line + k),
+                        _mm256_mul_pd(va, _mm256_loadu_pd(line + k - stride))),
+          vpivot);
+      _mm256_storeu_pd(line + k, value);
+    }
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    double *line = B + i * stride;
+    __m256d vcPrime = _mm256_set1_pd(cPrime[i]);
+    for (int k = 0; k < vectorSystems; k += 4) {
+      __m256d value = _mm256_sub_pd(
+          _mm256_loadu_pd(line + k),
+          _mm256_mul_pd(_mm256_loadu_pd(line + k + stride), vcPrime));
+      _mm256_storeu_pd(line + k, value);
+    }
+  }
+  return vectorSystems;
+}
+
+__attribute__((target("sse2"))) int
+solveSharedFactorizedSSE2(int size, int numberOfSystems, std::ptrdiff_t stride,
+                          const double *a, const double *pivot,
+                          const double *cPrime, double *B) {
+  int vectorSystems = numberOfSystems - numberOfSystems % 2;
+  __m128d vpivot = _mm_set1_pd(pivot[0]);
+  for (int k = 0; k < vectorSystems; k += 2) {
+    _mm_storeu_pd(B + k, _mm_div_pd(_mm_loadu_pd(B + k), vpivot));
+  }
+  for (int i = 1; i < size; i++) {
+    double *line = B + i * stride;
+    __m128d va = _mm_set1_pd(a[i]);
+    vpivot = _mm_set1_pd(pivot[i]);
+    for (int k = 0; k < vectorSystems; k += 2) {
+      __m128d value = _mm_div_pd(
+          _mm_sub_pd(_mm_loadu_pd(line + k),
+                     _mm_mul_pd(va, _mm_loadu_pd(line + k - stride))),
+          vpivot);
+      _mm_storeu_pd(line + k, value);
+    }
+  }
+  for (int i = size - 2; i >= 0; i--) {
+    double *line = B + i * stride;
+    __m128d vcPrime = _mm_set1_pd(cPrime[i]);
+    for (int k = 0; k < vectorSystems; k += 2) {
+      __m128d value =
+          _mm_sub_pd(_mm_loadu_pd(line + k),
+                     _mm_mul_pd(_mm_loadu_pd(line + k + stride), vcPrime));
+      _mm_storeu_pd(line + k, value);
+    }
+  }
+  return vectorSystems;
+}
+
+__attribute__((target("avx2"))) int
+crankNicholsonSharedRightHandSideAVX2(const double *T, double *B, int size,
+                                      int numberOfSystems,
+                                      std::ptrdiff_t stride, double c) {
+  const __m256d vc = _mm256_set1_pd(c);
+  const __m256d centre = _mm256_set1_pd(1 - (2 * c));
+  int vectorSystems = numberOfSystems - numberOfSystems % 4;
+  for (int i = 1; i < size - 1; i++) {
+    const double *line = T + i * stride;
+    double *result = B + i * stride;
+    for (int k = 0; k < vectorSystems; k += 4) {
+      __m256d value = _mm256_add_pd(
+          _mm256_add_pd(_mm256_mul_pd(centre, _mm256_loadu_pd(line + k)),
+                        _mm256_mul_pd(vc, _mm256_loadu_pd(line + k + stride))),
+          _mm256_mul_pd(vc, _mm256_loadu_pd(line + k - stride)));
+      _mm256_storeu_pd(result + k, value);
+    }
+  }
+  return vectorSystems;
+}
+#endif
+
+} // namespace
+
+void factorize(int size, int K, const double *lowerDiagonal,
+               const double *mainDiagonal, const double *upperDiagonal,
+               double *pivots, double *modifiedUpperDiagonal) {
+  // Done once per matrix, the scalar version is enough
+  for (int k = 0; k < K; k++) {
+    pivots[k] = mainDiagonal[k];
+    modifiedUpperDiagonal[k] = upperDiagonal[k] / pivots[k];
+  }
+  for (int i = 1; i < size; i++) {
+    for (int k = 0; k < K; k++) {
+      int index = i * K + k;
+      pivots[index] = mainDiagonal[index] -
+                      lowerDiagonal[index] * modifiedUpperDiagonal[index - K];
+      modifiedUpperDiagonal[index] = upperDiagonal[index] / pivots[index];
+    }
+  }
+}
+
+void solveFactorized(int size, int K, const double *lowerDiagonal,
+                     const double *pivots, const double *modifiedUpperDiagonal,
+                     double *B, double *X) {
+  int firstScalarSystem = 0;
+  switch (simd::activeInstructionSet()) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    firstScalarSystem = solveFactorizedAVX2(size, K, lowerDiagonal, pivots,
+                                            modifiedUpperDiagonal, B, X);
+    break;
+  case simd::SSE2:
+    firstScalarSystem = solveFactorizedSSE2(size, K, lowerDiagonal, pivots,
+                                            modifiedUpperDiagonal, B, X);
+    break;
+#endif
+  default:
+    break;
+  }
+  solveFactorizedScalar(size, K, firstScalarSystem, lowerDiagonal, pivots,
+                        modifiedUpperDiagonal, B, X);
+}
+
+void crankNicholsonRightHandSide(const double *previousTimeStep, double *B,
+                                 int size, int K, const double *c) {
+  // Both surfaces
+  std::copy(previousTimeStep, previousTimeStep + K, B);
+  std::copy(previousTimeStep + (size - 1) * K, previousTimeStep + size * K,
+            B + (size - 1) * K);
+  int firstScalarSystem = 0;
+#ifdef HEAT_SIMD_X86
+  if (simd::activeInstructionSet() == simd::AVX2) {
+    firstScalarSystem =
+        crankNicholsonRightHandSideAVX2(previousTimeStep, B, size, K, c);
+  }
+#endif
+  crankNicholsonRightHandSideScalar(previousTimeStep, B, size, K,
+                                    firstScalarSystem, c);
+}
+
+void solveSharedFactorized(int size, int numberOfSystems,
+                           std::ptrdiff_t stride, const double *lowerDiagonal,
+                           const double *pivots,
+                           const double *modifiedUpperDiagonal, double *B) {
+  int firstScalarSystem = 0;
+  switch (simd::activeInstructionSet()) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    firstScalarSystem =
+        solveSharedFactorizedAVX2(size, numberOfSystems, stride, lowerDiagonal,
+                                  pivots, modifiedUpperDiagonal, B);
+    break;
+  case simd::SSE2:
+    firstScalarSystem =
+        solveSharedFactorizedSSE2(size, numberOfSystems, stride, lowerDiagonal,
+                                  pivots, modifiedUpperDiagonal, B);
+    break;
+#endif
+  default:
+    break;
+  }
+  solveSharedFactorizedScalar(size, numberOfSystems, firstScalarSystem, stride,
+                              lowerDiagonal, pivots, modifiedUpperDiagonal, B);
+}
+
+void crankNicholsonSharedRightHandSide(const double *T, double *B, int size,
+                                       int numberOfSystems,
+                                       std::ptrdiff_t stride, double c) {
+  int firstScalarSystem = 0;
+#ifdef HEAT_SIMD_X86
+  if (simd::activeInstructionSet() == simd::AVX2) {
+    firstScalarSystem = crankNicholsonSharedRightHandSideAVX2(
+        T, B, size, numberOfSystems, stride, c);
+  }
+#endif
+  crankNicholsonSharedRightHandSideScalar(T, B, size, numberOfSystems,
+                                          firstScalarSystem, stride, c);
+}
+
+} // namespace batched
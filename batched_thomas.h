@@ -0,0 +1,83 @@
+#pragma once // Include guard
+#include <cstddef>
+
+/**
+ * @brief Kernels solving K independent tridiagonal systems of the same size
+ * at once. The systems are interleaved : value i of system k is stored at
+ * index i * K + k, so that the K systems fill the lanes of the vector
+ * registers. The vectorized version used is chosen at runtime (see
+ * simd_dispatch.h); each system gets bit-identical results to the sequential
+ * Thomas algorithm.
+ *
+ */
+namespace batched {
+
+/**
+ * @brief Forward elimination applied to A only for each system : compute the
+ * pivots and the modified super-diagonals
+ *
+ * @param size : number of unknowns of each system
+ * @param numberOfSystems : number of systems K
+ */
+void factorize(int size, int numberOfSystems, const double *lowerDiagonal,
+               const double *mainDiagonal, const double *upperDiagonal,
+               double *pivots, double *modifiedUpperDiagonal);
+
+/**
+ * @brief Forward elimination on B and backward substitution for each
+ * system, once A has been factorized. B is overwritten.
+ *
+ * @param size : number of unknowns of each system
+ * @param numberOfSystems : number of systems K
+ */
+void solveFactorized(int size, int numberOfSystems, const double *lowerDiagonal,
+                     const double *pivots, const double *modifiedUpperDiagonal,
+                     double *B, double *X);
+
+/**
+ * @brief Right hand side of the Crank-Nicholson scheme for each system :
+ * B(i) = (1 - 2c) T(i) + c T(i+1) + c T(i-1) inside the wall and B(i) = T(i)
+ * on both surfaces
+ *
+ * @param previousTimeStep : interleaved temperatures at the previous time step
+ * @param B : interleaved right hand sides
+ * @param size : number of space points of each system
+ * @param numberOfSystems : number of systems K
+ * @param c : coefficient c of each system
+ */
+void crankNicholsonRightHandSide(const double *previousTimeStep, double *B,
+                                 int size, int numberOfSystems,
+                                 const double *c);
+
+/**
+ * @brief Forward elimination on B and backward substitution for systems
+ * sharing the same matrix A, factorized once by factorizeTridiagonal (see
+ * solver_engine.h). Value i of system k is B[i * stride + k] : with the row
+ * stride of a grid, the systems are consecutive columns of the grid. B is
+ * overwritten by the solutions.
+ *
+ * @param size : number of unknowns of each system
+ * @param numberOfSystems : number of systems, at most stride
+ * @param stride : distance (in doubles) between two unknowns of a system
+ */
+void solveSharedFactorized(int size, int numberOfSystems,
+                           std::ptrdiff_t stride, const double *lowerDiagonal,
+                           const double *pivots,
+                           const double *modifiedUpperDiagonal, double *B);
+
+/**
+ * @brief Explicit part of a Crank-Nicholson step with the same coefficient c
+ * for all the systems, in the layout of solveSharedFactorized :
+ * B(i) = (1 - 2c) T(i) + c T(i+1) + c T(i-1) for 0 < i < size - 1. The first
+ * and last values of each system are not written.
+ *
+ * @param size : number of values of each system
+ * @param numberOfSystems : number of systems, at most stride
+ * @param stride : distance (in doubles) between two values of a system, in
+ * T and in B
+ */
+void crankNicholsonSharedRightHandSide(const double *T, double *B, int size,
+                                       int numberOfSystems,
+                                       std::ptrdiff_t stride, double c);
+
+} // namespace batched
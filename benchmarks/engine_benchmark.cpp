@@ -0,0 +1,326 @@
+/*! \file */
+
+#include "abstract_solver.h"
+#include "batched_implicit_solver.h"
+#include "crank-nicholson_solver.h"
+#include "dufort-frankel_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "laasonen_simple_implicit_solver.h"
+#include "multigrid_implicit_solver.h"
+#include "richardson_solver.h"
+#include "solution_grid.h"
+#include "simd_dispatch.h"
+#include "solver_engine.h"
+#include "superposition_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Time in seconds of the fastest of numberOfRuns calls to solve
+ *
+ */
+template <class Solve> double bestTime(int numberOfRuns, Solve solve) {
+  double best = 1e300;
+  for (int run = 0; run < numberOfRuns; run++) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    solve();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+/**
+ * @brief Check that two solutions are bit-identical
+ *
+ */
+bool identical(const SolutionGrid &a, const SolutionGrid &b) {
+  if (a.getNumberOfRows() != b.getNumberOfRows() ||
+      a.getNumberOfColumns() != b.getNumberOfColumns()) {
+    return false;
+  }
+  for (int i = 0; i < a.getNumberOfRows(); i++) {
+    if (std::memcmp(a.row(i), b.row(i),
+                    a.getNumberOfColumns() * sizeof(double)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Solve the same problem with the polymorphic solver and with
+ * SolverEngine<Scheme> and print the time per point and per step of both. The
+ * polymorphic solver is an adapter over SolverEngine<Scheme> : the difference
+ * is the cost of the adapter.
+ *
+ */
+template <class Scheme>
+void compare(AbstractSolver *solver, HeatDiffusionParameters parameters,
+             double deltaX, double deltaT) {
+  const int numberOfRuns = 5;
+  SolutionGrid polymorphicSolution, templateSolution;
+  solver->setParameters(parameters);
+  SolverEngine<Scheme> engine;
+  engine.setParameters(parameters);
+
+  double polymorphicTime = bestTime(numberOfRuns, [&]() {
+    solver->solveRegularMeshes(deltaX, deltaT, &polymorphicSolution);
+  });
+  double templateTime = bestTime(numberOfRuns, [&]() {
+    engine.solveRegularMeshes(deltaX, deltaT, &templateSolution);
+  });
+
+  double pointSteps = (double)polymorphicSolution.getNumberOfRows() *
+                      polymorphicSolution.getNumberOfColumns();
+  std::cout << std::setw(16) << Scheme::name() << std::setw(10)
+            << polymorphicSolution.getNumberOfColumns() << std::setw(8)
+            << polymorphicSolution.getNumberOfRows() << std::setw(16)
+            << polymorphicTime / pointSteps * 1e9 << std::setw(16)
+            << templateTime / pointSteps * 1e9 << std::setw(10)
+            << polymorphicTime / templateTime << std::setw(12)
+            << (identical(polymorphicSolution, templateSolution) ? "yes" : "NO")
+            << std::endl;
+}
+
+/**
+ * @brief Solve numberOfSystems problems with different diffusivities by
+ * looping over the polymorphic solver and with BatchedImplicitSolver<Scheme>,
+ * and print the time per point and per step of both
+ *
+ */
+template <class Scheme>
+void compareBatched(AbstractSolver *solver, HeatDiffusionParameters parameters,
+                    int numberOfSystems, double deltaX, double deltaT) {
+  const int numberOfRuns = 5;
+  std::vector<HeatDiffusionParameters> parameterSets;
+  for (int k = 0; k < numberOfSystems; k++) {
+    parameters.setDiffusivity(93 + k);
+    parameterSets.push_back(parameters);
+  }
+  std::vector<SolutionGrid> loopSolutions(numberOfSystems), batchedSolutions;
+  BatchedImplicitSolver<Scheme> batchedSolver;
+  batchedSolver.setParameters(parameterSets);
+
+  double loopTime = bestTime(numberOfRuns, [&]() {
+    for (int k = 0; k < numberOfSystems; k++) {
+      solver->setParameters(parameterSets[k]);
+      solver->solveRegularMeshes(deltaX, deltaT, &loopSolutions[k]);
+    }
+  });
+  double batchedTime = bestTime(numberOfRuns, [&]() {
+    batchedSolver.solveRegularMeshes(deltaX, deltaT, &batchedSolutions);
+  });
+
+  bool allIdentical = true;
+  for (int k = 0; k < numberOfSystems; k++) {
+    allIdentical =
+        allIdentical && identical(loopSolutions[k], batchedSolutions[k]);
+  }
+  double pointSteps = (double)numberOfSystems *
+                      loopSolutions[0].getNumberOfRows() *
+                      loopSolutions[0].getNumberOfColumns();
+  std::cout << std::setw(16) << Scheme::name() << std::setw(10)
+            << loopSolutions[0].getNumberOfColumns() << std::setw(8)
+            << numberOfSystems << std::setw(16)
+            << loopTime / pointSteps * 1e9 << std::setw(16)
+            << batchedTime / pointSteps * 1e9 << std::setw(10)
+            << loopTime / batchedTime << std::setw(12)
+            << (allIdentical ? "yes" : "NO") << std::endl;
+}
+
+/**
+ * @brief Solve numberOfVariants problems with different temperatures by
+ * looping over the solver and with a SuperpositionCache, and print the time
+ * per point and per step of both and the largest difference between them
+ *
+ */
+void compareSuperposition(AbstractSolver *solver,
+                          HeatDiffusionParameters parameters,
+                          int numberOfVariants, double deltaX, double deltaT) {
+  const int numberOfRuns = 3;
+  std::vector<HeatDiffusionParameters> parameterSets;
+  for (int k = 0; k < numberOfVariants; k++) {
+    parameters.setSurfaceTemperature(100 + k);
+    parameters.setInternalTemperature(38 - 0.5 * k);
+    parameterSets.push_back(parameters);
+  }
+  std::vector<SolutionGrid> loopSolutions(numberOfVariants),
+      superpositionSolutions(numberOfVariants);
+
+  double loopTime = bestTime(numberOfRuns, [&]() {
+    for (int k = 0; k < numberOfVariants; k++) {
+      solver->setParameters(parameterSets[k]);
+      solver->solveRegularMeshes(deltaX, deltaT, &loopSolutions[k]);
+    }
+  });
+  // Includes the normalized solve
+  double superpositionTime = bestTime(numberOfRuns, [&]() {
+    SuperpositionCache cache;
+    for (int k = 0; k < numberOfVariants; k++) {
+      cache.solve(solver, parameterSets[k], deltaX, deltaT,
+                  &superpositionSolutions[k]);
+    }
+  });
+
+  double largestDifference = 0;
+  for (int k = 0; k < numberOfVariants; k++) {
+    for (int i = 0; i < loopSolutions[k].getNumberOfRows(); i++) {
+      for (int j = 0; j < loopSolutions[k].getNumberOfColumns(); j++) {
+        double difference =
+            loopSolutions[k](i, j) - superpositionSolutions[k](i, j);
+        largestDifference = std::max(largestDifference, std::fabs(difference));
+      }
+    }
+  }
+  double pointSteps = (double)numberOfVariants *
+                      loopSolutions[0].getNumberOfRows() *
+                      loopSolutions[0].getNumberOfColumns();
+  std::cout << std::setw(16) << solver->getSchemeName() << std::setw(10)
+            << loopSolutions[0].getNumberOfColumns() << std::setw(10)
+            << numberOfVariants << std::setw(16)
+            << loopTime / pointSteps * 1e9 << std::setw(16)
+            << superpositionTime / pointSteps * 1e9 << std::setw(10)
+            << loopTime / superpositionTime << std::setw(14)
+            << std::scientific << largestDifference << std::fixed
+            << std::endl;
+}
+
+/**
+ * @brief Solve a problem on a rectangle (depth 0) or a box with a multigrid
+ * implicit solver, and print the number of V-cycles per time step, the time
+ * per point and per step and the largest error at the last time step. With
+ * deltaT scaled with deltaX^2, the cycles per step and the time per point
+ * should not grow with the number of points.
+ *
+ */
+template <class Scheme>
+void measureMultigrid(const HeatDiffusionParameters &parameters, double height,
+                      double depth, double deltaX, double deltaT) {
+  MultigridImplicitSolver<Scheme> solver;
+  solver.setParameters(parameters, height, depth);
+  SolutionGrid solution, analyticalSolution;
+  double time = bestTime(1, [&]() { solver.solve(deltaX, deltaT, &solution); });
+  int numberOfSteps = parameters.getNumberOfTimeSteps(deltaT) - 1;
+  solver.exactSolution(deltaX, numberOfSteps * deltaT, &analyticalSolution);
+  double largestError = 0;
+  for (int i = 0; i < solution.getNumberOfRows(); i++) {
+    for (int j = 0; j < solution.getNumberOfColumns(); j++) {
+      largestError = std::max(
+          largestError, std::fabs(solution(i, j) - analyticalSolution(i, j)));
+    }
+  }
+  double points =
+      (double)solution.getNumberOfRows() * solution.getNumberOfColumns();
+  std::cout << std::setw(16) << Scheme::name() << std::setw(6)
+            << (depth > 0 ? "3D" : "2D") << std::setw(10) << (long)points
+            << std::setw(8) << solver.getNumberOfLevels() << std::setw(14)
+            << (double)solver.getNumberOfCycles() / numberOfSteps
+            << std::setw(14) << time / (points * numberOfSteps) * 1e9
+            << std::setw(14) << std::scientific << largestError << std::fixed
+            << std::endl;
+}
+
+/**
+ * @brief Compare the polymorphic solvers (AbstractSolver classes) with the
+ * solvers specialised at compile time (SolverEngine) on several grids
+ *
+ */
+int main() {
+  HeatDiffusionParameters parameters = HeatDiffusionParameters();
+  parameters.setDiffusivity(93);
+  parameters.setSurfaceTemperature(149);
+  parameters.setInternalTemperature(38);
+  parameters.setWidth(31);
+  parameters.setTimeLimit(0.5);
+
+  LaasonenSolver laasonenSolver;
+  CrankNicholsonSolver crankNicholsonSolver;
+  RichardsonSolver richardsonSolver;
+  DufortFrankelSolver dufortFrankelSolver;
+  // Every repetition computes its first steps, as the template loop does
+  richardsonSolver.setFirstStepCache(nullptr);
+  dufortFrankelSolver.setFirstStepCache(nullptr);
+
+  std::cout << std::setprecision(3) << std::fixed;
+  std::cout << std::setw(16) << "scheme" << std::setw(10) << "points"
+            << std::setw(8) << "steps" << std::setw(16) << "virtual ns/pt"
+            << std::setw(16) << "template ns/pt" << std::setw(10) << "speedup"
+            << std::setw(12) << "identical" << std::endl;
+
+  double deltaT = 0.01;
+  double deltaXs[3] = {0.05, 0.005, 0.0005};
+  for (double deltaX : deltaXs) {
+    compare<scheme::Laasonen>(&laasonenSolver, parameters, deltaX, deltaT);
+    compare<scheme::CrankNicholson>(&crankNicholsonSolver, parameters, deltaX,
+                                    deltaT);
+    compare<scheme::Richardson>(&richardsonSolver, parameters, deltaX, deltaT);
+    compare<scheme::DufortFrankel>(&dufortFrankelSolver, parameters, deltaX,
+                                   deltaT);
+  }
+
+  std::cout << std::endl
+            << "batched implicit solvers ("
+            << simd::instructionSetName(simd::activeInstructionSet()) << ")"
+            << std::endl;
+  std::cout << std::setw(16) << "scheme" << std::setw(10) << "points"
+            << std::setw(8) << "systems" << std::setw(16) << "loop ns/pt"
+            << std::setw(16) << "batched ns/pt" << std::setw(10) << "speedup"
+            << std::setw(12) << "identical" << std::endl;
+  int numbersOfSystems[3] = {4, 8, 32};
+  for (int numberOfSystems : numbersOfSystems) {
+    compareBatched<scheme::Laasonen>(&laasonenSolver, parameters,
+                                     numberOfSystems, 0.005, deltaT);
+    compareBatched<scheme::CrankNicholson>(&crankNicholsonSolver, parameters,
+                                           numberOfSystems, 0.005, deltaT);
+  }
+
+  std::cout << std::endl << "temperature sweeps" << std::endl;
+  std::cout << std::setw(16) << "scheme" << std::setw(10) << "points"
+            << std::setw(10) << "variants" << std::setw(16) << "loop ns/pt"
+            << std::setw(16) << "rescaled ns/pt" << std::setw(10) << "speedup"
+            << std::setw(14) << "difference" << std::endl;
+  int numbersOfVariants[2] = {16, 256};
+  for (int numberOfVariants : numbersOfVariants) {
+    compareSuperposition(&laasonenSolver, parameters, numberOfVariants, 0.05,
+                         deltaT);
+    compareSuperposition(&crankNicholsonSolver, parameters, numberOfVariants,
+                         0.05, deltaT);
+    compareSuperposition(&dufortFrankelSolver, parameters, numberOfVariants,
+                         0.05, deltaT);
+  }
+
+  std::cout << std::endl << "multigrid implicit steps" << std::endl;
+  std::cout << std::setw(16) << "scheme" << std::setw(6) << "box"
+            << std::setw(10) << "points" << std::setw(8) << "levels"
+            << std::setw(14) << "cycles/step" << std::setw(14) << "ns/pt/step"
+            << std::setw(14) << "error" << std::endl;
+  // Numbers of intervals multiple of powers of 2. deltaT is divided by 4
+  // when deltaX is halved, so that D * deltaT / deltaX^2, which sets how hard
+  // a step is to solve, stays the same on every grid
+  HeatDiffusionParameters boxParameters = parameters;
+  boxParameters.setWidth(32);
+  boxParameters.setTimeLimit(0.05);
+  double boxDeltaT = 0.001;
+  double boxDeltaXs[3] = {0.25, 0.125, 0.0625};
+  for (double deltaX : boxDeltaXs) {
+    double deltaT = boxDeltaT * std::pow(deltaX / boxDeltaXs[0], 2);
+    measureMultigrid<scheme::Laasonen>(boxParameters, 16, 0, deltaX, deltaT);
+    measureMultigrid<scheme::CrankNicholson>(boxParameters, 16, 0, deltaX,
+                                             deltaT);
+  }
+  double boxDeltaXs3D[3] = {1, 0.5, 0.25};
+  for (double deltaX : boxDeltaXs3D) {
+    double deltaT = boxDeltaT * std::pow(deltaX / boxDeltaXs3D[0], 2);
+    measureMultigrid<scheme::CrankNicholson>(boxParameters, 16, 8, deltaX,
+                                             deltaT);
+  }
+}
@@ -0,0 +1,424 @@
+/*! \file */
+
+#include "abstract_solver.h"
+#include "error_accumulator.h"
+#include "heat_diffusion_parameters.h"
+#include "instrumentation.h"
+#include "norms.h"
+#include "result_output.h"
+#include "simd_dispatch.h"
+#include "solution_grid.h"
+#include "solver_engine.h"
+#include "sweep_engine.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*=========== ALLOCATION COUNTING ===============*/
+
+#ifdef HEAT_INSTRUMENTATION
+// operator new is already replaced by instrumentation.cpp, which counts the
+// allocations
+long allocationCount() { return instrumentation::numberOfAllocations(); }
+long allocatedBytes() { return instrumentation::bytesAllocated(); }
+#else
+namespace {
+std::atomic<long> numberOfAllocations(0);
+std::atomic<long> bytesAllocated(0);
+} // namespace
+
+long allocationCount() { return numberOfAllocations.load(); }
+long allocatedBytes() { return bytesAllocated.load(); }
+
+// Every allocation of the programm goes through these operators, so that the
+// allocations made by a kernel can be counted
+void *operator new(std::size_t size) {
+  numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+  bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+  void *allocation = std::malloc(size ? size : 1);
+  if (!allocation) {
+    throw std::bad_alloc();
+  }
+  return allocation;
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+// The memory freed here comes from the malloc of operator new above, but
+// GCC inlines these operators where the pointer is returned by a new
+// expression and then warns about a mismatched free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *allocation) noexcept { std::free(allocation); }
+
+void operator delete[](void *allocation) noexcept { std::free(allocation); }
+
+void operator delete(void *allocation, std::size_t) noexcept {
+  std::free(allocation);
+}
+
+void operator delete[](void *allocation, std::size_t) noexcept {
+  std::free(allocation);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+/*=========== MEASUREMENTS ===============*/
+
+/**
+ * @brief Result of one kernel on one size
+ *
+ */
+struct Measurement {
+  std::string kernel;
+  long points;
+  long steps;
+  double nanosecondsPerPointStep;
+  double bytesPerPoint;
+  long allocations;
+};
+
+/**
+ * @brief Minimal time in seconds spent on each kernel and size
+ *
+ */
+const double MINIMUM_TIME = 0.2;
+const int MAXIMUM_RUNS = 50;
+
+/**
+ * @brief Number of point-steps aimed at by one run of a kernel
+ *
+ */
+const long TARGET_POINT_STEPS = 10000000;
+
+/**
+ * @brief Call run until MINIMUM_TIME is spent and keep the fastest run.
+ * run() computes points values steps times and returns the number of
+ * point-steps done. The allocations are the ones of the first run.
+ *
+ */
+Measurement measure(const std::string &kernel, long points, long steps,
+                    const std::function<long()> &run) {
+  Measurement measurement = {kernel, points, steps, 0, 0, 0};
+  double best = 1e300, total = 0;
+  long pointSteps = 0;
+  for (int i = 0; i < MAXIMUM_RUNS && (i == 0 || total < MINIMUM_TIME); i++) {
+    long allocationsBefore = allocationCount();
+    long bytesBefore = allocatedBytes();
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    pointSteps = run();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (i == 0) {
+      measurement.allocations = allocationCount() - allocationsBefore;
+      measurement.bytesPerPoint =
+          (double)(allocatedBytes() - bytesBefore) / points;
+    }
+    best = std::min(best, elapsed.count());
+    total += elapsed.count();
+  }
+  measurement.nanosecondsPerPointStep = best / pointSteps * 1e9;
+  return measurement;
+}
+
+/**
+ * @brief Problem of the assignment, with a time step small enough for the
+ * explicit schemes to stay stable at any size
+ *
+ */
+HeatDiffusionParameters benchmarkParameters(long points, long steps,
+                                            double *deltaX, double *deltaT) {
+  HeatDiffusionParameters parameters;
+  parameters.setDiffusivity(93);
+  parameters.setSurfaceTemperature(149);
+  parameters.setInternalTemperature(38);
+  parameters.setWidth(31);
+  *deltaX = 31. / (points - 1);
+  *deltaT = 0.25 * (*deltaX) * (*deltaX) / 93;
+  parameters.setTimeLimit((steps + 0.5) * (*deltaT));
+  return parameters;
+}
+
+/*=========== KERNELS ===============*/
+
+/**
+ * @brief Solve the problem with one of the AbstractSolver classes, without
+ * storing the solution
+ *
+ */
+Measurement benchmarkScheme(const std::string &schemeName, long points) {
+  long steps = std::max(2L, std::min(1000L, TARGET_POINT_STEPS / points));
+  double deltaX, deltaT;
+  HeatDiffusionParameters parameters =
+      benchmarkParameters(points, steps, &deltaX, &deltaT);
+  return measure(schemeName, points, steps, [&]() {
+    std::unique_ptr<AbstractSolver> solver =
+        SweepEngine::createSolver(schemeName);
+    (*solver).setParameters(parameters);
+    long pointSteps = 0;
+    (*solver).solveStreaming(deltaX, deltaT,
+                             [&](int, const double *, int numberOfPoints) {
+                               pointSteps += numberOfPoints;
+                             });
+    return pointSteps;
+  });
+}
+
+/**
+ * @brief Forward elimination of the Thomas algorithm on the matrix of the
+ * Laasonen scheme
+ *
+ */
+Measurement benchmarkThomasFactorize(long points) {
+  long repeats = std::max(1L, TARGET_POINT_STEPS / points);
+  std::vector<double> lower(points), main(points), upper(points),
+      pivots(points), modifiedUpper(points);
+  ImplicitKernels<scheme::Laasonen>::fillDiagonals(
+      0.5, points, lower.data(), main.data(), upper.data());
+  return measure("thomas_factorize", points, repeats, [&]() {
+    for (long k = 0; k < repeats; k++) {
+      factorizeTridiagonal(points, lower.data(), main.data(), upper.data(),
+                           pivots.data(), modifiedUpper.data());
+    }
+    return points * repeats;
+  });
+}
+
+/**
+ * @brief Right hand side of the Laasonen scheme, forward elimination on it
+ * and backward substitution of the Thomas algorithm : one implicit time step
+ *
+ */
+Measurement benchmarkThomasSolve(long points) {
+  long repeats = std::max(1L, TARGET_POINT_STEPS / points);
+  std::vector<double> lower(points), main(points), upper(points),
+      pivots(points), modifiedUpper(points), B(points), X(points, 38.);
+  X[0] = X[points - 1] = 149;
+  ImplicitKernels<scheme::Laasonen>::fillDiagonals(
+      0.5, points, lower.data(), main.data(), upper.data());
+  factorizeTridiagonal(points, lower.data(), main.data(), upper.data(),
+                       pivots.data(), modifiedUpper.data());
+  return measure("thomas_solve", points, repeats, [&]() {
+    for (long k = 0; k < repeats; k++) {
+      ImplicitKernels<scheme::Laasonen>::rightHandSide(X.data(), B.data(),
+                                                       points, 0.5);
+      solveFactorizedTridiagonal(points, lower.data(), pivots.data(),
+                                 modifiedUpper.data(), B.data(), X.data());
+    }
+    return points * repeats;
+  });
+}
+
+/**
+ * @brief Grid of rows x points values between -1 and 1
+ *
+ */
+SolutionGrid benchmarkGrid(long rows, long points) {
+  SolutionGrid grid(rows, points);
+  for (long i = 0; i < rows; i++) {
+    double *row = grid.row(i);
+    for (long j = 0; j < points; j++) {
+      row[j] = ((i * 7919 + j * 104729) % 2001 - 1000) * 1e-3;
+    }
+  }
+  return grid;
+}
+
+/**
+ * @brief Norm of a grid of points columns
+ *
+ */
+Measurement benchmarkNorm(const std::string &kernel, long points,
+                          double (*norm)(const SolutionView &)) {
+  long rows = std::max(1L, TARGET_POINT_STEPS / points);
+  SolutionGrid grid = benchmarkGrid(rows, points);
+  double sum = 0;
+  Measurement measurement = measure(kernel, points, rows, [&]() {
+    sum += norm(grid.view());
+    return points * rows;
+  });
+  // Keeps the norms from being optimized away
+  if (sum < 0) {
+    std::cerr << sum << std::endl;
+  }
+  return measurement;
+}
+
+/**
+ * @brief Norms of the errors computed row by row
+ *
+ */
+Measurement benchmarkErrorAccumulator(long points) {
+  long rows = std::max(1L, TARGET_POINT_STEPS / points);
+  SolutionGrid numerical = benchmarkGrid(rows, points);
+  SolutionGrid analytical = benchmarkGrid(rows, points);
+  std::vector<double> errors(points);
+  return measure("error_accumulator", points, rows, [&]() {
+    ErrorAccumulator accumulator;
+    for (long i = 0; i < rows; i++) {
+      accumulator.addRow(numerical.row(i), analytical.row(i), points,
+                         errors.data());
+    }
+    return points * rows;
+  });
+}
+
+/**
+ * @brief CSV result file of a solution of two time steps
+ *
+ */
+Measurement benchmarkResultToFile(long points) {
+  const long rows = 2;
+  SolutionGrid numerical = benchmarkGrid(rows, points);
+  SolutionGrid analytical = benchmarkGrid(rows, points);
+  std::string filename = "kernel_benchmark_output.csv";
+  Measurement measurement = measure("result_to_file", points, rows, [&]() {
+    resultToFile(filename, &numerical, &analytical, 0.1, 0.01);
+    return points * rows;
+  });
+  std::remove(filename.c_str());
+  return measurement;
+}
+
+/*=========== REPORT ===============*/
+
+void printMeasurement(const Measurement &measurement) {
+  std::cout << std::setw(20) << measurement.kernel << std::setw(10)
+            << measurement.points << std::setw(8) << measurement.steps
+            << std::setw(14) << measurement.nanosecondsPerPointStep
+            << std::setw(14) << measurement.bytesPerPoint << std::setw(10)
+            << measurement.allocations << std::endl;
+}
+
+void writeJson(const std::string &filename,
+               const std::vector<Measurement> &measurements) {
+  std::ofstream outputFile(filename);
+  if (!outputFile) {
+    throw(std::runtime_error("cannot open " + filename));
+  }
+  outputFile << std::setprecision(6);
+  outputFile << "{\n  \"instruction_set\": \""
+             << simd::instructionSetName(simd::activeInstructionSet())
+             << "\",\n  \"threads\": "
+             << ThreadPool::shared().getNumberOfThreads()
+             << ",\n  \"results\": [\n";
+  for (std::size_t i = 0; i < measurements.size(); i++) {
+    const Measurement &measurement = measurements[i];
+    outputFile << "    {\"kernel\": \"" << measurement.kernel
+               << "\", \"points\": " << measurement.points
+               << ", \"steps\": " << measurement.steps
+               << ", \"ns_per_point_step\": "
+               << measurement.nanosecondsPerPointStep
+               << ", \"bytes_per_point\": " << measurement.bytesPerPoint
+               << ", \"allocations\": " << measurement.allocations << "}"
+               << (i + 1 < measurements.size() ? ",\n" : "\n");
+  }
+  outputFile << "  ]\n}\n";
+}
+
+/**
+ * @brief Time each kernel of the library on grids of 10^2 to 10^7 points
+ *
+ * Options :
+ * - `--json <file>` : also write the results in file as JSON
+ * - `--max-points <n>` : skip the grids of more than n points
+ * - `--kernel <name>` : only run the kernels whose name contains name
+ */
+int main(int argc, const char **argv) {
+  std::string jsonFilename, kernelFilter;
+  long maximumPoints = 10000000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--json") == 0) {
+      jsonFilename = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--max-points") == 0) {
+      maximumPoints = std::atol(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--kernel") == 0) {
+      kernelFilter = argv[i + 1];
+    } else {
+      std::cerr << "unknown option " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  // Each kernel with the largest grid it is run on
+  struct Kernel {
+    std::string name;
+    long maximumPoints;
+    std::function<Measurement(long)> run;
+  };
+  std::vector<Kernel> kernels;
+  kernels.push_back({"thomas_factorize", 10000000, benchmarkThomasFactorize});
+  kernels.push_back({"thomas_solve", 10000000, benchmarkThomasSolve});
+  const char *schemeNames[4] = {"Laasonen", "Crank-Nicholson", "Richardson",
+                                "Dufort-Frankel"};
+  for (const char *schemeName : schemeNames) {
+    std::string name = schemeName;
+    kernels.push_back(
+        {name, 10000000, [name](long points) {
+           return benchmarkScheme(name, points);
+         }});
+  }
+  // The sine table of the analytical solution grows with the number of
+  // points times the number of terms
+  kernels.push_back({"Analytical", 100000, [](long points) {
+                       return benchmarkScheme("Analytical", points);
+                     }});
+  kernels.push_back({"one_norm", 10000000, [](long points) {
+                       return benchmarkNorm("one_norm", points,
+                                            norms::oneNorm);
+                     }});
+  kernels.push_back({"two_norm", 10000000, [](long points) {
+                       return benchmarkNorm("two_norm", points,
+                                            norms::twoNorm);
+                     }});
+  kernels.push_back({"uniform_norm", 10000000, [](long points) {
+                       return benchmarkNorm("uniform_norm", points,
+                                            norms::uniformNorm);
+                     }});
+  kernels.push_back(
+      {"error_accumulator", 10000000, benchmarkErrorAccumulator});
+  kernels.push_back({"result_to_file", 1000000, benchmarkResultToFile});
+
+  std::cout << "instruction set : "
+            << simd::instructionSetName(simd::activeInstructionSet())
+            << ", threads : " << ThreadPool::shared().getNumberOfThreads()
+            << std::endl;
+  std::cout << std::setprecision(3) << std::fixed;
+  std::cout << std::setw(20) << "kernel" << std::setw(10) << "points"
+            << std::setw(8) << "steps" << std::setw(14) << "ns/pt-step"
+            << std::setw(14) << "bytes/pt" << std::setw(10) << "allocs"
+            << std::endl;
+  std::vector<Measurement> measurements;
+  for (const Kernel &kernel : kernels) {
+    if (kernel.name.find(kernelFilter) == std::string::npos) {
+      continue;
+    }
+    for (long points = 100;
+         points <= std::min(maximumPoints, kernel.maximumPoints);
+         points *= 10) {
+      measurements.push_back(kernel.run(points));
+      printMeasurement(measurements.back());
+    }
+  }
+  if (!jsonFilename.empty()) {
+    writeJson(jsonFilename, measurements);
+  }
+}
@@ -1,42 +1,51 @@
 #include "crank-nicholson_solver.h"
+#include "solver_engine.h"
 #include <iostream>
 
 CrankNicholsonSolver::CrankNicholsonSolver() {
   schemeName = "Crank-Nicholson";
 };
 
+std::unique_ptr<AbstractSolver> CrankNicholsonSolver::clone() const {
+  CrankNicholsonSolver *solver = new CrankNicholsonSolver();
+  copySettingsTo(solver);
+  return std::unique_ptr<AbstractSolver>(solver);
+}
+
+void CrankNicholsonSolver::solveInGrid(double pdeltaX, double pdeltaT,
+                                       SolutionGrid *storage,
+                                       bool rollingWindow, RowSink sink) {
+  solveInGridWithEngine(&engine, pdeltaX, pdeltaT, storage, rollingWindow,
+                        sink);
+}
+
+int CrankNicholsonSolver::getOrderInTime() const {
+  return scheme::CrankNicholson::orderInTime;
+}
+
+double CrankNicholsonSolver::getImplicitWeight() const {
+  return scheme::CrankNicholson::implicitWeight();
+}
+
 void CrankNicholsonSolver::initializeMatrixAForThomasAlgo() {
-    // c=s/2 as defined in the report
-  double c = parameters.getDiffusivity() * deltaT / (2 * deltaX * deltaX);
-  int numberOfSpacePoints = (int)((parameters.getWidth()) / deltaX) + 1;
-  matrixA = std::vector<std::vector<double> >(
-      numberOfSpacePoints, std::vector<double>(numberOfSpacePoints, 0.));
-  matrixA[0][0] = 1;
-  matrixA[numberOfSpacePoints - 1][numberOfSpacePoints - 1] = 1;
-
-  for (int spaceIndex = 1; spaceIndex < numberOfSpacePoints - 1; spaceIndex++) {
-    matrixA[spaceIndex][spaceIndex] = 1;
-    matrixA[spaceIndex][spaceIndex + 1] =
-        -c / ((1 + (2 * c)) + c * matrixA[spaceIndex - 1][spaceIndex]);
-  }
+  // c=s/2 as defined in the report
+  // -c T(i-1) + (1+2c) T(i) - c T(i+1) = B(i) inside the wall
+  double c = scheme::CrankNicholson::coupling(parameters.getDiffusivity(),
+                                              deltaT, deltaX);
+  int numberOfSpacePoints = parameters.getNumberOfSpacePoints(deltaX);
+  allocateMatrixA(numberOfSpacePoints);
+  ImplicitKernels<scheme::CrankNicholson>::fillDiagonals(
+      c, numberOfSpacePoints, lowerDiagonal.data(), mainDiagonal.data(),
+      upperDiagonal.data());
+
+  factorizeMatrixA();
 }
 
 void CrankNicholsonSolver::initializeMatrixBForThomasAlgo(
-    std::vector<double> *TpreviousTimeStep) {
-// c=s/2 as defined in the report
-  double c = parameters.getDiffusivity() * deltaT / (2 * deltaX * deltaX);
-  int numberOfSpacePoints = (int)((parameters.getWidth()) / deltaX) + 1;
-  matrixB = std::vector<double>(numberOfSpacePoints, -1);
-  matrixB[0] = ((*TpreviousTimeStep)[0] / 1);
-  for (int spaceIndex = 1; spaceIndex < numberOfSpacePoints - 1; spaceIndex++) {
-    double di = (1 - (2 * c)) * (*TpreviousTimeStep)[spaceIndex] +
-                c * (*TpreviousTimeStep)[spaceIndex + 1] +
-                c * (*TpreviousTimeStep)[spaceIndex - 1];
-    matrixB[spaceIndex] =
-        ((di - (-c * matrixB[spaceIndex - 1])) /
-         (1 + (2 * c) + c * matrixA[spaceIndex - 1][spaceIndex]));
-  }
-  double di = (*TpreviousTimeStep)[numberOfSpacePoints - 1];
-  matrixB[numberOfSpacePoints - 1] =
-      di / matrixA[numberOfSpacePoints - 1][numberOfSpacePoints - 1];
+    const double *TpreviousTimeStep) {
+  // c=s/2 as defined in the report
+  double c = scheme::CrankNicholson::coupling(parameters.getDiffusivity(),
+                                              deltaT, deltaX);
+  ImplicitKernels<scheme::CrankNicholson>::rightHandSide(
+      TpreviousTimeStep, matrixB.data(), matrixB.size(), c);
 }
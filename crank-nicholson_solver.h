@@ -6,7 +6,20 @@ class CrankNicholsonSolver : public ImplicitSolver {
 public:
   CrankNicholsonSolver();
 
+
+  std::unique_ptr<AbstractSolver> clone() const override;
+
 protected:
+  /**
+   * @brief Solver of the time steps on regular meshes
+   *
+   */
+  SolverEngine<scheme::CrankNicholson> engine;
+
+  void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                   bool rollingWindow, RowSink sink) override;
+  int getOrderInTime() const override;
+  double getImplicitWeight() const override;
   /**
    * Compute the A matrix of the linear system given by Crank-nicholson scheme
    * and apply transformations required for solving the system with Thomas
@@ -20,6 +33,5 @@ protected:
    * Algorithm
    *
    */
-  void initializeMatrixBForThomasAlgo(
-      std::vector<double> *previousTimeStep) override;
+  void initializeMatrixBForThomasAlgo(const double *previousTimeStep) override;
 };
@@ -0,0 +1,343 @@
+#include "csv_writer.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+std::atomic<std::uint64_t> totalBytesWritten(0);
+
+/**
+ * @brief Room left for a formatted double : sign, 17 digits, point and
+ * exponent
+ *
+ */
+const std::size_t MAXIMUM_NUMBER_SIZE = 32;
+
+/**
+ * @brief Largest n such that 10^n is exactly a long double
+ *
+ */
+const int MAXIMUM_EXACT_POWER = 27;
+
+/**
+ * @brief Powers of 10 as long doubles (all exact) and as integers
+ *
+ */
+struct PowersOfTen {
+  long double exact[MAXIMUM_EXACT_POWER + 1];
+  unsigned long long integer[18];
+  PowersOfTen() {
+    exact[0] = 1;
+    integer[0] = 1;
+    for (int n = 1; n <= MAXIMUM_EXACT_POWER; n++) {
+      exact[n] = exact[n - 1] * 10;
+    }
+    for (int n = 1; n < 18; n++) {
+      integer[n] = integer[n - 1] * 10;
+    }
+  }
+};
+
+const PowersOfTen &powersOfTen() {
+  static const PowersOfTen powers;
+  return powers;
+}
+
+/**
+ * @brief Write digits[0, size) without its trailing zeros
+ *
+ */
+char *writeSignificantDigits(char *text, const char *digits, int size) {
+  while (size > 0 && digits[size - 1] == '0') {
+    size--;
+  }
+  std::memcpy(text, digits, size);
+  return text + size;
+}
+
+/**
+ * @brief Format value as printf("%.<precision>g") without calling printf.
+ * The precision digits are obtained by scaling value by a power of 10 with
+ * a 64 bits mantissa : the result is the correctly rounded one unless it is
+ * too close to a tie to be sure. Returns the size of the text, or 0 when
+ * printf is needed (tie, value out of range, infinite, not a number).
+ *
+ */
+int formatWithoutPrintf(char *text, double value, int precision) {
+  const PowersOfTen &powers = powersOfTen();
+  if (std::numeric_limits<long double>::digits < 64 ||
+      !std::isfinite(value)) {
+    return 0;
+  }
+  char *start = text;
+  if (std::signbit(value)) {
+    *text++ = '-';
+    value = -value;
+  }
+  if (value == 0) {
+    *text++ = '0';
+    return text - start;
+  }
+  if (!std::isnormal(value)) {
+    return 0;
+  }
+
+  // value = digits * 10^(exponent - precision + 1) with precision digits
+  int exponent = (int)std::floor(std::log10(value));
+  unsigned long long digits = 0;
+  bool found = false;
+  for (int attempt = 0; attempt < 2 && !found; attempt++) {
+    int scale = precision - 1 - exponent;
+    if (scale < 0 || scale > MAXIMUM_EXACT_POWER) {
+      return 0;
+    }
+    long double scaled = (long double)value * powers.exact[scale];
+    if (scaled >= powers.integer[precision]) {
+      exponent++;
+      continue;
+    }
+    if (scaled < powers.integer[precision - 1]) {
+      exponent--;
+      continue;
+    }
+    digits = (unsigned long long)scaled;
+    long double fraction = scaled - digits;
+    if (std::fabs(fraction - 0.5L) < 1.0L / 64) {
+      return 0;
+    }
+    if (fraction > 0.5L) {
+      digits++;
+    }
+    if (digits == powers.integer[precision]) {
+      digits = powers.integer[precision - 1];
+      exponent++;
+    }
+    found = true;
+  }
+  if (!found) {
+    return 0;
+  }
+
+  char digitText[20];
+  for (int i = precision - 1; i >= 0; i--) {
+    digitText[i] = '0' + digits % 10;
+    digits /= 10;
+  }
+  if (exponent < -4 || exponent >= precision) {
+    // Scientific notation : d.ddde+XX
+    *text++ = digitText[0];
+    char *point = text++;
+    text = writeSignificantDigits(text, digitText + 1, precision - 1);
+    if (text == point + 1) {
+      text = point;
+    } else {
+      *point = '.';
+    }
+    *text++ = 'e';
+    *text++ = exponent < 0 ? '-' : '+';
+    int absoluteExponent = exponent < 0 ? -exponent : exponent;
+    if (absoluteExponent >= 100) {
+      *text++ = '0' + absoluteExponent / 100;
+    }
+    *text++ = '0' + absoluteExponent / 10 % 10;
+    *text++ = '0' + absoluteExponent % 10;
+  } else if (exponent >= 0) {
+    std::memcpy(text, digitText, exponent + 1);
+    text += exponent + 1;
+    char *point = text++;
+    text = writeSignificantDigits(text, digitText + exponent + 1,
+                                  precision - exponent - 1);
+    if (text == point + 1) {
+      text = point;
+    } else {
+      *point = '.';
+    }
+  } else {
+    *text++ = '0';
+    *text++ = '.';
+    for (int i = 0; i < -exponent - 1; i++) {
+      *text++ = '0';
+    }
+    text = writeSignificantDigits(text, digitText, precision);
+  }
+  return text - start;
+}
+} // namespace
+
+CsvWriter::CsvWriter(const std::string &pfilename, std::size_t pbufferSize)
+    : file(nullptr), filename(pfilename),
+      bufferSize(std::max(pbufferSize, 2 * MAXIMUM_NUMBER_SIZE)), precision(6),
+      bytesWritten(0), openingTime(std::chrono::steady_clock::now()),
+      secondsOpen(0), closed(false), stopping(false), writeFailed(false) {
+  file = std::fopen(filename.c_str(), "wb");
+  if (!file) {
+    throw(std::runtime_error("cannot open " + filename));
+  }
+  // The buffers are already large, no need for the one of the FILE
+  std::setvbuf(file, nullptr, _IONBF, 0);
+  buffer.reserve(bufferSize);
+  writer = std::thread(&CsvWriter::writerLoop, this);
+};
+
+CsvWriter::~CsvWriter() {
+  if (!closed) {
+    try {
+      close();
+    } catch (...) {
+      // No exception from a destructor : close should be called to know if
+      // the writes succeeded
+    }
+  }
+};
+
+void CsvWriter::writerLoop() {
+  while (true) {
+    std::vector<char> toWrite;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      bufferSubmitted.wait(
+          lock, [this]() { return stopping || !pendingBuffers.empty(); });
+      if (pendingBuffers.empty()) {
+        return;
+      }
+      toWrite.swap(pendingBuffers.front());
+      pendingBuffers.pop_front();
+    }
+    bool success = std::fwrite(toWrite.data(), 1, toWrite.size(), file) ==
+                   toWrite.size();
+    toWrite.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      writeFailed = writeFailed || !success;
+      freeBuffers.push_back(std::vector<char>());
+      freeBuffers.back().swap(toWrite);
+    }
+    bufferReleased.notify_one();
+  }
+}
+
+void CsvWriter::submitBuffer() {
+  if (buffer.empty()) {
+    return;
+  }
+  std::vector<char> nextBuffer;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingBuffers.push_back(std::vector<char>());
+    pendingBuffers.back().swap(buffer);
+    // Bounded memory : besides the buffer being filled and the one being
+    // written, at most NUMBER_OF_BUFFERS - 2 buffers wait for the disk
+    bufferReleased.wait(lock, [this]() {
+      return (int)pendingBuffers.size() <= NUMBER_OF_BUFFERS - 2;
+    });
+    if (!freeBuffers.empty()) {
+      nextBuffer.swap(freeBuffers.back());
+      freeBuffers.pop_back();
+    }
+  }
+  bufferSubmitted.notify_one();
+  buffer.swap(nextBuffer);
+  buffer.reserve(bufferSize);
+}
+
+void CsvWriter::reserve(std::size_t size) {
+  if (buffer.size() + size > bufferSize) {
+    submitBuffer();
+  }
+}
+
+void CsvWriter::append(const char *text, std::size_t size) {
+  bytesWritten += size;
+  while (size > 0) {
+    reserve(1);
+    std::size_t part = std::min(size, bufferSize - buffer.size());
+    buffer.insert(buffer.end(), text, text + part);
+    text += part;
+    size -= part;
+  }
+}
+
+CsvWriter &CsvWriter::operator<<(const char *text) {
+  append(text, std::strlen(text));
+  return *this;
+}
+
+CsvWriter &CsvWriter::operator<<(const std::string &text) {
+  append(text.data(), text.size());
+  return *this;
+}
+
+CsvWriter &CsvWriter::operator<<(char character) {
+  append(&character, 1);
+  return *this;
+}
+
+CsvWriter &CsvWriter::operator<<(int value) {
+  char text[MAXIMUM_NUMBER_SIZE];
+  int size = std::snprintf(text, sizeof(text), "%d", value);
+  append(text, size);
+  return *this;
+}
+
+CsvWriter &CsvWriter::operator<<(double value) {
+  // Formatted directly at the end of the buffer
+  reserve(MAXIMUM_NUMBER_SIZE);
+  std::size_t start = buffer.size();
+  buffer.resize(start + MAXIMUM_NUMBER_SIZE);
+  int size = formatWithoutPrintf(buffer.data() + start, value, precision);
+  if (size == 0) {
+    size = std::snprintf(buffer.data() + start, MAXIMUM_NUMBER_SIZE, "%.*g",
+                         precision, value);
+  }
+  buffer.resize(start + size);
+  bytesWritten += size;
+  return *this;
+}
+
+void CsvWriter::setPrecision(int pprecision) {
+  // Same limit as the precision of a double, so that a number always fits in
+  // MAXIMUM_NUMBER_SIZE
+  precision = std::min(std::max(pprecision, 1), 17);
+}
+
+void CsvWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+  submitBuffer();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  bufferSubmitted.notify_one();
+  writer.join();
+  bool closeFailed = std::fclose(file) != 0;
+  file = nullptr;
+  secondsOpen = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - openingTime)
+                    .count();
+  totalBytesWritten += bytesWritten;
+  HEAT_COUNT("output.csv_bytes", bytesWritten);
+  if (writeFailed || closeFailed) {
+    throw(std::runtime_error("cannot write " + filename));
+  }
+}
+
+std::uint64_t CsvWriter::getBytesWritten() const { return bytesWritten; }
+
+double CsvWriter::getBytesPerSecond() const {
+  double seconds = closed ? secondsOpen
+                          : std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - openingTime)
+                                .count();
+  return seconds > 0 ? bytesWritten / seconds : 0;
+}
+
+std::uint64_t CsvWriter::getTotalBytesWritten() {
+  return totalBytesWritten.load();
+}
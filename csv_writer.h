@@ -0,0 +1,135 @@
+#pragma once // Include guard
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Text output to a file through large buffers, written to the disk by
+ * a background thread while the next buffer is being filled
+ *
+ * Values are formatted as an std::ostream would do it with the same
+ * precision (printf "%.<precision>g"), so that files are byte-identical to
+ * the ones written with an std::fstream. The memory used is bounded : once
+ * NUMBER_OF_BUFFERS buffers are waiting to be written, adding text waits for
+ * the disk.
+ */
+class CsvWriter {
+public:
+  /**
+   * @brief Default size in bytes of each buffer
+   *
+   */
+  static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+  /**
+   * @brief Number of buffers : the one being filled and the ones waiting to
+   * be written
+   *
+   */
+  static const int NUMBER_OF_BUFFERS = 3;
+
+  /**
+   * @brief Open a file for writing, erasing its content
+   *
+   * Can throw a runtime_error exception if the file cannot be opened
+   *
+   * @param filename : name of the file
+   * @param bufferSize : size in bytes of each buffer
+   */
+  explicit CsvWriter(const std::string &filename,
+                     std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * @brief Close the file if close has not been called
+   *
+   */
+  ~CsvWriter();
+
+  CsvWriter(const CsvWriter &) = delete;
+  CsvWriter &operator=(const CsvWriter &) = delete;
+
+  CsvWriter &operator<<(const char *text);
+  CsvWriter &operator<<(const std::string &text);
+  CsvWriter &operator<<(char character);
+  CsvWriter &operator<<(int value);
+  CsvWriter &operator<<(double value);
+
+  /**
+   * @brief Set the number of significant digits of the doubles, as
+   * std::setprecision. The default is 6.
+   *
+   */
+  void setPrecision(int precision);
+
+  /**
+   * @brief Write what is left in the buffers, wait for the background thread
+   * and close the file
+   *
+   * Can throw a runtime_error exception if a write failed
+   */
+  void close();
+
+  /**
+   * @brief Get the number of bytes given to the writer
+   *
+   */
+  std::uint64_t getBytesWritten() const;
+
+  /**
+   * @brief Get the number of bytes written per second, from the opening to
+   * the closing of the file (or to now if it is still open)
+   *
+   */
+  double getBytesPerSecond() const;
+
+  /**
+   * @brief Get the number of bytes written by all the writers of the
+   * programm
+   *
+   */
+  static std::uint64_t getTotalBytesWritten();
+
+private:
+  /**
+   * @brief Make sure size more bytes fit in the current buffer, handing it to
+   * the background thread if needed
+   *
+   */
+  void reserve(std::size_t size);
+  void append(const char *text, std::size_t size);
+  void submitBuffer();
+  void writerLoop();
+
+  std::FILE *file;
+  std::string filename;
+  std::size_t bufferSize;
+  std::vector<char> buffer;
+  int precision;
+  std::uint64_t bytesWritten;
+  std::chrono::steady_clock::time_point openingTime;
+  double secondsOpen;
+  bool closed;
+
+  std::mutex mutex;
+  std::condition_variable bufferSubmitted;
+  std::condition_variable bufferReleased;
+  /**
+   * @brief buffers waiting to be written, in order
+   *
+   */
+  std::deque<std::vector<char>> pendingBuffers;
+  /**
+   * @brief written buffers, kept to be filled again
+   *
+   */
+  std::vector<std::vector<char>> freeBuffers;
+  bool stopping;
+  bool writeFailed;
+  std::thread writer;
+};
@@ -1,24 +1,43 @@
 
 #include "dufort-frankel_solver.h"
 #include "laasonen_simple_implicit_solver.h"
+#include "solver_engine.h"
 
 DufortFrankelSolver::DufortFrankelSolver() {
   schemeName = "Dufort-Frankel";
   threeLevelScheme = true;
 };
 
+std::unique_ptr<AbstractSolver> DufortFrankelSolver::clone() const {
+  DufortFrankelSolver *solver = new DufortFrankelSolver();
+  copySettingsTo(solver);
+  return std::unique_ptr<AbstractSolver>(solver);
+}
+
 double DufortFrankelSolver::nextStep(
-    int spaceStep, int timeStep,
-    std::vector<std::vector<double> > *TSolution) const {
+    int spaceStep, int, const double *previousTimeStep,
+    const double *beforePreviousTimeStep) const {
 
-  // According to richardson scheme :
-  double nextStep =
-      ((*TSolution)[timeStep - 2][spaceStep] +
-       2 * parameters.getDiffusivity() * (deltaT / (deltaX * deltaX)) *
-           ((*TSolution)[timeStep - 1][spaceStep + 1] -
-            (*TSolution)[timeStep - 2][spaceStep] +
-            (*TSolution)[timeStep - 1][spaceStep - 1])) /
-      (1 + 2 * parameters.getDiffusivity() * (deltaT / (deltaX * deltaX)));
+  // According to dufort-frankel scheme :
+  double r = scheme::DufortFrankel::coupling(parameters.getDiffusivity(),
+                                             deltaT, deltaX);
+  return (scheme::DufortFrankel::point(previousTimeStep,
+                                       beforePreviousTimeStep, spaceStep, r));
+}
+
+void DufortFrankelSolver::solveInGrid(double pdeltaX, double pdeltaT,
+                                      SolutionGrid *storage, bool rollingWindow,
+                                      RowSink sink) {
+  solveInGridWithEngine(&engine, pdeltaX, pdeltaT, storage, rollingWindow,
+                        sink);
+}
 
-  return (nextStep);
+void DufortFrankelSolver::nextRowOnMesh(
+    const SpaceMesh &mesh, const double *previousTimeStep,
+    const double *beforePreviousTimeStep, double *TSolutionAtOneTime,
+    int firstSpaceStep, int lastSpaceStep) const {
+  scheme::DufortFrankel::meshRow(previousTimeStep, beforePreviousTimeStep,
+                                 TSolutionAtOneTime, mesh, firstSpaceStep,
+                                 lastSpaceStep,
+                                 parameters.getDiffusivity() * deltaT);
 }
@@ -0,0 +1,62 @@
+#include "error_accumulator.h"
+#include "norms.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void ErrorAccumulator::reset() {
+  uniformNorm = 0;
+  squareChunkSums.clear();
+  rowUniformNorms.clear();
+  rowTwoNorms.clear();
+}
+
+void ErrorAccumulator::addRow(const double *numericalRow,
+                              const double *analyticalRow, int numberOfColumns,
+                              double *errorRow) {
+  if (!errorRow) {
+    errorBuffer.resize(numberOfColumns);
+    errorRow = errorBuffer.data();
+  }
+  for (int j = 0; j < numberOfColumns; j++) {
+    errorRow[j] = analyticalRow[j] - numericalRow[j];
+  }
+  addErrorRow(errorRow, numberOfColumns);
+}
+
+void ErrorAccumulator::addErrorRow(const double *errorRow,
+                                   int numberOfColumns) {
+  SolutionView row = {errorRow, 1, numberOfColumns, numberOfColumns, 1};
+  double rowUniformNorm = norms::uniformNorm(row);
+  rowChunkSums.clear();
+  norms::appendChunkSums(row, norms::SQUARES, nullptr, &rowChunkSums);
+  uniformNorm = std::max(uniformNorm, rowUniformNorm);
+  squareChunkSums.insert(squareChunkSums.end(), rowChunkSums.begin(),
+                         rowChunkSums.end());
+  rowUniformNorms.push_back(rowUniformNorm);
+  rowTwoNorms.push_back(
+      sqrt(norms::pairwiseSum(rowChunkSums.data(), rowChunkSums.size())));
+}
+
+std::function<void(int, const double *, int)>
+ErrorAccumulator::numericalRowSink(const SolutionGrid *analyticalSolution) {
+  return [this, analyticalSolution](int i, const double *numericalRow,
+                                    int numberOfColumns) {
+    if (i != getNumberOfRows()) {
+      throw(std::logic_error("the rows must be added in order"));
+    }
+    if (i >= (*analyticalSolution).getNumberOfRows() ||
+        numberOfColumns != (*analyticalSolution).getNumberOfColumns()) {
+      throw(std::invalid_argument(
+          "the analytical solution is not on the same grid"));
+    }
+    addRow(numericalRow, (*analyticalSolution).row(i), numberOfColumns);
+  };
+}
+
+double ErrorAccumulator::getUniformNorm() const { return uniformNorm; }
+
+double ErrorAccumulator::getTwoNorm() const {
+  return sqrt(
+      norms::pairwiseSum(squareChunkSums.data(), squareChunkSums.size()));
+}
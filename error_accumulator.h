@@ -0,0 +1,99 @@
+#pragma once // Include guard
+#include "solution_grid.h"
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Norms of the errors (analytical - numerical) of a solution,
+ * computed row by row as the time steps become available, without storing
+ * the errors
+ *
+ * The global norms are the ones of norms::uniformNorm and norms::twoNorm on
+ * the whole error matrix and the row norms the ones on each row : the chunk
+ * sums of each row are kept and added in the same order (see norms.h), so the
+ * values are identical for rows of more than one point.
+ *
+ * In a streaming run, the numerical rows are added as they are computed with
+ * numericalRowSink : only the norms of each row are kept.
+ */
+class ErrorAccumulator {
+public:
+  /**
+   * @brief Forget all the rows added
+   *
+   */
+  void reset();
+
+  /**
+   * @brief Add the next time step
+   *
+   * @param numericalRow : temperatures of the numerical solution
+   * @param analyticalRow : temperatures of the analytical solution
+   * @param numberOfColumns : number of points of the time step
+   * @param errorRow : where to store analytical - numerical for each point,
+   * can be nullptr
+   */
+  void addRow(const double *numericalRow, const double *analyticalRow,
+              int numberOfColumns, double *errorRow = nullptr);
+
+  /**
+   * @brief Add the next time step from its errors
+   *
+   * @param errorRow : analytical - numerical for each point
+   * @param numberOfColumns : number of points of the time step
+   */
+  void addErrorRow(const double *errorRow, int numberOfColumns);
+
+  /**
+   * @brief Function to give to AbstractSolver::solveStreaming : each time
+   * step of the numerical solution is compared to the same row of
+   * analyticalSolution. The rows must come in order, starting with t=0.
+   *
+   * @param analyticalSolution : analytical solution on the same grid, which
+   * must stay alive while the sink is used
+   */
+  std::function<void(int, const double *, int)>
+  numericalRowSink(const SolutionGrid *analyticalSolution);
+
+  int getNumberOfRows() const { return (int)rowUniformNorms.size(); }
+
+  /**
+   * @brief Get the uniform norm of all the errors added
+   *
+   */
+  double getUniformNorm() const;
+
+  /**
+   * @brief Get the two norm of all the errors added
+   *
+   */
+  double getTwoNorm() const;
+
+  /**
+   * @brief Get the uniform norm of the errors of row i
+   *
+   */
+  double getRowUniformNorm(int i) const { return rowUniformNorms[i]; }
+
+  /**
+   * @brief Get the two norm of the errors of row i
+   *
+   */
+  double getRowTwoNorm(int i) const { return rowTwoNorms[i]; }
+
+private:
+  double uniformNorm = 0;
+  /**
+   * @brief Sums of the squares of the chunks of all the rows
+   *
+   */
+  std::vector<double> squareChunkSums;
+  std::vector<double> rowUniformNorms;
+  std::vector<double> rowTwoNorms;
+  /**
+   * @brief Errors of the last row when they are not stored by the caller
+   *
+   */
+  std::vector<double> errorBuffer;
+  std::vector<double> rowChunkSums;
+};
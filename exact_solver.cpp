@@ -1,11 +1,396 @@
 #include "exact_solver.h"
+#include "instrumentation.h"
+#include "simd_dispatch.h"
+#include "thread_pool.h"
 #include "stdlib.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
-ExactSolver::ExactSolver() { schemeName = "Analytical"; };
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#include <immintrin.h>
+#endif
 
-double
-ExactSolver::nextStep(int spaceStep, int timeStep,
-                      std::vector<std::vector<double> > *TSolution) const {
+namespace {
+
+/**
+ * @brief Number of points of a time step computed at once, so that the sums
+ * being computed stay in the first level cache
+ *
+ */
+const int BLOCK_SIZE = 512;
+
+// The series is summed from the last term to the first one, as done point by
+// point in nextStep, so that all the versions give the same results.
+
+void seriesRowScalar(const double *sinTable, int stride, const double *weights,
+                     int numberOfTerms, double *T, int first, int last,
+                     double difference, double surfaceTemperature) {
+  for (int j = first; j < last; j++) {
+    T[j] = 0;
+  }
+  for (int q = numberOfTerms - 1; q >= 0; q--) {
+    const double *sinRow = sinTable + (std::ptrdiff_t)q * stride;
+    double weight = weights[q];
+    for (int j = first; j < last; j++) {
+      T[j] += weight * sinRow[j];
+    }
+  }
+  for (int j = first; j < last; j++) {
+    T[j] = T[j] * 2 * difference + surfaceTemperature;
+  }
+}
+
+#ifdef HEAT_SIMD_X86
+__attribute__((target("avx2"))) void
+seriesRowAVX2(const double *sinTable, int stride, const double *weights,
+              int numberOfTerms, double *T, int first, int last,
+              double difference, double surfaceTemperature) {
+  const __m256d two = _mm256_set1_pd(2);
+  const __m256d vdifference = _mm256_set1_pd(difference);
+  const __m256d vsurface = _mm256_set1_pd(surfaceTemperature);
+  int j = first;
+  // Four independent sums of 4 points at a time
+  for (; j + 16 <= last; j += 16) {
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(),
+            sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+    for (int q = numberOfTerms - 1; q >= 0; q--) {
+      const double *sinRow = sinTable + (std::ptrdiff_t)q * stride + j;
+      __m256d weight = _mm256_set1_pd(weights[q]);
+      sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(weight, _mm256_loadu_pd(sinRow)));
+      sum1 = _mm256_add_pd(sum1,
+                           _mm256_mul_pd(weight, _mm256_loadu_pd(sinRow + 4)));
+      sum2 = _mm256_add_pd(sum2,
+                           _mm256_mul_pd(weight, _mm256_loadu_pd(sinRow + 8)));
+      sum3 = _mm256_add_pd(sum3,
+                           _mm256_mul_pd(weight, _mm256_loadu_pd(sinRow + 12)));
+    }
+    __m256d sums[4] = {sum0, sum1, sum2, sum3};
+    for (int block = 0; block < 4; block++) {
+      _mm256_storeu_pd(
+          T + j + 4 * block,
+          _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(sums[block], two),
+                                      vdifference),
+                        vsurface));
+    }
+  }
+  seriesRowScalar(sinTable, stride, weights, numberOfTerms, T, j, last,
+                  difference, surfaceTemperature);
+}
+#endif
+
+/**
+ * @brief Sum the series for the points [first, last) of a time step
+ *
+ */
+void seriesRow(const double *sinTable, int stride, const double *weights,
+               int numberOfTerms, double *T, int first, int last,
+               double difference, double surfaceTemperature) {
+#ifdef HEAT_SIMD_X86
+  if (simd::activeInstructionSet() == simd::AVX2) {
+    seriesRowAVX2(sinTable, stride, weights, numberOfTerms, T, first, last,
+                  difference, surfaceTemperature);
+    return;
+  }
+#endif
+  seriesRowScalar(sinTable, stride, weights, numberOfTerms, T, first, last,
+                  difference, surfaceTemperature);
+}
+
+} // namespace
+
+ExactSolver::ExactSolver() {
+  schemeName = "Analytical";
+  // Each time step only depends on the tables, computing several time steps
+  // by tiles brings nothing
+  temporalBlocking = false;
+};
+
+std::unique_ptr<AbstractSolver> ExactSolver::clone() const {
+  ExactSolver *solver = new ExactSolver();
+  copySettingsTo(solver);
+  (*solver).setTolerance(tolerance);
+  (*solver).setParallelThreshold(parallelThreshold);
+  return std::unique_ptr<AbstractSolver>(solver);
+}
+
+std::string ExactSolver::getConfigurationName() const {
+  if (tolerance == 0) {
+    return schemeName;
+  }
+  std::ostringstream name;
+  name << schemeName << " (tolerance " << tolerance << ")";
+  return name.str();
+}
+
+void ExactSolver::solveRegularMeshes(double pdeltaX, double pdeltaT,
+                                     SolutionGrid *TSolutionPtr) {
+  prepareTables(pdeltaX, pdeltaT);
+  ExplicitSolver::solveRegularMeshes(pdeltaX, pdeltaT, TSolutionPtr);
+};
+
+void ExactSolver::solveStreaming(double pdeltaX, double pdeltaT,
+                                 RowSink sink) {
+  prepareTables(pdeltaX, pdeltaT);
+  ExplicitSolver::solveStreaming(pdeltaX, pdeltaT, sink);
+};
+
+void ExactSolver::solveOnMesh(const SpaceMesh &mesh, double pdeltaT,
+                              MeshRowSink sink, const MeshRefinement &) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  deltaT = pdeltaT;
+  std::vector<double> TSolutionAtOneTime(mesh.getNumberOfPoints());
+  for (int timeIndex = 0; (timeIndex * deltaT) <= parameters.getTimeStop();
+       timeIndex++) {
+    solveOnMeshAt(mesh, timeIndex * deltaT, TSolutionAtOneTime.data());
+    if (sink) {
+      sink(timeIndex, mesh, TSolutionAtOneTime.data());
+    }
+  }
+}
+
+void ExactSolver::solveOnMeshAt(const SpaceMesh &mesh, double t,
+                                double *temperatures) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  HEAT_TIMED_SCOPE("exact.mesh_rows");
+  int numberOfPoints = mesh.getNumberOfPoints();
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  if (t == 0) {
+    std::fill(temperatures, temperatures + numberOfPoints,
+              parameters.getInternalTemperature());
+    temperatures[0] = surfaceTemperature;
+    temperatures[numberOfPoints - 1] = surfaceTemperature;
+    return;
+  }
+  int numberOfTermsAtT = (tolerance > 0) ? numberOfTermsNeeded(t)
+                                         : (DEFAULT_LAST_TERM + 1) / 2;
+  double L = parameters.getWidth();
+  if (mesh != meshSinTableMesh || L != meshSinTableWidth ||
+      numberOfTermsAtT > meshSinTableNumberOfTerms) {
+    meshSinTable.resize((std::size_t)numberOfTermsAtT * numberOfPoints);
+    for (int q = 0; q < numberOfTermsAtT; q++) {
+      int m = 2 * q + 1;
+      for (int j = 0; j < numberOfPoints; j++) {
+        meshSinTable[(std::size_t)q * numberOfPoints + j] =
+            sin(m * M_PI * mesh.getPosition(j) / L);
+      }
+    }
+    meshSinTableMesh = mesh;
+    meshSinTableWidth = L;
+    meshSinTableNumberOfTerms = numberOfTermsAtT;
+  }
+  std::vector<double> weights(numberOfTermsAtT);
+  for (int q = 0; q < numberOfTermsAtT; q++) {
+    int m = 2 * q + 1;
+    weights[q] = exp(-parameters.getDiffusivity() * (m * M_PI / L) *
+                     (m * M_PI / L) * t) *
+                 2 / (m * M_PI);
+  }
+  seriesRow(meshSinTable.data(), numberOfPoints, weights.data(),
+            numberOfTermsAtT, temperatures, 0, numberOfPoints,
+            parameters.getInternalTemperature() - surfaceTemperature,
+            surfaceTemperature);
+  // The series is 0 at the surfaces up to the rounding of the sines
+  temperatures[0] = surfaceTemperature;
+  temperatures[numberOfPoints - 1] = surfaceTemperature;
+}
+
+void ExactSolver::solveBoxAt(double deltaX, double height, double depth,
+                             double t, SolutionGrid *temperatures) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  if (height <= 0 || depth < 0) {
+    throw(std::invalid_argument(
+        "the height should be positive and the depth not negative"));
+  }
+  std::vector<double> lengths = {parameters.getWidth(), height};
+  if (depth > 0) {
+    lengths.push_back(depth);
+  }
+  // Normalized solution across each direction
+  std::vector<SolutionGrid> directions(lengths.size());
+  ExactSolver directionSolver;
+  directionSolver.setTolerance(tolerance);
+  HeatDiffusionParameters directionParameters(parameters);
+  directionParameters.setSurfaceTemperature(0);
+  directionParameters.setInternalTemperature(1);
+  for (std::size_t d = 0; d < lengths.size(); d++) {
+    directionParameters.setWidth(lengths[d]);
+    directionSolver.setParameters(directionParameters);
+    directionSolver.solveAtTimes(deltaX, {t}, &directions[d]);
+  }
+
+  int numberOfColumns = directions[0].getNumberOfColumns();
+  int numberOfRows = directions[1].getNumberOfColumns();
+  int numberOfLayers = depth > 0 ? directions[2].getNumberOfColumns() : 1;
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  double scale = parameters.getInternalTemperature() - surfaceTemperature;
+  (*temperatures).resize(numberOfRows * numberOfLayers, numberOfColumns);
+  for (int k = 0; k < numberOfLayers; k++) {
+    double layerFactor = depth > 0 ? directions[2](0, k) : 1;
+    for (int j = 0; j < numberOfRows; j++) {
+      double *line = (*temperatures).row(k * numberOfRows + j);
+      double lineFactor = layerFactor * directions[1](0, j);
+      for (int i = 0; i < numberOfColumns; i++) {
+        line[i] = surfaceTemperature + scale * lineFactor * directions[0](0, i);
+      }
+    }
+  }
+}
+
+void ExactSolver::setTolerance(double ptolerance) {
+  if (ptolerance < 0) {
+    throw(std::invalid_argument("tolerance should be positive"));
+  }
+  tolerance = ptolerance;
+};
+
+void ExactSolver::setParallelThreshold(int numberOfPoints) {
+  parallelThreshold = numberOfPoints;
+};
+
+int ExactSolver::numberOfTermsNeeded(double t) const {
+  int maximumNumberOfTerms = (MAXIMUM_TERM + 1) / 2;
+  double a = parameters.getDiffusivity() * (M_PI / parameters.getWidth()) *
+             (M_PI / parameters.getWidth()) * t;
+  if (a <= 0) {
+    return maximumNumberOfTerms;
+  }
+  double amplitude = 4 * fabs(parameters.getInternalTemperature() -
+                              parameters.getSurfaceTemperature());
+  // The ratio between two consecutive terms m / (m + 2) exp(-4 a (m + 1))
+  // decreases with m : the terms after m are below term(m) / (1 - ratio(m))
+  for (int q = 1; q < maximumNumberOfTerms; q++) {
+    int m = 2 * q + 1;
+    double term = amplitude / (m * M_PI) * exp(-a * m * m);
+    double ratio = (double)m / (m + 2) * exp(-4 * a * (m + 1));
+    if (ratio < 1 && term / (1 - ratio) <= tolerance) {
+      return q;
+    }
+  }
+  return maximumNumberOfTerms;
+}
+
+void ExactSolver::prepareTables(double pdeltaX, double pdeltaT) {
+  HEAT_TIMED_SCOPE("exact.tables");
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  double L = parameters.getWidth();
+  int numberOfTimeSteps = parameters.getNumberOfTimeSteps(pdeltaT);
+
+  termsPerTimeStep.assign(numberOfTimeSteps, (DEFAULT_LAST_TERM + 1) / 2);
+  if (tolerance > 0) {
+    // The initial state (n = 0) is not computed with the series
+    termsPerTimeStep[0] = 1;
+    for (int n = 1; n < numberOfTimeSteps; n++) {
+      termsPerTimeStep[n] = numberOfTermsNeeded(n * pdeltaT);
+    }
+  }
+  numberOfTerms = *std::max_element(termsPerTimeStep.begin(),
+                                    termsPerTimeStep.end());
+
+  // Same expressions as in nextStep, so that the results do not change
+  weightTable.resize((std::size_t)numberOfTimeSteps * numberOfTerms);
+  for (int n = 0; n < numberOfTimeSteps; n++) {
+    for (int q = 0; q < numberOfTerms; q++) {
+      int m = 2 * q + 1;
+      weightTable[(std::size_t)n * numberOfTerms + q] =
+          exp(-parameters.getDiffusivity() * (m * M_PI / L) * (m * M_PI / L) *
+              n * pdeltaT) *
+          2 / (m * M_PI);
+    }
+  }
+
+  prepareSineTable(pdeltaX);
+}
+
+void ExactSolver::prepareSineTable(double pdeltaX) {
+  double L = parameters.getWidth();
+  int numberOfSpacePoints = parameters.getNumberOfSpacePoints(pdeltaX);
+  if (sinTableWidth != L || sinTableDeltaX != pdeltaX ||
+      sinTableNumberOfSpacePoints != numberOfSpacePoints ||
+      sinTableNumberOfTerms < numberOfTerms) {
+    sinTable.resize((std::size_t)numberOfTerms * numberOfSpacePoints);
+    for (int q = 0; q < numberOfTerms; q++) {
+      int m = 2 * q + 1;
+      double *sinRow = sinTable.data() + (std::size_t)q * numberOfSpacePoints;
+      for (int j = 0; j < numberOfSpacePoints; j++) {
+        sinRow[j] = sin(m * M_PI * j * pdeltaX / L);
+      }
+    }
+    sinTableWidth = L;
+    sinTableDeltaX = pdeltaX;
+    sinTableNumberOfSpacePoints = numberOfSpacePoints;
+    sinTableNumberOfTerms = numberOfTerms;
+  }
+}
+
+void ExactSolver::solveAtTimes(double pdeltaX,
+                               const std::vector<double> &times,
+                               SolutionGrid *TSolutionPtr) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  double L = parameters.getWidth();
+  int numberOfSpacePoints = parameters.getNumberOfSpacePoints(pdeltaX);
+  int numberOfTimes = times.size();
+  termsPerTimeStep.resize(numberOfTimes);
+  for (int n = 0; n < numberOfTimes; n++) {
+    // The initial state (t = 0) is not computed with the series
+    if (tolerance > 0) {
+      termsPerTimeStep[n] = (times[n] > 0) ? numberOfTermsNeeded(times[n]) : 1;
+    } else {
+      termsPerTimeStep[n] = (DEFAULT_LAST_TERM + 1) / 2;
+    }
+  }
+  numberOfTerms = numberOfTimes > 0 ? *std::max_element(
+                                          termsPerTimeStep.begin(),
+                                          termsPerTimeStep.end())
+                                    : 0;
+  weightTable.resize((std::size_t)numberOfTimes * numberOfTerms);
+  for (int n = 0; n < numberOfTimes; n++) {
+    for (int q = 0; q < numberOfTerms; q++) {
+      int m = 2 * q + 1;
+      weightTable[(std::size_t)n * numberOfTerms + q] =
+          exp(-parameters.getDiffusivity() * (m * M_PI / L) * (m * M_PI / L) *
+              times[n]) *
+          2 / (m * M_PI);
+    }
+  }
+  prepareSineTable(pdeltaX);
+
+  deltaX = pdeltaX;
+  (*TSolutionPtr).resize(numberOfTimes, numberOfSpacePoints);
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  for (int n = 0; n < numberOfTimes; n++) {
+    double *TSolutionAtOneTime = (*TSolutionPtr).row(n);
+    TSolutionAtOneTime[0] = surfaceTemperature;
+    TSolutionAtOneTime[numberOfSpacePoints - 1] = surfaceTemperature;
+    if (times[n] == 0) {
+      std::fill(TSolutionAtOneTime + 1,
+                TSolutionAtOneTime + numberOfSpacePoints - 1,
+                parameters.getInternalTemperature());
+    } else {
+      nextRow(n, nullptr, nullptr, TSolutionAtOneTime, 1,
+              numberOfSpacePoints - 1);
+    }
+  }
+}
+
+double ExactSolver::nextStep(int spaceStep, int timeStep, const double *,
+                             const double *) const {
 
   double nextStep = 0;
   double L = parameters.getWidth();
@@ -20,3 +405,30 @@ ExactSolver::nextStep(int spaceStep, int timeStep,
              parameters.getSurfaceTemperature();
   return (nextStep);
 }
+
+void ExactSolver::nextRow(int timeStep, const double *, const double *,
+                          double *TSolutionAtOneTime, int firstSpaceStep,
+                          int lastSpaceStep) const {
+  HEAT_TIMED_SCOPE("exact.rows");
+  const double *weights =
+      weightTable.data() + (std::size_t)timeStep * numberOfTerms;
+  int terms = termsPerTimeStep[timeStep];
+  double difference =
+      parameters.getInternalTemperature() - parameters.getSurfaceTemperature();
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  int numberOfBlocks =
+      (lastSpaceStep - firstSpaceStep + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::function<void(int)> computeBlock = [&](int block) {
+    int first = firstSpaceStep + block * BLOCK_SIZE;
+    int last = std::min(lastSpaceStep, first + BLOCK_SIZE);
+    seriesRow(sinTable.data(), sinTableNumberOfSpacePoints, weights, terms,
+              TSolutionAtOneTime, first, last, difference, surfaceTemperature);
+  };
+  if (lastSpaceStep - firstSpaceStep >= parallelThreshold) {
+    ThreadPool::shared().parallelFor(0, numberOfBlocks, computeBlock);
+  } else {
+    for (int block = 0; block < numberOfBlocks; block++) {
+      computeBlock(block);
+    }
+  }
+}
@@ -1,13 +1,213 @@
-
 #pragma once // Include guard
 #include "explicit_solver.h"
 #include <math.h>
+#include <string>
+#include <vector>
 
+/**
+ * @brief Analytical solution of the problem, as a Fourier series :
+ * T(x,t) = Tsur + 2 (Tin - Tsur) sum over odd m of
+ * exp(-D (m pi / L)^2 t) 2 / (m pi) sin(m pi x / L)
+ *
+ * The sine of each term at each point and the time factor of each term at
+ * each time step are computed once in tables; a time step is then the
+ * product of a row of the time table by the sine table. The sine table is
+ * kept as long as the width, deltaX and number of terms do not change.
+ */
 class ExactSolver : public ExplicitSolver {
 public:
+  /**
+   * @brief Largest m of the series when the number of terms is chosen from a
+   * tolerance
+   *
+   */
+  static const int MAXIMUM_TERM = 401;
+
+  /**
+   * @brief Largest m of the series when no tolerance is given
+   *
+   */
+  static const int DEFAULT_LAST_TERM = 61;
+
+  /**
+   * @brief Minimal number of points of a time step for it to be split between
+   * the threads of ThreadPool::shared()
+   *
+   */
+  static const int DEFAULT_PARALLEL_THRESHOLD = 4096;
+
   ExactSolver();
 
+  std::unique_ptr<AbstractSolver> clone() const override;
+
+  /**
+   * @brief Name of the scheme followed by the tolerance, if any (see
+   * setTolerance)
+   *
+   */
+  std::string getConfigurationName() const override;
+
+  /**
+   * @brief Solve the issue if all the parameters have been defined (see
+   * ExplicitSolver::solveRegularMeshes)
+   *
+   */
+  void solveRegularMeshes(double deltaX, double deltaT,
+                          SolutionGrid *TSolutionPtr) override;
+
+  /**
+   * @brief Solve the issue handing each time step to sink (see
+   * ExplicitSolver::solveStreaming)
+   *
+   */
+  void solveStreaming(double deltaX, double deltaT, RowSink sink) override;
+
+  /**
+   * @brief Compute the solution at any times, for example the ones of a
+   * solution with a variable time step (see ImplicitSolver::solveAdaptive).
+   * Row n of the grid holds the temperatures at times[n]; a time of 0 gives
+   * the initial state.
+   *
+   * Can throw an invalid_argument exception if the parameters are not
+   * initialized
+   *
+   * @param deltaX : size of the space step
+   * @param times : times of the rows
+   * @param TSolutionPtr : grid where the solution is stored
+   */
+  void solveAtTimes(double deltaX, const std::vector<double> &times,
+                    SolutionGrid *TSolutionPtr);
+
+  /**
+   * @brief Solve the issue on a mesh (see AbstractSolver::solveOnMesh). The
+   * analytical solution does not need a refinement : the mesh stays the
+   * given one.
+   *
+   */
+  void solveOnMesh(const SpaceMesh &mesh, double deltaT, MeshRowSink sink,
+                   const MeshRefinement &refinement) override;
+
+  /**
+   * @brief Compute the solution at time t on the points of a mesh, for
+   * example to measure the errors of a solve on a refined mesh
+   *
+   * Can throw an invalid_argument exception if the parameters are not
+   * initialized
+   *
+   * @param mesh : points of the wall
+   * @param t : time
+   * @param temperatures : where to store one temperature per point of mesh
+   */
+  void solveOnMeshAt(const SpaceMesh &mesh, double t, double *temperatures);
+
+  /**
+   * @brief Compute the solution at time t on a box of width x height x depth
+   * (a rectangle of width x height if depth is 0), with the surface
+   * temperature on all its faces and the internal temperature inside at t=0.
+   * The problem is separable : (T - Tsur) / (Tin - Tsur) is the product of
+   * the normalized 1D solutions across each direction, computed with the
+   * tolerance of this solver. Row k * ny + j of the grid holds the points
+   * y = j * deltaX, z = k * deltaX, with ny the number of points across the
+   * height.
+   *
+   * Can throw an invalid_argument exception if the parameters are not
+   * initialized or if height or depth are not valid
+   *
+   * @param deltaX : size of the space step, in all the directions
+   * @param height : height of the box
+   * @param depth : depth of the box, 0 for a rectangle
+   * @param t : time
+   * @param temperatures : where the solution is stored
+   */
+  void solveBoxAt(double deltaX, double height, double depth, double t,
+                  SolutionGrid *temperatures);
+
+  /**
+   * @brief Set the largest error allowed on the temperature when the series
+   * is cut. For each time step, the number of terms is the smallest one for
+   * which the remaining terms are below tolerance (up to MAXIMUM_TERM). With a
+   * tolerance of 0, the series is cut after m = DEFAULT_LAST_TERM.
+   *
+   * Can throw an invalid_argument exception if tolerance is negative
+   */
+  void setTolerance(double tolerance);
+
+  /**
+   * @brief Set the minimal number of points of a time step for it to be
+   * computed by several threads. The results do not depend on it.
+   *
+   */
+  void setParallelThreshold(int numberOfPoints);
+
 protected:
-  double nextStep(int spaceStep, int timeStep,
-                  std::vector<std::vector<double> > *TSolution) const override;
+  double nextStep(int spaceStep, int timeStep, const double *previousTimeStep,
+                  const double *beforePreviousTimeStep) const override;
+
+  void nextRow(int timeStep, const double *previousTimeStep,
+               const double *beforePreviousTimeStep,
+               double *TSolutionAtOneTime, int firstSpaceStep,
+               int lastSpaceStep) const override;
+
+private:
+  double tolerance = 0;
+  int parallelThreshold = DEFAULT_PARALLEL_THRESHOLD;
+
+  /**
+   * @brief sinTable[q * numberOfSpacePoints + j] = sin(m pi j deltaX / L)
+   * with m = 2q + 1
+   *
+   */
+  std::vector<double> sinTable;
+  /**
+   * @brief width, deltaX, number of points and of terms of sinTable
+   *
+   */
+  double sinTableWidth = 0, sinTableDeltaX = 0;
+  int sinTableNumberOfSpacePoints = 0, sinTableNumberOfTerms = 0;
+
+  /**
+   * @brief weightTable[n * numberOfTerms + q] = exp(-D (m pi / L)^2 n deltaT)
+   * 2 / (m pi) with m = 2q + 1
+   *
+   */
+  std::vector<double> weightTable;
+  /**
+   * @brief number of terms used at each time step
+   *
+   */
+  std::vector<int> termsPerTimeStep;
+  int numberOfTerms = 0;
+
+  /**
+   * @brief meshSinTable[q * number of points + j] = sin(m pi x(j) / L) with
+   * m = 2q + 1 for the points of meshSinTableMesh, and number of terms of
+   * the table
+   *
+   */
+  std::vector<double> meshSinTable;
+  SpaceMesh meshSinTableMesh;
+  double meshSinTableWidth = 0;
+  int meshSinTableNumberOfTerms = 0;
+
+  /**
+   * @brief Number of terms of the series needed at time t to stay below the
+   * tolerance
+   *
+   */
+  int numberOfTermsNeeded(double t) const;
+
+  /**
+   * @brief Compute the tables for a grid, keeping the sine table if it is
+   * still valid
+   *
+   * Can throw an invalid_argument exception if the parameters are not
+   * initialized
+   */
+  void prepareTables(double deltaX, double deltaT);
+
+  /**
+   * @brief Compute the sine table for a grid if it is not valid anymore
+   *
+   */
+  void prepareSineTable(double deltaX);
 };
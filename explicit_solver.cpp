@@ -1,64 +1,258 @@
 #include "explicit_solver.h"
 #include "crank-nicholson_solver.h"
 #include "exact_solver.h"
+#include "instrumentation.h"
 #include "laasonen_simple_implicit_solver.h"
+#include "thread_pool.h"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <unistd.h>
 #include <vector>
 
-ExplicitSolver::ExplicitSolver() { firstStepSolver = &defaultFirstStepSolver; };
+namespace {
+/**
+ * @brief Size in bytes of the second level data cache, or a common value if
+ * the system does not give it
+ */
+std::size_t secondLevelCacheSize() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (size > 0) {
+    return (std::size_t)size;
+  }
+#endif
+  return 256 * 1024;
+}
+} // namespace
+
+ExplicitSolver::ExplicitSolver() {
+  firstStepSolver = &defaultFirstStepSolver;
+  firstStepCache = nullptr;
+};
+
+void ExplicitSolver::solveRegularMeshes(double pdeltaX, double pdeltaT,
+                                        SolutionGrid *TSolutionPtr) {
+  solveInGrid(pdeltaX, pdeltaT, TSolutionPtr, false, RowSink());
+};
+
+void ExplicitSolver::solveStreaming(double pdeltaX, double pdeltaT,
+                                    RowSink sink) {
+  SolutionGrid window;
+  solveInGrid(pdeltaX, pdeltaT, &window, true, sink);
+};
 
-void ExplicitSolver::solveRegularMeshes(
-    double pdeltaX, double pdeltaT,
-    std::vector<std::vector<double> > *TSolutionPtr) {
+void ExplicitSolver::solveInGrid(double pdeltaX, double pdeltaT,
+                                 SolutionGrid *storage, bool rollingWindow,
+                                 RowSink sink) {
   if (!parameters.checkInitialization()) {
     throw(std::invalid_argument(
         "Parameters have not yet been properly initialized"));
   }
 
-  // variable used to store the solution at a step in time while we are still
-  // computing it
   deltaX = pdeltaX;
   deltaT = pdeltaT;
   int numberOfSpacePoints = (int)(parameters.getWidth() / deltaX) + 1;
-  std::vector<double> TSolutionAtOneTime(numberOfSpacePoints);
+  // With a rolling window, only the time steps needed by the scheme are
+  // kept : time step n is stored in row n % numberOfLevels
+  int numberOfLevels = threeLevelScheme ? 3 : 2;
+  (*storage).resize(rollingWindow
+                        ? numberOfLevels
+                        : std::max(computeNumberOfTimeSteps(),
+                                   threeLevelScheme ? 2 : 1),
+                    numberOfSpacePoints);
 
   if (threeLevelScheme) {
-    computeFirstStep(TSolutionPtr);
+    computeFirstStep((*storage).row(0), (*storage).row(1));
+    if (sink) {
+      sink(0, (*storage).row(0), numberOfSpacePoints);
+      sink(1, (*storage).row(1), numberOfSpacePoints);
+    }
   } else {
     // For t=0, we calculate the initial state of each point and store it
+    fillInitialState(parameters, (*storage).row(0), numberOfSpacePoints);
+    if (sink) {
+      sink(0, (*storage).row(0), numberOfSpacePoints);
+    }
+  }
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HEAT_TIMED_SCOPE("explicit.time_steps");
+  int firstTimeIndex = threeLevelScheme ? 2 : 1;
+  int numberOfTimeSteps = computeNumberOfTimeSteps();
+  // using the explicit scheme implemented in nextRow
+  auto row = [this](int timeIndex, const double *previousTimeStep,
+                    const double *beforePreviousTimeStep,
+                    double *TSolutionAtOneTime, int firstSpaceStep,
+                    int lastSpaceStep) {
+    nextRow(timeIndex, previousTimeStep, beforePreviousTimeStep,
+            TSolutionAtOneTime, firstSpaceStep, lastSpaceStep);
+  };
+  int selectedTileWidth, selectedLevelsPerTile;
+  if (!rollingWindow && selectTiles(numberOfSpacePoints, &selectedTileWidth,
+                                    &selectedLevelsPerTile)) {
+    advanceByTiles(storage, firstTimeIndex, numberOfTimeSteps,
+                   selectedTileWidth, selectedLevelsPerTile,
+                   parameters.getSurfaceTemperature(), threeLevelScheme, row,
+                   sink);
+  } else {
+    advanceRowByRow(storage, firstTimeIndex, numberOfTimeSteps,
+                    parameters.getSurfaceTemperature(), threeLevelScheme, row,
+                    sink);
+  }
+  int numberOfSteps = std::max(numberOfTimeSteps - firstTimeIndex, 0);
+  HEAT_COUNT("explicit.steps", numberOfSteps);
+  recordStepRate(numberOfSteps, start);
+};
 
-    std::fill(TSolutionAtOneTime.begin(), TSolutionAtOneTime.end(),
-              parameters.getInternalTemperature());
+void ExplicitSolver::solveOnMesh(const SpaceMesh &mesh, double pdeltaT,
+                                 MeshRowSink sink,
+                                 const MeshRefinement &refinement) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  deltaT = pdeltaT;
+  SpaceMesh currentMesh = initialMesh(mesh, refinement);
+  int numberOfSpacePoints = currentMesh.getNumberOfPoints();
+  // Time step n is stored in levels[n % numberOfLevels]
+  int numberOfLevels = threeLevelScheme ? 3 : 2;
+  std::vector<std::vector<double>> levels(numberOfLevels);
+  initialStateOnMesh(currentMesh, &levels[0]);
+  if (sink) {
+    sink(0, currentMesh, levels[0].data());
+  }
+  int firstTimeIndex = 1;
+  if (threeLevelScheme) {
+    levels[1].resize(numberOfSpacePoints);
+    computeFirstStepOnMesh(currentMesh, levels[1].data());
+    if (sink) {
+      sink(1, currentMesh, levels[1].data());
+    }
+    firstTimeIndex = 2;
+  }
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HEAT_TIMED_SCOPE("explicit.mesh_time_steps");
+  int numberOfSteps = 0;
+  for (int timeIndex = firstTimeIndex;
+       (timeIndex * deltaT) <= (parameters.getTimeStop()); timeIndex++) {
+    numberOfSpacePoints = currentMesh.getNumberOfPoints();
+    std::vector<double> &TSolutionAtOneTime =
+        levels[timeIndex % numberOfLevels];
+    const std::vector<double> &previousTimeStep =
+        levels[(timeIndex - 1) % numberOfLevels];
+    const double *beforePreviousTimeStep =
+        threeLevelScheme ? levels[(timeIndex - 2) % numberOfLevels].data()
+                         : nullptr;
+    TSolutionAtOneTime.resize(numberOfSpacePoints);
     TSolutionAtOneTime[0] = parameters.getSurfaceTemperature();
+    nextRowOnMesh(currentMesh, previousTimeStep.data(), beforePreviousTimeStep,
+                  TSolutionAtOneTime.data(), 1, numberOfSpacePoints - 1);
     TSolutionAtOneTime[numberOfSpacePoints - 1] =
         parameters.getSurfaceTemperature();
-    (*TSolutionPtr).push_back(TSolutionAtOneTime);
-  }
-  // For the other time steps :
-  for (int timeIndex = (threeLevelScheme ? 2 : 1);
-       (timeIndex * deltaT) <= (parameters.getTimeStop()); timeIndex++) {
-    TSolutionAtOneTime.clear();
-    // using left boundary condition to get the first value
-    TSolutionAtOneTime.push_back(parameters.getSurfaceTemperature());
-    // using the explicit scheme implemented in nextStep to get the values
-    // from the middle
-    for (int spaceIndex = 1; spaceIndex < numberOfSpacePoints - 1;
-         spaceIndex++) {
-      TSolutionAtOneTime.push_back(
-          nextStep(spaceIndex, timeIndex, TSolutionPtr));
+    if (sink) {
+      sink(timeIndex, currentMesh, TSolutionAtOneTime.data());
     }
-    // using right boundary condition to get the last value
-    TSolutionAtOneTime.push_back(parameters.getSurfaceTemperature());
+    numberOfSteps++;
 
-    (*TSolutionPtr).push_back(TSolutionAtOneTime);
-  };
+    if (refinement.isDue(timeIndex)) {
+      SpaceMesh refinedMesh =
+          refinement.refine(currentMesh, TSolutionAtOneTime.data());
+      if (refinedMesh != currentMesh) {
+        HEAT_COUNT("mesh.refinements", 1);
+        // The levels still needed by the scheme are moved to the new mesh
+        std::vector<double> interpolated(refinedMesh.getNumberOfPoints());
+        for (int level = 0; level < numberOfLevels - 1; level++) {
+          std::vector<double> &values =
+              levels[(timeIndex - level) % numberOfLevels];
+          refinedMesh.interpolate(currentMesh, values.data(),
+                                  interpolated.data());
+          values = interpolated;
+        }
+        currentMesh = refinedMesh;
+      }
+    }
+  }
+  HEAT_COUNT("explicit.steps", numberOfSteps);
+  recordStepRate(numberOfSteps, start);
+}
 
-  // Add a two-step boolean member to the explicit class.
-};
+bool ExplicitSolver::selectTiles(int numberOfSpacePoints, int *ptileWidth,
+                                 int *plevelsPerTile) const {
+  if (!temporalBlocking) {
+    return false;
+  }
+  std::size_t cacheSize = secondLevelCacheSize();
+  // Row by row, the rows read by the scheme already stay in cache
+  std::size_t rowsSize = 3 * (std::size_t)numberOfSpacePoints * sizeof(double);
+  if (tileWidth == AUTOMATIC && rowsSize <= cacheSize / 2) {
+    return false;
+  }
+  *plevelsPerTile =
+      (levelsPerTile == AUTOMATIC) ? DEFAULT_LEVELS_PER_TILE : levelsPerTile;
+  if (tileWidth == AUTOMATIC) {
+    // The levels of a tile, and the two levels before it, should fit in half
+    // of the cache
+    std::size_t tileRowsSize = (*plevelsPerTile + 2) * sizeof(double);
+    *ptileWidth = std::max((int)(cacheSize / 2 / tileRowsSize),
+                           4 * (*plevelsPerTile));
+  } else {
+    *ptileWidth = tileWidth;
+  }
+  return true;
+}
 
-void ExplicitSolver::computeFirstStep(
-    std::vector<std::vector<double> > *TSolutionPtr) {
+void ExplicitSolver::nextRow(int timeStep, const double *previousTimeStep,
+                             const double *beforePreviousTimeStep,
+                             double *TSolutionAtOneTime, int firstSpaceStep,
+                             int lastSpaceStep) const {
+  for (int spaceIndex = firstSpaceStep; spaceIndex < lastSpaceStep;
+       spaceIndex++) {
+    TSolutionAtOneTime[spaceIndex] = nextStep(
+        spaceIndex, timeStep, previousTimeStep, beforePreviousTimeStep);
+  }
+}
+
+void ExplicitSolver::nextRowOnMesh(const SpaceMesh &, const double *,
+                                   const double *, double *, int, int) const {
+  throw(std::logic_error("the " + schemeName +
+                         " scheme cannot be used on a mesh"));
+}
+
+void ExplicitSolver::computeFirstStep(double *initialStep, double *firstStep) {
+  // Includes the solves of the first step solver (and their own timers), or
+  // the wait for another thread computing the same first steps
+  HEAT_TIMED_SCOPE("explicit.first_step");
 
+  std::shared_ptr<const FirstSteps> firstSteps;
+  if (firstStepCache == nullptr) {
+    std::shared_ptr<FirstSteps> computed(new FirstSteps());
+    solveFirstSteps(computed.get());
+    firstSteps = computed;
+  } else {
+    FirstStepCache::Key key = {(*firstStepSolver).getConfigurationName(),
+                               parameters.getDiffusivity(),
+                               parameters.getSurfaceTemperature(),
+                               parameters.getInternalTemperature(),
+                               parameters.getWidth(),
+                               deltaX,
+                               deltaT,
+                               withRichardsonsExtrapolation};
+    firstSteps = (*firstStepCache)
+                     .get(key, [this](FirstSteps *computed) {
+                       solveFirstSteps(computed);
+                     });
+  }
+  std::copy((*firstSteps).initialStep.begin(),
+            (*firstSteps).initialStep.end(), initialStep);
+  std::copy((*firstSteps).firstStep.begin(), (*firstSteps).firstStep.end(),
+            firstStep);
+}
+
+void ExplicitSolver::solveFirstSteps(FirstSteps *firstSteps) {
   HeatDiffusionParameters firstStepParameters =
       HeatDiffusionParameters(parameters);
   firstStepParameters.setTimeLimit(1 * deltaT);
@@ -67,26 +261,77 @@ void ExplicitSolver::computeFirstStep(
   if (withRichardsonsExtrapolation) {
     // Computing with a Richardson Extrapolation Tc = 4/3 Tb - Ta/3. Working for
     // FTCS explicit, Laasonen, Cranck-Nicholson
-    std::vector<std::vector<double> > TSolutionGridA, TSolutionGridB;
-    std::vector<double> TSolutionOneStep;
-    (*firstStepSolver).solveRegularMeshes(deltaX, deltaT, &TSolutionGridA);
-    (*firstStepSolver)
-        .solveRegularMeshes(deltaX / 2, deltaT / 4, &TSolutionGridB);
+    // Both grids are independent : grid B is solved by a clone at the same
+    // time as grid A
+    std::unique_ptr<AbstractSolver> gridBSolver = (*firstStepSolver).clone();
+    (*gridBSolver).setParameters(firstStepParameters);
+    SolutionGrid TSolutionGridA, TSolutionGridB;
+    ThreadPool::shared().parallelFor(0, 2, [&](int grid) {
+      if (grid == 0) {
+        (*firstStepSolver).solveRegularMeshes(deltaX, deltaT, &TSolutionGridA);
+      } else {
+        (*gridBSolver)
+            .solveRegularMeshes(deltaX / 2, deltaT / 4, &TSolutionGridB);
+      }
+    });
 
     // Getting initial state for t=0 from grid A:
-    (*TSolutionPtr).push_back(TSolutionGridA[0]);
+    int numberOfSpacePoints = (int)((parameters).getWidth() / deltaX) + 1;
+    (*firstSteps)
+        .initialStep.assign(TSolutionGridA.row(0),
+                            TSolutionGridA.row(0) + numberOfSpacePoints);
 
     // Getting richardson extrapolation for t=DeltaT;
-    int numberOfSpacePoints = (int)((parameters).getWidth() / deltaX) + 1;
-    for (int j = 0; j < numberOfSpacePoints; j++) {
-      TSolutionOneStep.push_back(
-          (4 * TSolutionGridB.back()[2 * j] - TSolutionGridA.back()[j]) / 3);
-    }
-    (*TSolutionPtr).push_back(TSolutionOneStep);
+    (*firstSteps).firstStep.resize(numberOfSpacePoints);
+    extrapolateFirstStep(TSolutionGridA.lastRow(), TSolutionGridB.lastRow(),
+                         (*firstSteps).firstStep.data(), numberOfSpacePoints);
   }
   // Computing without Richarson Extrapolation
   else {
-    (*firstStepSolver).solveRegularMeshes(deltaX, deltaT, TSolutionPtr);
+    SolutionGrid TSolutionGrid;
+    (*firstStepSolver).solveRegularMeshes(deltaX, deltaT, &TSolutionGrid);
+    int numberOfSpacePoints = TSolutionGrid.getNumberOfColumns();
+    (*firstSteps)
+        .initialStep.assign(TSolutionGrid.row(0),
+                            TSolutionGrid.row(0) + numberOfSpacePoints);
+    (*firstSteps)
+        .firstStep.assign(TSolutionGrid.row(1),
+                          TSolutionGrid.row(1) + numberOfSpacePoints);
+  }
+}
+
+void ExplicitSolver::computeFirstStepOnMesh(const SpaceMesh &mesh,
+                                            double *firstStep) {
+  HEAT_TIMED_SCOPE("explicit.first_step");
+
+  HeatDiffusionParameters firstStepParameters =
+      HeatDiffusionParameters(parameters);
+  firstStepParameters.setTimeLimit(1 * deltaT);
+  (*firstStepSolver).setParameters(firstStepParameters);
+  int numberOfSpacePoints = mesh.getNumberOfPoints();
+  // The first step solver is not refined : its last time step is on its mesh
+  auto keepLastStep = [](std::vector<double> *lastStep) {
+    return [lastStep](int, const SpaceMesh &stepMesh,
+                      const double *temperatures) {
+      (*lastStep).assign(temperatures,
+                         temperatures + stepMesh.getNumberOfPoints());
+    };
+  };
+
+  std::vector<double> TLastStepA;
+  (*firstStepSolver)
+      .solveOnMesh(mesh, deltaT, keepLastStep(&TLastStepA), MeshRefinement());
+  if (withRichardsonsExtrapolation) {
+    // Richardson Extrapolation Tc = 4/3 Tb - Ta/3, Tb being computed with
+    // deltaT / 4 on the mesh with every step halved
+    std::vector<double> TLastStepB;
+    (*firstStepSolver)
+        .solveOnMesh(mesh.halved(), deltaT / 4, keepLastStep(&TLastStepB),
+                     MeshRefinement());
+    extrapolateFirstStep(TLastStepA.data(), TLastStepB.data(), firstStep,
+                         numberOfSpacePoints);
+  } else {
+    std::copy(TLastStepA.begin(), TLastStepA.end(), firstStep);
   }
 }
 
@@ -96,4 +341,42 @@ void ExplicitSolver::setFirstStepSolver(AbstractSolver *solver,
   withRichardsonsExtrapolation = useRichardsonsExtrapolation;
 };
 
+void ExplicitSolver::setFirstStepCache(FirstStepCache *cache) {
+  firstStepCache = cache;
+};
+
+std::string ExplicitSolver::getConfigurationName() const {
+  if (!threeLevelScheme) {
+    return schemeName;
+  }
+  return schemeName + " (first step " +
+         (*firstStepSolver).getConfigurationName() +
+         (withRichardsonsExtrapolation ? " with" : " without") +
+         " Richardson's extrapolation)";
+};
+
+void ExplicitSolver::copySettingsTo(ExplicitSolver *solver) const {
+  (*solver).setTemporalBlocking(temporalBlocking, tileWidth, levelsPerTile);
+  (*solver).setFirstStepCache(firstStepCache);
+  if (firstStepSolver == &defaultFirstStepSolver) {
+    (*solver).setFirstStepSolver(&(*solver).defaultFirstStepSolver,
+                                 withRichardsonsExtrapolation);
+  } else {
+    (*solver).clonedFirstStepSolver = (*firstStepSolver).clone();
+    (*solver).setFirstStepSolver((*solver).clonedFirstStepSolver.get(),
+                                 withRichardsonsExtrapolation);
+  }
+};
+
+void ExplicitSolver::setTemporalBlocking(bool enabled, int ptileWidth,
+                                         int plevelsPerTile) {
+  if (ptileWidth < 0 || plevelsPerTile < 0) {
+    throw(std::invalid_argument(
+        "tile width and levels per tile should be positive"));
+  }
+  temporalBlocking = enabled;
+  tileWidth = ptileWidth;
+  levelsPerTile = plevelsPerTile;
+};
+
 ExplicitSolver::~ExplicitSolver(){};
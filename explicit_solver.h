@@ -1,6 +1,10 @@
 #pragma once // Include guard
 #include "abstract_solver.h"
+#include "first_step_cache.h"
 #include "laasonen_simple_implicit_solver.h"
+#include "solver_engine.h"
+#include <memory>
+#include <string>
 
 class ExplicitSolver : public AbstractSolver {
   typedef void (ExplicitSolver::*ptrMethod)();
@@ -9,12 +13,54 @@ protected:
   /**
    * @brief Calculate the next point in space with the explicit scheme
    *
-   * @param k position of the step in the array where the new value has to be
-   * calculated
+   * @param spaceStep : position of the point in space
+   * @param timeStep : position of the point in time
+   * @param previousTimeStep : temperatures at timeStep - 1
+   * @param beforePreviousTimeStep : temperatures at timeStep - 2, only valid
+   * for three level schemes
    */
-  virtual double
-  nextStep(int spaceStep, int timeStep,
-           std::vector<std::vector<double> > *TSolution) const = 0;
+  virtual double nextStep(int spaceStep, int timeStep,
+                          const double *previousTimeStep,
+                          const double *beforePreviousTimeStep) const = 0;
+
+  /**
+   * @brief Calculate the points [firstSpaceStep, lastSpaceStep) of a new time
+   * step with the explicit scheme. The default implementation calls nextStep
+   * for each point; schemes can override it with a kernel working on the whole
+   * row at once.
+   *
+   * @param timeStep : position of the new time step
+   * @param previousTimeStep : temperatures at timeStep - 1
+   * @param beforePreviousTimeStep : temperatures at timeStep - 2, only valid
+   * for three level schemes
+   * @param TSolutionAtOneTime : where to store the new temperatures
+   * @param firstSpaceStep : first point to compute
+   * @param lastSpaceStep : point after the last one to compute
+   */
+  virtual void nextRow(int timeStep, const double *previousTimeStep,
+                       const double *beforePreviousTimeStep,
+                       double *TSolutionAtOneTime, int firstSpaceStep,
+                       int lastSpaceStep) const;
+  /**
+   * @brief Calculate the points [firstSpaceStep, lastSpaceStep) of a new time
+   * step on a mesh that is not necessarily evenly spaced (see
+   * SpaceMesh). The default implementation throws a logic_error exception,
+   * for the schemes that have no such version.
+   *
+   * @param mesh : mesh of the time steps
+   * @param previousTimeStep : temperatures at timeStep - 1
+   * @param beforePreviousTimeStep : temperatures at timeStep - 2, only valid
+   * for three level schemes
+   * @param TSolutionAtOneTime : where to store the new temperatures
+   * @param firstSpaceStep : first point to compute
+   * @param lastSpaceStep : point after the last one to compute
+   */
+  virtual void nextRowOnMesh(const SpaceMesh &mesh,
+                             const double *previousTimeStep,
+                             const double *beforePreviousTimeStep,
+                             double *TSolutionAtOneTime, int firstSpaceStep,
+                             int lastSpaceStep) const;
+
   /**
    * @brief boolean to store if the explicit scheme is a three level scheme or
    * not
@@ -43,15 +89,145 @@ protected:
   LaasonenSolver defaultFirstStepSolver;
 
   /**
-   * @brief Compute the second level of data for three level scheme using
+   * @brief First step solver created by clone(), when the cloned solver
+   * does not use its default one
+   *
+   */
+  std::unique_ptr<AbstractSolver> clonedFirstStepSolver;
+
+  /**
+   * @brief Cache of the first steps, nullptr if they are always computed
+   *
+   */
+  FirstStepCache *firstStepCache;
+
+  /**
+   * @brief Compute the first two levels of data for three level scheme using
    * firstStepSolver and richardson's extrapolation according to the boolean
-   * withRichardsonsExtrapolation
+   * withRichardsonsExtrapolation. They are taken from firstStepCache when
+   * they have already been computed for the same first step solver, problem
+   * and grid.
+   *
+   * @param initialStep : where to store the temperatures at t=0
+   * @param firstStep : where to store the temperatures at t=deltaT
+   */
+  void computeFirstStep(double *initialStep, double *firstStep);
+
+  /**
+   * @brief Compute the first two levels of data as computeFirstStep does,
+   * without the cache. With the Richardson's extrapolation, the two grids are
+   * solved at once on the threads of ThreadPool::shared(), the finer one by a
+   * clone of firstStepSolver.
+   *
+   * @param firstSteps : where to store the temperatures at t=0 and t=deltaT
+   */
+  void solveFirstSteps(FirstSteps *firstSteps);
+
+  /**
+   * @brief Compute the temperatures at t=deltaT on a mesh with
+   * firstStepSolver, as computeFirstStep does on a regular mesh. The
+   * Richardson's extrapolation uses the mesh with every step halved.
+   *
+   * @param mesh : mesh of the first time step
+   * @param firstStep : where to store the temperatures at t=deltaT
+   */
+  void computeFirstStepOnMesh(const SpaceMesh &mesh, double *firstStep);
+
+  /**
+   * @brief Solve the issue storing the time steps in storage and handing
+   * them to sink (if any) once computed.
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param storage : grid where the time steps are computed. It holds all
+   * the time steps, or only the ones needed by the scheme if rollingWindow is
+   * true
+   * @param rollingWindow : whether storage is used as a rolling window
+   * @param sink : function called with each time step, can be empty
+   */
+  virtual void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                           bool rollingWindow, RowSink sink);
+
+  /**
+   * @brief Implementation of solveInGrid for the schemes having a policy in
+   * the scheme namespace : the time steps are computed by engine, with the
+   * first steps of computeFirstStep and the tiles of selectTiles
+   *
+   */
+  template <class Scheme>
+  void solveInGridWithEngine(SolverEngine<Scheme> *engine, double pdeltaX,
+                             double pdeltaT, SolutionGrid *storage,
+                             bool rollingWindow, RowSink sink) {
+    (*engine).setParameters(parameters);
+    deltaX = pdeltaX;
+    deltaT = pdeltaT;
+    int selectedTileWidth, selectedLevelsPerTile;
+    if (!selectTiles(parameters.getNumberOfSpacePoints(deltaX),
+                     &selectedTileWidth, &selectedLevelsPerTile)) {
+      selectedTileWidth = 0;
+      selectedLevelsPerTile = 0;
+    }
+    (*engine).setTiles(selectedTileWidth, selectedLevelsPerTile);
+    (*engine).setFirstStep([this](double *initialStep, double *firstStep) {
+      computeFirstStep(initialStep, firstStep);
+    });
+    (*engine).solveInGrid(deltaX, deltaT, storage, rollingWindow, sink);
+    stepsPerSecond = (*engine).getStepsPerSecond();
+  }
+
+  /**
+   * @brief whether the time steps can be computed by tiles (see
+   * setTemporalBlocking)
+   *
+   */
+  bool temporalBlocking = true;
+
+  /**
+   * @brief number of points of a tile at each level, or AUTOMATIC
    *
-   * @param TSolutionPtr
    */
-  void computeFirstStep(std::vector<std::vector<double> > *TSolutionPtr);
+  int tileWidth = AUTOMATIC;
+
+  /**
+   * @brief number of time levels computed by a tile, or AUTOMATIC
+   *
+   */
+  int levelsPerTile = AUTOMATIC;
+
+  /**
+   * @brief Decide whether a grid with numberOfSpacePoints points per time step
+   * should be computed by tiles, and with which sizes
+   *
+   * @param numberOfSpacePoints : number of points of each time step
+   * @param tileWidth : where to store the number of points of a tile
+   * @param levelsPerTile : where to store the number of levels of a tile
+   * @return true if tiles should be used
+   */
+  bool selectTiles(int numberOfSpacePoints, int *tileWidth,
+                   int *levelsPerTile) const;
+
+  /**
+   * @brief Copy the settings of this solver to solver, for clone(). A first
+   * step solver other than the default one is cloned too, so that both
+   * solvers can be used at once.
+   *
+   */
+  void copySettingsTo(ExplicitSolver *solver) const;
 
 public:
+  /**
+   * @brief Value of the tile sizes letting the solver choose them from the
+   * size of the second level cache
+   *
+   */
+  static const int AUTOMATIC = 0;
+
+  /**
+   * @brief Number of time levels of a tile when it is chosen automatically
+   *
+   */
+  static const int DEFAULT_LEVELS_PER_TILE = 16;
+
   /**
    * @brief Solve the issue if all the parameters have been defined
    *
@@ -60,12 +236,31 @@ public:
    *
    * @param deltaX : size if the space step
    * @param deltaT : size of the time step
+   * @param TSolutionPtr : grid where the solution is stored
+   */
+  void solveRegularMeshes(double deltaX, double deltaT,
+                          SolutionGrid *TSolutionPtr) override;
+
+  /**
+   * @brief Solve the issue keeping only the two (or three for three level
+   * schemes) last time steps in memory. Each time step is handed to sink once
+   * computed.
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order
+   */
+  void solveStreaming(double deltaX, double deltaT, RowSink sink) override;
+
+  /**
+   * @brief Solve the issue on a mesh (see AbstractSolver::solveOnMesh) with
+   * the version of the scheme given by nextRowOnMesh. When the refinement
+   * changes the mesh, the two previous time steps are interpolated on the
+   * new one.
    *
-   * @return std::vector<std::vector<double>>
    */
-  void
-  solveRegularMeshes(double deltaX, double deltaT,
-                     std::vector<std::vector<double> > *TSolutionPtr) override;
+  void solveOnMesh(const SpaceMesh &mesh, double deltaT, MeshRowSink sink,
+                   const MeshRefinement &refinement) override;
 
   /**
    * @brief Set the solver to compute the first step and if it should use a
@@ -79,6 +274,37 @@ public:
   void setFirstStepSolver(AbstractSolver *solver,
                           bool useRichardsonsExtrapolation);
 
+  /**
+   * @brief Set the cache where the first steps of three-level schemes are
+   * looked up before being computed, nullptr (no cache) by default.
+   *
+   * @param cache : cache to use, or nullptr to always compute the first steps
+   */
+  void setFirstStepCache(FirstStepCache *cache);
+
+  /**
+   * @brief Name of the scheme, followed for three-level schemes by the first
+   * step solver and whether it uses the Richardson's extrapolation
+   *
+   */
+  std::string getConfigurationName() const override;
+
+  /**
+   * @brief Set how the time steps are computed when the whole solution is
+   * stored (solveRegularMeshes). With temporal blocking, several time levels
+   * are computed on a part of the wall while it stays in cache; the results
+   * are the same as row by row. With an AUTOMATIC tile width, tiles are only
+   * used when the rows do not fit in the second level cache.
+   *
+   * Can throw an invalid_argument exception if a size is negative
+   *
+   * @param enabled : whether tiles can be used
+   * @param tileWidth : number of points of a tile at each level, or AUTOMATIC
+   * @param levelsPerTile : number of time levels of a tile, or AUTOMATIC
+   */
+  void setTemporalBlocking(bool enabled, int tileWidth = AUTOMATIC,
+                           int levelsPerTile = AUTOMATIC);
+
   /**
    * @brief Construct a new Explicit Solve object
    *
@@ -0,0 +1,110 @@
+#include "first_step_cache.h"
+#include "instrumentation.h"
+#include <tuple>
+#include <utility>
+
+FirstStepCache::FirstStepCache(std::size_t pmaximumSize)
+    : maximumSize(pmaximumSize) {}
+
+bool FirstStepCache::Key::operator<(const Key &other) const {
+  return std::tie(firstStepSolver, diffusivity, surfaceTemperature,
+                  internalTemperature, width, deltaX, deltaT,
+                  withRichardsonsExtrapolation) <
+         std::tie(other.firstStepSolver, other.diffusivity,
+                  other.surfaceTemperature, other.internalTemperature,
+                  other.width, other.deltaX, other.deltaT,
+                  other.withRichardsonsExtrapolation);
+}
+
+std::shared_ptr<const FirstSteps>
+FirstStepCache::get(const Key &key,
+                    const std::function<void(FirstSteps *)> &compute) {
+  std::promise<std::shared_ptr<const FirstSteps>> promise;
+  std::unique_lock<std::mutex> lock(mutex);
+  std::map<Key, Entry>::iterator entry = entries.find(key);
+  if (entry != entries.end()) {
+    numberOfHits++;
+    HEAT_COUNT("first_step.cache_hits", 1);
+    usageOrder.splice(usageOrder.end(), usageOrder, (*entry).second.usage);
+    std::shared_future<std::shared_ptr<const FirstSteps>> found =
+        (*entry).second.firstSteps;
+    lock.unlock();
+    // Waits if another thread is still computing these first steps
+    return found.get();
+  }
+  long long computation = ++numberOfComputations;
+  HEAT_COUNT("first_step.computations", 1);
+  Entry added = {promise.get_future().share(), computation, 0,
+                 usageOrder.insert(usageOrder.end(), key)};
+  entries.insert(std::make_pair(key, added));
+  lock.unlock();
+
+  std::shared_ptr<FirstSteps> firstSteps;
+  try {
+    firstSteps.reset(new FirstSteps());
+    compute(firstSteps.get());
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    lock.lock();
+    // Unless it has been evicted or cleared meanwhile, the entry is removed
+    // so that the next call computes the first steps again
+    entry = entries.find(key);
+    if (entry != entries.end() && (*entry).second.computation == computation) {
+      usageOrder.erase((*entry).second.usage);
+      entries.erase(entry);
+    }
+    throw;
+  }
+  promise.set_value(firstSteps);
+
+  lock.lock();
+  // Unless it has been evicted or cleared meanwhile, the entry is counted in
+  // the size of the cache
+  entry = entries.find(key);
+  if (entry != entries.end() && (*entry).second.computation == computation) {
+    (*entry).second.size =
+        ((*firstSteps).initialStep.size() + (*firstSteps).firstStep.size()) *
+        sizeof(double);
+    size += (*entry).second.size;
+    evict();
+  }
+  return firstSteps;
+}
+
+void FirstStepCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  usageOrder.clear();
+  size = 0;
+}
+
+void FirstStepCache::evict() {
+  while (size > maximumSize && !usageOrder.empty()) {
+    // The threads using or waiting for the least recently used entry keep
+    // their own copy of it
+    std::map<Key, Entry>::iterator entry = entries.find(usageOrder.front());
+    size -= (*entry).second.size;
+    entries.erase(entry);
+    usageOrder.pop_front();
+  }
+}
+
+long long FirstStepCache::getNumberOfComputations() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfComputations;
+}
+
+long long FirstStepCache::getNumberOfHits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfHits;
+}
+
+std::size_t FirstStepCache::getSize() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return size;
+}
+
+FirstStepCache &FirstStepCache::shared() {
+  static FirstStepCache cache;
+  return cache;
+}
@@ -0,0 +1,147 @@
+#pragma once // Include guard
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief First two time steps of a three-level scheme, as computed by
+ * ExplicitSolver::computeFirstStep
+ *
+ */
+struct FirstSteps {
+  std::vector<double> initialStep;
+  std::vector<double> firstStep;
+};
+
+/**
+ * @brief First steps already computed, shared by the three-level solvers
+ *
+ * The first steps do not depend on the three-level scheme nor on the time
+ * limit, only on the first step solver, the problem and the grid : a
+ * Richardson and a Dufort-Frankel solve on the same grid, or several solves
+ * differing only by their time limit, need a single computation.
+ *
+ * The cache can be used by several threads at once. When several threads
+ * ask for a first step that is not computed yet, only the first one computes
+ * it and the others wait for its result. The first steps kept are bounded
+ * to maximumSize bytes : once a computation is done, the least recently used
+ * first steps are removed until the total size fits. First steps larger than
+ * maximumSize are returned but not kept.
+ */
+class FirstStepCache {
+public:
+  /**
+   * @brief Everything the first steps depend on
+   *
+   */
+  struct Key {
+    /**
+     * @brief AbstractSolver::getConfigurationName() of the first step solver
+     *
+     */
+    std::string firstStepSolver;
+    double diffusivity;
+    double surfaceTemperature;
+    double internalTemperature;
+    double width;
+    double deltaX;
+    double deltaT;
+    bool withRichardsonsExtrapolation;
+
+    bool operator<(const Key &other) const;
+  };
+
+  /**
+   * @brief Default maximum size of the first steps kept : 256 MiB
+   *
+   */
+  static const std::size_t DEFAULT_MAXIMUM_SIZE = std::size_t(1) << 28;
+
+  /**
+   * @brief Create an empty cache
+   *
+   * @param pmaximumSize : maximum total size of the first steps kept, in
+   * bytes
+   */
+  explicit FirstStepCache(std::size_t pmaximumSize = DEFAULT_MAXIMUM_SIZE);
+
+  /**
+   * @brief Get the first steps of key, calling compute to compute them if
+   * they are not in the cache yet. If compute throws, the exception is
+   * rethrown to all the threads waiting for these first steps and nothing is
+   * cached.
+   *
+   * @param key : what the first steps depend on
+   * @param compute : function computing the first steps
+   * @return std::shared_ptr<const FirstSteps> : the first steps, valid even
+   * if they are removed from the cache
+   */
+  std::shared_ptr<const FirstSteps>
+  get(const Key &key, const std::function<void(FirstSteps *)> &compute);
+
+  /**
+   * @brief Remove all the first steps
+   *
+   */
+  void clear();
+
+  /**
+   * @brief Number of first steps computed, and of first steps found in the
+   * cache (including the ones being computed by another thread)
+   *
+   */
+  long long getNumberOfComputations() const;
+  long long getNumberOfHits() const;
+
+  /**
+   * @brief Total size of the first steps kept, in bytes
+   *
+   */
+  std::size_t getSize() const;
+
+  /**
+   * @brief Cache shared by the whole programm, used by default by the
+   * three-level solvers
+   *
+   */
+  static FirstStepCache &shared();
+
+private:
+  /**
+   * @brief First steps being computed or computed, with the number of the
+   * computation that added them, their size in bytes (0 until computed) and
+   * their position in usageOrder
+   *
+   */
+  struct Entry {
+    std::shared_future<std::shared_ptr<const FirstSteps>> firstSteps;
+    long long computation;
+    std::size_t size;
+    std::list<Key>::iterator usage;
+  };
+
+  mutable std::mutex mutex;
+  std::map<Key, Entry> entries;
+  /**
+   * @brief Keys of the entries, from the least to the most recently used
+   *
+   */
+  std::list<Key> usageOrder;
+  long long numberOfComputations = 0;
+  long long numberOfHits = 0;
+  std::size_t maximumSize;
+  std::size_t size = 0;
+
+  /**
+   * @brief Remove the least recently used entries until size fits in
+   * maximumSize. The mutex should be locked.
+   *
+   */
+  void evict();
+};
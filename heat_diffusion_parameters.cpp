@@ -1,5 +1,6 @@
 #include "heat_diffusion_parameters.h"
-#include <exception>
+#include <algorithm>
+#include <stdexcept>
 
 HeatDiffusionParameters::HeatDiffusionParameters() {
   timeLimitInitialized = false;
@@ -89,3 +90,21 @@ double HeatDiffusionParameters::getWidth() const {
     throw(std::logic_error("width not yet initialized"));
   }
 };
+
+int HeatDiffusionParameters::getNumberOfSpacePoints(double deltaX) const {
+  return ((int)(getWidth() / deltaX) + 1);
+};
+
+int HeatDiffusionParameters::getNumberOfTimeSteps(double deltaT) const {
+  double timeLimit = getTimeStop();
+  // Starting from an estimate and correcting it so that the result matches
+  // exactly the condition used in the time loops
+  int numberOfTimeSteps = std::max(1, (int)(timeLimit / deltaT) - 1);
+  while (numberOfTimeSteps > 1 && (numberOfTimeSteps - 1) * deltaT > timeLimit) {
+    numberOfTimeSteps--;
+  }
+  while (numberOfTimeSteps * deltaT <= timeLimit) {
+    numberOfTimeSteps++;
+  }
+  return (numberOfTimeSteps);
+};
@@ -93,6 +93,23 @@ public:
    */
   double getDiffusivity() const;
 
+  /**
+   * @brief Get the number of points of a regular mesh of the wall
+   *
+   * @param deltaX : space step
+   * @return int number of points, including both surfaces
+   */
+  int getNumberOfSpacePoints(double deltaX) const;
+
+  /**
+   * @brief Get the number of time steps of a regular mesh, including t=0 :
+   * time step n is computed while n * deltaT <= time limit
+   *
+   * @param deltaT : time step
+   * @return int number of time steps
+   */
+  int getNumberOfTimeSteps(double deltaT) const;
+
 protected:
   /**
    * @brief Diffusivity of the material of the wall
@@ -1,54 +1,305 @@
 #include "implicit_solver.h"
+#include "instrumentation.h"
+#include "solver_engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
-void ImplicitSolver::solveRegularMeshes(
-    double pdeltaX, double pdeltaT,
-    std::vector<std::vector<double> > *TSolutionPtr) {
+void ImplicitSolver::solveRegularMeshes(double pdeltaX, double pdeltaT,
+                                        SolutionGrid *TSolutionPtr) {
+  solveInGrid(pdeltaX, pdeltaT, TSolutionPtr, false, RowSink());
+};
+
+void ImplicitSolver::solveStreaming(double pdeltaX, double pdeltaT,
+                                    RowSink sink) {
+  SolutionGrid window;
+  solveInGrid(pdeltaX, pdeltaT, &window, true, sink);
+};
 
+void ImplicitSolver::solveOnMesh(const SpaceMesh &mesh, double pdeltaT,
+                                 MeshRowSink sink,
+                                 const MeshRefinement &refinement) {
   if (!parameters.checkInitialization()) {
     throw(std::invalid_argument(
         "Parameters have not yet been properly initialized"));
   }
+  deltaT = pdeltaT;
+  // The matrix of advance is replaced
+  discardFactorizations();
+  SpaceMesh currentMesh = initialMesh(mesh, refinement);
+  std::vector<double> previousTimeStep, TSolutionAtOneTime;
+  initialStateOnMesh(currentMesh, &previousTimeStep);
+  if (sink) {
+    sink(0, currentMesh, previousTimeStep.data());
+  }
 
-  // variable used to store the solution at a step in time while we are still
-  // computing it
-  deltaX = pdeltaX;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  HEAT_TIMED_SCOPE("implicit.mesh_time_steps");
+  bool matrixUpToDate = false;
+  int numberOfSteps = 0;
+  for (int timeIndex = 1; (timeIndex * deltaT) <= parameters.getTimeStop();
+       timeIndex++) {
+    if (!matrixUpToDate) {
+      HEAT_TIMED_SCOPE("implicit.matrix_setup");
+      initializeMatrixAOnMesh(currentMesh);
+      matrixUpToDate = true;
+    }
+    TSolutionAtOneTime.resize(currentMesh.getNumberOfPoints());
+    initializeMatrixBOnMesh(currentMesh, previousTimeStep.data());
+    thomasAlgoSolve(TSolutionAtOneTime.data());
+    if (sink) {
+      sink(timeIndex, currentMesh, TSolutionAtOneTime.data());
+    }
+    numberOfSteps++;
+
+    if (refinement.isDue(timeIndex)) {
+      SpaceMesh refinedMesh =
+          refinement.refine(currentMesh, TSolutionAtOneTime.data());
+      if (refinedMesh != currentMesh) {
+        HEAT_COUNT("mesh.refinements", 1);
+        previousTimeStep.resize(refinedMesh.getNumberOfPoints());
+        refinedMesh.interpolate(currentMesh, TSolutionAtOneTime.data(),
+                                previousTimeStep.data());
+        currentMesh = refinedMesh;
+        matrixUpToDate = false;
+        continue;
+      }
+    }
+    previousTimeStep.swap(TSolutionAtOneTime);
+  }
+  HEAT_COUNT("implicit.steps", numberOfSteps);
+  recordStepRate(numberOfSteps, start);
+}
+
+void ImplicitSolver::initializeMatrixAOnMesh(const SpaceMesh &mesh) {
+  int numberOfSpacePoints = mesh.getNumberOfPoints();
+  const double *lower = mesh.getLowerCoefficients();
+  const double *upper = mesh.getUpperCoefficients();
+  double implicitCoupling =
+      getImplicitWeight() * parameters.getDiffusivity() * deltaT;
+  allocateMatrixA(numberOfSpacePoints);
+  for (int i = 1; i < numberOfSpacePoints - 1; i++) {
+    lowerDiagonal[i] = -implicitCoupling * lower[i];
+    mainDiagonal[i] = 1 + implicitCoupling * (lower[i] + upper[i]);
+    upperDiagonal[i] = -implicitCoupling * upper[i];
+  }
+  // Boundary conditions : T(0) and T(L) are given
+  lowerDiagonal[0] = 0;
+  mainDiagonal[0] = 1;
+  upperDiagonal[0] = 0;
+  lowerDiagonal[numberOfSpacePoints - 1] = 0;
+  mainDiagonal[numberOfSpacePoints - 1] = 1;
+  upperDiagonal[numberOfSpacePoints - 1] = 0;
+  factorizeMatrixA();
+}
+
+void ImplicitSolver::initializeMatrixBOnMesh(const SpaceMesh &mesh,
+                                             const double *previousTimeStep) {
+  int numberOfSpacePoints = mesh.getNumberOfPoints();
+  const double *lower = mesh.getLowerCoefficients();
+  const double *upper = mesh.getUpperCoefficients();
+  double explicitCoupling =
+      (1 - getImplicitWeight()) * parameters.getDiffusivity() * deltaT;
+  matrixB[0] = previousTimeStep[0];
+  for (int i = 1; i < numberOfSpacePoints - 1; i++) {
+    matrixB[i] = previousTimeStep[i] +
+                 explicitCoupling *
+                     (lower[i] * previousTimeStep[i - 1] -
+                      (lower[i] + upper[i]) * previousTimeStep[i] +
+                      upper[i] * previousTimeStep[i + 1]);
+  }
+  matrixB[numberOfSpacePoints - 1] = previousTimeStep[numberOfSpacePoints - 1];
+}
+
+namespace {
+/**
+ * @brief Limits of the factor applied to deltaT after each step of
+ * solveAdaptive, and margin taken on the factor given by the error
+ *
+ */
+const double MINIMUM_STEP_FACTOR = 0.2;
+const double MAXIMUM_STEP_FACTOR = 2;
+const double STEP_SAFETY_FACTOR = 0.9;
+/**
+ * @brief Smallest growth of deltaT after a kept step of solveAdaptive : a
+ * smaller one leaves deltaT unchanged
+ *
+ */
+const double MINIMUM_STEP_GROWTH = 1.25;
+/**
+ * @brief Largest remainder of solveAdaptive, relative to deltaT, merged into
+ * the last step instead of being a step of its own
+ *
+ */
+const double MERGED_REMAINDER = 0.2;
+/**
+ * @brief Smallest deltaT of solveAdaptive, relative to the time limit
+ *
+ */
+const double MINIMUM_RELATIVE_DELTA_T = 1e-12;
+} // namespace
+
+bool ImplicitSolver::advance(double pdeltaT, const double *previousTimeStep,
+                             double *TSolutionAtOneTime) {
   deltaT = pdeltaT;
-  int numberOfSpacePoints = (int)(parameters.getWidth() / deltaX) + 1;
-  std::vector<double> TSolutionAtOneTime(numberOfSpacePoints);
+  bool factorized = false;
+  if (factorizedDeltaT != pdeltaT) {
+    // The current factorization is kept aside, and replaced if the other one
+    // is not for pdeltaT either
+    swapFactorizations();
+    if (factorizedDeltaT != pdeltaT) {
+      HEAT_TIMED_SCOPE("implicit.matrix_setup");
+      initializeMatrixAForThomasAlgo();
+      factorizedDeltaT = pdeltaT;
+      factorized = true;
+    }
+  }
+  initializeMatrixBForThomasAlgo(previousTimeStep);
+  thomasAlgoSolve(TSolutionAtOneTime);
+  return factorized;
+}
 
-  // For t=0, we calculate the initial state of each point and store it
-  std::fill(TSolutionAtOneTime.begin(), TSolutionAtOneTime.end(),
-            parameters.getInternalTemperature());
-  TSolutionAtOneTime[0] = parameters.getSurfaceTemperature();
-  TSolutionAtOneTime[numberOfSpacePoints - 1] =
-      parameters.getSurfaceTemperature();
-  (*TSolutionPtr).push_back(TSolutionAtOneTime);
-  TSolutionAtOneTime.clear();
+void ImplicitSolver::swapFactorizations() {
+  lowerDiagonal.swap(otherFactorization.lowerDiagonal);
+  pivots.swap(otherFactorization.pivots);
+  modifiedUpperDiagonal.swap(otherFactorization.modifiedUpperDiagonal);
+  std::swap(parallelSolver, otherFactorization.parallelSolver);
+  std::swap(useParallelSolver, otherFactorization.useParallelSolver);
+  std::swap(factorizedDeltaT, otherFactorization.deltaT);
+}
 
-  initializeMatrixAForThomasAlgo();
+void ImplicitSolver::discardFactorizations() {
+  factorizedDeltaT = 0;
+  otherFactorization.deltaT = 0;
+}
 
-  // For the other time steps :
-  for (int timeIndex = 1; (timeIndex * deltaT) <= parameters.getTimeStop();
-       timeIndex++) {
+void ImplicitSolver::solveAdaptive(double pdeltaX, double initialDeltaT,
+                                   double tolerance,
+                                   AdaptiveSolution *solution) {
+  if (!parameters.checkInitialization()) {
+    throw(std::invalid_argument(
+        "Parameters have not yet been properly initialized"));
+  }
+  if (pdeltaX <= 0 || initialDeltaT <= 0 || tolerance <= 0) {
+    throw(std::invalid_argument(
+        "deltaX, the initial deltaT and the tolerance should be positive"));
+  }
+  HEAT_TIMED_SCOPE("implicit.adaptive_solve");
+  deltaX = pdeltaX;
+  discardFactorizations();
+  int numberOfSpacePoints = parameters.getNumberOfSpacePoints(deltaX);
+  double timeStop = parameters.getTimeStop();
+  // Error of the two half steps = difference / (2^order - 1)
+  double errorScale = 1. / ((1 << getOrderInTime()) - 1);
+  double exponent = 1. / (getOrderInTime() + 1);
+
+  std::vector<double> current(numberOfSpacePoints,
+                              parameters.getInternalTemperature());
+  current[0] = parameters.getSurfaceTemperature();
+  current[numberOfSpacePoints - 1] = parameters.getSurfaceTemperature();
+  std::vector<double> fullStep(numberOfSpacePoints),
+      halfStep(numberOfSpacePoints), twoHalfSteps(numberOfSpacePoints);
+
+  (*solution).temperatures.clear();
+  (*solution).temperatures.appendRow(current.data(), numberOfSpacePoints);
+  (*solution).times.assign(1, 0.);
+  (*solution).acceptedSteps = 0;
+  (*solution).rejectedSteps = 0;
+  (*solution).factorizations = 0;
 
-    initializeMatrixBForThomasAlgo(&((*TSolutionPtr)[timeIndex - 1]));
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  double t = 0;
+  double stepDeltaT = initialDeltaT;
+  while (t < timeStop) {
+    // The last step ends exactly at the time limit
+    bool lastStep = t + (1 + MERGED_REMAINDER) * stepDeltaT >= timeStop;
+    double tryDeltaT = lastStep ? timeStop - t : stepDeltaT;
+    (*solution).factorizations +=
+        advance(tryDeltaT, current.data(), fullStep.data());
+    (*solution).factorizations +=
+        advance(tryDeltaT / 2, current.data(), halfStep.data());
+    (*solution).factorizations +=
+        advance(tryDeltaT / 2, halfStep.data(), twoHalfSteps.data());
+    double error = 0;
+    for (int j = 0; j < numberOfSpacePoints; j++) {
+      error = std::max(error, fabs(twoHalfSteps[j] - fullStep[j]));
+    }
+    error *= errorScale;
 
-    thomasAlgoSolve(&TSolutionAtOneTime);
-    (*TSolutionPtr).push_back(TSolutionAtOneTime);
-    TSolutionAtOneTime.clear();
+    double factor = MAXIMUM_STEP_FACTOR;
+    if (error > 0) {
+      factor = std::min(MAXIMUM_STEP_FACTOR,
+                        std::max(MINIMUM_STEP_FACTOR,
+                                 STEP_SAFETY_FACTOR *
+                                     pow(tolerance / error, exponent)));
+    }
+    if (error <= tolerance) {
+      t = lastStep ? timeStop : t + tryDeltaT;
+      current.swap(twoHalfSteps);
+      (*solution).temperatures.appendRow(current.data(), numberOfSpacePoints);
+      (*solution).times.push_back(t);
+      (*solution).acceptedSteps++;
+      if (factor >= 1 && factor < MINIMUM_STEP_GROWTH) {
+        continue;
+      }
+    } else {
+      (*solution).rejectedSteps++;
+    }
+    stepDeltaT = tryDeltaT * factor;
+    if (t < timeStop && stepDeltaT < MINIMUM_RELATIVE_DELTA_T * timeStop) {
+      throw(std::runtime_error(
+          "deltaT is too small to reach the tolerance of the adaptive solve"));
+    }
   }
-};
+  HEAT_COUNT("implicit.adaptive_steps", (*solution).acceptedSteps);
+  HEAT_COUNT("implicit.adaptive_rejected_steps", (*solution).rejectedSteps);
+  recordStepRate((*solution).acceptedSteps, start);
+}
+
+void ImplicitSolver::allocateMatrixA(int numberOfSpacePoints) {
+  lowerDiagonal.resize(numberOfSpacePoints);
+  mainDiagonal.resize(numberOfSpacePoints);
+  upperDiagonal.resize(numberOfSpacePoints);
+}
 
-void ImplicitSolver::thomasAlgoSolve(std::vector<double> *TSolutionAtOneTime) {
-  int sizeOfB = matrixB.size();
-  (*TSolutionAtOneTime) = std::vector<double>(sizeOfB, -1);
-  (*TSolutionAtOneTime)[sizeOfB - 1] = matrixB[sizeOfB - 1];
-  for (int i = sizeOfB - 2; i >= 0; i--) {
-    (*TSolutionAtOneTime)[i] =
-        matrixB[i] - (*TSolutionAtOneTime)[i + 1] * (matrixA[i][i + 1]);
+void ImplicitSolver::factorizeMatrixA() {
+  int sizeOfA = mainDiagonal.size();
+  modifiedUpperDiagonal.resize(sizeOfA);
+  pivots.resize(sizeOfA);
+  matrixB.resize(sizeOfA);
+  useParallelSolver = sizeOfA >= parallelThreshold &&
+                      ThreadPool::shared().getNumberOfThreads() > 1;
+  if (useParallelSolver) {
+    parallelSolver.factorize(sizeOfA, lowerDiagonal.data(),
+                             mainDiagonal.data(), upperDiagonal.data());
+  } else {
+    factorizeTridiagonal(sizeOfA, lowerDiagonal.data(), mainDiagonal.data(),
+                         upperDiagonal.data(), pivots.data(),
+                         modifiedUpperDiagonal.data());
   }
 }
 
+void ImplicitSolver::thomasAlgoSolve(double *TSolutionAtOneTime) {
+  if (useParallelSolver) {
+    parallelSolver.solve(matrixB.data(), TSolutionAtOneTime);
+    return;
+  }
+  solveFactorizedTridiagonal(matrixB.size(), lowerDiagonal.data(),
+                             pivots.data(), modifiedUpperDiagonal.data(),
+                             matrixB.data(), TSolutionAtOneTime);
+}
+
+void ImplicitSolver::setParallelThreshold(int numberOfSpacePoints) {
+  parallelThreshold = numberOfSpacePoints;
+};
+
+void ImplicitSolver::copySettingsTo(ImplicitSolver *solver) const {
+  (*solver).setParallelThreshold(parallelThreshold);
+};
+
 ImplicitSolver::~ImplicitSolver(){};
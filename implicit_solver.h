@@ -1,57 +1,278 @@
 #pragma once // Include guard
 #include "abstract_solver.h"
+#include "parallel_tridiagonal_solver.h"
+#include "solver_engine.h"
+#include <vector>
+
+/**
+ * @brief Solution computed with a variable time step (see
+ * ImplicitSolver::solveAdaptive)
+ *
+ */
+struct AdaptiveSolution {
+  /**
+   * @brief Row n holds the temperatures at time times[n]
+   *
+   */
+  SolutionGrid temperatures;
+  std::vector<double> times;
+  /**
+   * @brief Number of time steps kept and of time steps tried again with a
+   * smaller deltaT
+   *
+   */
+  int acceptedSteps = 0;
+  int rejectedSteps = 0;
+  /**
+   * @brief Number of times the matrix of the scheme has been factorized
+   *
+   */
+  int factorizations = 0;
+};
 
 class ImplicitSolver : public AbstractSolver {
 protected:
   /**
-   * @brief The A matrix from AX=B equation of the Thomas Algorithm
-   * A is a matrix with 1 it's main diagonal and other values in the diagonal
-   * above it.
+   * @brief Sub-diagonal of the A matrix from AX=B equation of the Thomas
+   * Algorithm : lowerDiagonal[i] = A[i][i-1].
    * AX=B coresponding to the linear system that we are trying to solve
-   * for each time step once the transformations required by the thomas
-   * algorithm are applied to A and B
+   * for each time step. The first value is always 0.
+   */
+  std::vector<double> lowerDiagonal;
+
+  /**
+   * @brief Main diagonal of the A matrix : mainDiagonal[i] = A[i][i]
+   *
    */
-  std::vector<std::vector<double> > matrixA;
+  std::vector<double> mainDiagonal;
+
+  /**
+   * @brief Super-diagonal of the A matrix : upperDiagonal[i] = A[i][i+1].
+   * The last value is always 0.
+   *
+   */
+  std::vector<double> upperDiagonal;
+
+  /**
+   * @brief Super-diagonal of A once the forward elimination of the Thomas
+   * Algorithm has been applied. Computed once by factorizeMatrixA() and reused
+   * for all time steps.
+   *
+   */
+  std::vector<double> modifiedUpperDiagonal;
+
+  /**
+   * @brief Pivots of the forward elimination of the Thomas Algorithm :
+   * pivots[i] = A[i][i] - A[i][i-1] * modifiedUpperDiagonal[i-1].
+   * Computed once by factorizeMatrixA() and reused for all time steps.
+   *
+   */
+  std::vector<double> pivots;
 
   /**
    * @brief The B vector from AX=B equation of the Thomas Algorithm
    * AX=B coresponding to the linear system that we are trying to solve
-   * for each time step once the transformations required by the thomas
-   * algorithm are applied to A and B.
+   * for each time step. It is allocated once by factorizeMatrixA() and
+   * overwritten in place for each time step.
    */
   std::vector<double> matrixB;
 
   /**
-   * @brief Initialized A matrix with transformations required by Thomas
-   * Algorithm This matrix will be reuse for all time steps Specific to each
-   * scheme
+   * @brief Solver spreading each linear system over the threads of the
+   * shared ThreadPool, used instead of the sequential Thomas algorithm for
+   * systems of at least parallelThreshold unknowns
+   *
+   */
+  ParallelTridiagonalSolver parallelSolver;
+
+  /**
+   * @brief Minimum number of space points to use parallelSolver
+   *
+   */
+  int parallelThreshold = DEFAULT_PARALLEL_THRESHOLD;
+
+  /**
+   * @brief Whether parallelSolver has been factorized and should be used
+   *
+   */
+  bool useParallelSolver = false;
+
+  /**
+   * @brief Initialized the three diagonals of the A matrix and factorize it
+   * with factorizeMatrixA(). This matrix will be reuse for all the time steps
+   * of the same deltaT (see advance). Specific to each scheme
    */
   virtual void initializeMatrixAForThomasAlgo() = 0;
 
   /**
-   * @brief Initialized B vector with transformations required by Thomas
-   * Algorithm This vector needs to be recalculated for each new time step.
+   * @brief Initialized B vector, the right hand side of the linear system.
+   * This vector needs to be recalculated for each new time step. It is
+   * written in place in matrixB, which is already allocated.
    * Specific to each scheme
    *
    * @param previousTimeStep  : Values of the temperature at the previous time
    * step
    */
   virtual void
-  initializeMatrixBForThomasAlgo(std::vector<double> *previousTimeStep) = 0;
+  initializeMatrixBForThomasAlgo(const double *previousTimeStep) = 0;
+
+  /**
+   * @brief Allocate the three diagonals of A for numberOfSpacePoints points
+   *
+   */
+  void allocateMatrixA(int numberOfSpacePoints);
+
+  /**
+   * @brief Apply the forward elimination of the Thomas Algorithm to the
+   * diagonals of A. Fill modifiedUpperDiagonal and pivots and allocate
+   * matrixB. Should be called at the end of initializeMatrixAForThomasAlgo().
+   * For large systems, factorize parallelSolver instead.
+   *
+   */
+  void factorizeMatrixA();
 
   /**
    * @brief Solve the linear system AX=B
-   * with A = matrixA and B=matrixB following the Thomas Algorithm.
-   * transformations to A and B matrix are applied before calling this
-   * functions. They should be applied by initializeMatrix<X>ForThomasAlgo()
-   * functions.
+   * with A given by its diagonals and B=matrixB following the Thomas
+   * Algorithm. The forward elimination on B and the backward substitution are
+   * done in a single call, reusing the factorization computed by
+   * factorizeMatrixA(). matrixB is overwritten. Large systems are solved in
+   * parallel by parallelSolver.
    *
    * @param TSolutionAtOneTime : where to store the solution given by the
-   * algorithm
+   * algorithm. Should have the size of matrixB.
+   */
+  void thomasAlgoSolve(double *TSolutionAtOneTime);
+
+  /**
+   * @brief Order in time of the scheme : the local error of a time step is
+   * O(deltaT^(order + 1)). Used to estimate the error of a time step in
+   * solveAdaptive.
+   *
    */
-  void thomasAlgoSolve(std::vector<double> *TSolutionAtOneTime);
+  virtual int getOrderInTime() const = 0;
+
+  /**
+   * @brief Weight of the new time step in the second derivative of the
+   * scheme (1 for Laasonen, 1/2 for Crank-Nicholson). Used to build the
+   * linear system on a mesh that is not evenly spaced.
+   *
+   */
+  virtual double getImplicitWeight() const = 0;
+
+  /**
+   * @brief Compute and factorize the A matrix of the scheme on a mesh
+   * (I - w D deltaT d2/dx2 with w the implicit weight)
+   *
+   */
+  void initializeMatrixAOnMesh(const SpaceMesh &mesh);
+
+  /**
+   * @brief Compute the B matrix of the scheme on a mesh
+   * ((I + (1 - w) D deltaT d2/dx2) previousTimeStep)
+   *
+   */
+  void initializeMatrixBOnMesh(const SpaceMesh &mesh,
+                               const double *previousTimeStep);
+
+  /**
+   * @brief Compute the time step following previousTimeStep with a step of
+   * pdeltaT. The factorizations of A for the last two values of pdeltaT are
+   * kept : A is only computed again when pdeltaT is neither of them.
+   *
+   * @return bool : whether A has been factorized again
+   */
+  bool advance(double pdeltaT, const double *previousTimeStep,
+               double *TSolutionAtOneTime);
+
+  /**
+   * @brief deltaT for which matrix A has been factorized by advance, 0 if
+   * none
+   *
+   */
+  double factorizedDeltaT = 0;
+
+  /**
+   * @brief Factorization of A kept aside by advance, for the deltaT used
+   * before factorizedDeltaT (0 if none)
+   *
+   */
+  struct Factorization {
+    std::vector<double> lowerDiagonal, pivots, modifiedUpperDiagonal;
+    ParallelTridiagonalSolver parallelSolver;
+    bool useParallelSolver = false;
+    double deltaT = 0;
+  };
+  Factorization otherFactorization;
+
+  /**
+   * @brief Exchange the current factorization of A with otherFactorization
+   *
+   */
+  void swapFactorizations();
+
+  /**
+   * @brief Forget the factorizations of advance, when A is computed for
+   * another problem
+   *
+   */
+  void discardFactorizations();
+
+  /**
+   * @brief Solve the issue storing the time steps in storage and handing
+   * them to sink (if any) once computed.
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param storage : grid where the time steps are computed. It holds all
+   * the time steps, or only the last two if rollingWindow is true
+   * @param rollingWindow : whether storage is used as a rolling window
+   * @param sink : function called with each time step, can be empty
+   */
+  virtual void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                           bool rollingWindow, RowSink sink) = 0;
+
+  /**
+   * @brief Implementation of solveInGrid for the schemes having a policy in
+   * the scheme namespace : the time steps are computed by engine
+   *
+   */
+  template <class Scheme>
+  void solveInGridWithEngine(SolverEngine<Scheme> *engine, double pdeltaX,
+                             double pdeltaT, SolutionGrid *storage,
+                             bool rollingWindow, RowSink sink) {
+    (*engine).setParameters(parameters);
+    (*engine).setParallelThreshold(parallelThreshold);
+    deltaX = pdeltaX;
+    deltaT = pdeltaT;
+    (*engine).solveInGrid(deltaX, deltaT, storage, rollingWindow, sink);
+    stepsPerSecond = (*engine).getStepsPerSecond();
+  }
+
+  /**
+   * @brief Copy the settings of this solver to solver, for clone()
+   *
+   */
+  void copySettingsTo(ImplicitSolver *solver) const;
 
 public:
+  /**
+   * @brief Default minimum number of space points to solve each time step in
+   * parallel
+   *
+   */
+  static const int DEFAULT_PARALLEL_THRESHOLD = 200000;
+
+  /**
+   * @brief Set the minimum number of space points from which each time step
+   * is solved in parallel over the threads of ThreadPool::shared(). Smaller
+   * systems, or any system if the pool has a single thread, are solved with
+   * the sequential Thomas algorithm.
+   *
+   * @param numberOfSpacePoints : minimum number of space points
+   */
+  void setParallelThreshold(int numberOfSpacePoints);
+
   /**
    * @brief Solve the issue if all the parameters have been defined
    *
@@ -59,12 +280,63 @@ public:
    *
    * @param deltaX : size if the space step
    * @param deltaT : size of the time step
+   * @param TSolutionPtr : grid where the solution is stored
+   */
+  void solveRegularMeshes(double deltaX, double deltaT,
+                          SolutionGrid *TSolutionPtr) override;
+
+  /**
+   * @brief Solve the issue keeping only the previous and the current time
+   * steps in memory. Each time step is handed to sink once computed.
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order
+   */
+  void solveStreaming(double deltaX, double deltaT, RowSink sink) override;
+
+  /**
+   * @brief Solve the issue on a mesh (see AbstractSolver::solveOnMesh). The
+   * linear system is built with the three points second derivative of the
+   * mesh and solved with the Thomas algorithm; it is only computed again
+   * when the refinement changes the mesh.
+   *
+   */
+  void solveOnMesh(const SpaceMesh &mesh, double deltaT, MeshRowSink sink,
+                   const MeshRefinement &refinement) override;
+
+  /**
+   * @brief Solve the issue with a time step adapted to a tolerance on the
+   * local error, up to the time limit
+   *
+   * The error of each time step is estimated by step doubling : the step is
+   * computed once with deltaT and once as two steps of deltaT / 2, and the
+   * difference between both (divided by 2^order - 1) estimates the error of
+   * the two half steps. The step is kept (the two half steps) if the largest
+   * error on a point is below tolerance, and tried again otherwise. In both
+   * cases, deltaT is scaled by 0.9 (tolerance / error)^(1 / (order + 1)),
+   * between 0.2 and 2, except after a kept step allowing deltaT to grow by
+   * less than 1.25 : deltaT is then left unchanged, so that the
+   * factorizations of A for deltaT and deltaT / 2 are reused. A remainder
+   * shorter than 0.2 deltaT is merged into the last step, which is then up to
+   * 1.2 deltaT long.
+   *
+   * The tolerance bounds the error of each step, not the error at the time
+   * limit : a first order scheme whose steps stay short after a sharp
+   * transient can need more steps than a uniform deltaT reaching the same
+   * error at the time limit.
+   *
+   * Can throw an invalid_argument exception if deltaX, initialDeltaT or
+   * tolerance are not positive, or a runtime_error one if deltaT becomes too
+   * small to reach the tolerance
    *
-   * @return std::vector<std::vector<double>>
+   * @param deltaX : size of the space step
+   * @param initialDeltaT : size of the first time step tried
+   * @param tolerance : largest error on a temperature allowed for a time step
+   * @param solution : where the time steps and their times are stored
    */
-  void
-  solveRegularMeshes(double deltaX, double deltaT,
-                     std::vector<std::vector<double> > *TSolutionPtr) override;
+  void solveAdaptive(double deltaX, double initialDeltaT, double tolerance,
+                     AdaptiveSolution *solution);
 
   virtual ~ImplicitSolver();
 };
@@ -0,0 +1,178 @@
+#include "instrumentation.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <vector>
+
+namespace instrumentation {
+
+namespace {
+
+std::mutex registryMutex;
+
+/**
+ * @brief All the statistics created. A list keeps the references valid.
+ *
+ */
+std::list<Statistic> &registry() {
+  static std::list<Statistic> statistics;
+  return statistics;
+}
+
+std::atomic<long long> allocationCount(0);
+std::atomic<long long> allocatedBytes(0);
+
+/**
+ * @brief Statistics sorted by name
+ *
+ */
+std::vector<const Statistic *> sortedStatistics() {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::vector<const Statistic *> statistics;
+  for (const Statistic &statistic : registry()) {
+    statistics.push_back(&statistic);
+  }
+  std::sort(statistics.begin(), statistics.end(),
+            [](const Statistic *a, const Statistic *b) {
+              return (*a).name < (*b).name;
+            });
+  return statistics;
+}
+
+} // namespace
+
+Statistic &statistic(const char *name, bool isTimer) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for (Statistic &existing : registry()) {
+    if (existing.name == name) {
+      if (existing.isTimer != isTimer) {
+        throw(std::logic_error(std::string(name) +
+                               " is used as a timer and as a counter"));
+      }
+      return existing;
+    }
+  }
+  registry().emplace_back(name, isTimer);
+  return registry().back();
+}
+
+long long numberOfAllocations() { return allocationCount.load(); }
+
+long long bytesAllocated() { return allocatedBytes.load(); }
+
+long long peakResidentMemory() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // ru_maxrss is in kilobytes on Linux
+  return (long long)usage.ru_maxrss * 1024;
+}
+
+void writeTextReport(std::ostream &outputStream) {
+  std::ios::fmtflags flags = outputStream.flags();
+  std::streamsize precision = outputStream.precision();
+  outputStream << std::fixed << std::setprecision(3);
+  outputStream << std::left << std::setw(36) << "timer / counter" << std::right
+               << std::setw(14) << "calls / count" << std::setw(14)
+               << "total ms" << std::setw(14) << "mean us" << "\n";
+  for (const Statistic *statistic : sortedStatistics()) {
+    long long count = (*statistic).count.load();
+    outputStream << std::left << std::setw(36) << (*statistic).name
+                 << std::right << std::setw(14) << count;
+    if ((*statistic).isTimer) {
+      double nanoseconds = (double)(*statistic).nanoseconds.load();
+      outputStream << std::setw(14) << nanoseconds * 1e-6 << std::setw(14)
+                   << (count > 0 ? nanoseconds * 1e-3 / count : 0);
+    }
+    outputStream << "\n";
+  }
+  outputStream << "allocations : " << numberOfAllocations() << " ("
+               << bytesAllocated() << " bytes)\n";
+  outputStream << "peak resident memory : "
+               << peakResidentMemory() / (1024. * 1024.) << " MiB\n";
+  outputStream.flags(flags);
+  outputStream.precision(precision);
+}
+
+void writeJsonReport(std::ostream &outputStream) {
+  std::vector<const Statistic *> statistics = sortedStatistics();
+  outputStream << "{\n  \"timers\": {";
+  bool first = true;
+  for (const Statistic *statistic : statistics) {
+    if ((*statistic).isTimer) {
+      outputStream << (first ? "\n" : ",\n") << "    \"" << (*statistic).name
+                   << "\": {\"calls\": " << (*statistic).count.load()
+                   << ", \"nanoseconds\": " << (*statistic).nanoseconds.load()
+                   << "}";
+      first = false;
+    }
+  }
+  outputStream << "\n  },\n  \"counters\": {";
+  first = true;
+  for (const Statistic *statistic : statistics) {
+    if (!(*statistic).isTimer) {
+      outputStream << (first ? "\n" : ",\n") << "    \"" << (*statistic).name
+                   << "\": " << (*statistic).count.load();
+      first = false;
+    }
+  }
+  outputStream << "\n  },\n  \"allocations\": " << numberOfAllocations()
+               << ",\n  \"bytes_allocated\": " << bytesAllocated()
+               << ",\n  \"peak_resident_bytes\": " << peakResidentMemory()
+               << "\n}\n";
+}
+
+void writeReport(std::ostream &outputStream, const std::string &jsonFilename) {
+  writeTextReport(outputStream);
+  std::ofstream jsonFile(jsonFilename);
+  if (!jsonFile) {
+    throw(std::runtime_error("cannot open " + jsonFilename));
+  }
+  writeJsonReport(jsonFile);
+}
+
+} // namespace instrumentation
+
+#ifdef HEAT_INSTRUMENTATION
+// Every allocation of the programm goes through these operators to be counted
+void *operator new(std::size_t size) {
+  instrumentation::allocationCount.fetch_add(1, std::memory_order_relaxed);
+  instrumentation::allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  void *allocation = std::malloc(size ? size : 1);
+  if (!allocation) {
+    throw std::bad_alloc();
+  }
+  return allocation;
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+// The memory freed here comes from the malloc of operator new above, but
+// GCC inlines these operators where the pointer is returned by a new
+// expression and then warns about a mismatched free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *allocation) noexcept { std::free(allocation); }
+
+void operator delete[](void *allocation) noexcept { std::free(allocation); }
+
+void operator delete(void *allocation, std::size_t) noexcept {
+  std::free(allocation);
+}
+
+void operator delete[](void *allocation, std::size_t) noexcept {
+  std::free(allocation);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
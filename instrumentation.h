@@ -0,0 +1,142 @@
+#pragma once // Include guard
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Timers and counters of the hot paths, reported at the end of a run
+ *
+ * The library is instrumented with the HEAT_TIMED_SCOPE and HEAT_COUNT
+ * macros. They compile to nothing unless HEAT_INSTRUMENTATION is defined
+ * (see `make profile`). When it is defined :
+ * - HEAT_TIMED_SCOPE(name) adds the time until the end of the enclosing
+ *   scope to the timer name, and counts one call
+ * - HEAT_COUNT(name, n) adds n to the counter name
+ * - every allocation through operator new is counted
+ * - HEAT_WRITE_REPORT(stream, jsonFilename) writes the timers, the counters,
+ *   the allocations and the peak resident memory as text in stream and as
+ *   JSON in jsonFilename
+ *
+ * Each timer or counter is looked up by name once, at the first execution of
+ * the macro; afterwards it only costs an atomic addition (and two clock
+ * reads for a timer). Timers of nested scopes overlap : their times do not
+ * add up.
+ */
+namespace instrumentation {
+
+/**
+ * @brief Timer or counter : number of calls or total count, and total time
+ * in nanoseconds for a timer
+ *
+ */
+struct Statistic {
+  std::string name;
+  bool isTimer;
+  std::atomic<long long> count;
+  std::atomic<long long> nanoseconds;
+
+  Statistic(const std::string &pname, bool pisTimer)
+      : name(pname), isTimer(pisTimer), count(0), nanoseconds(0) {}
+};
+
+/**
+ * @brief Get the timer or counter of a given name, created at the first call.
+ * The reference stays valid until the end of the programm.
+ *
+ * @param name : name of the statistic
+ * @param isTimer : whether it is a timer or a counter
+ */
+Statistic &statistic(const char *name, bool isTimer);
+
+/**
+ * @brief Add the time spent until its destruction to a timer
+ *
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Statistic &ptimer)
+      : timer(ptimer), start(std::chrono::steady_clock::now()) {}
+
+  ~ScopedTimer() {
+    std::chrono::nanoseconds elapsed = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    timer.count.fetch_add(1, std::memory_order_relaxed);
+    timer.nanoseconds.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Statistic &timer;
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * @brief Number of calls of operator new since the start of the programm (0
+ * unless HEAT_INSTRUMENTATION is defined)
+ *
+ */
+long long numberOfAllocations();
+
+/**
+ * @brief Number of bytes requested from operator new since the start of the
+ * programm (0 unless HEAT_INSTRUMENTATION is defined)
+ *
+ */
+long long bytesAllocated();
+
+/**
+ * @brief Largest resident memory of the process so far, in bytes
+ *
+ */
+long long peakResidentMemory();
+
+/**
+ * @brief Write the statistics as a table
+ *
+ */
+void writeTextReport(std::ostream &outputStream);
+
+/**
+ * @brief Write the statistics as a JSON object
+ *
+ */
+void writeJsonReport(std::ostream &outputStream);
+
+/**
+ * @brief Write the text report in outputStream and the JSON report in the
+ * file jsonFilename
+ *
+ */
+void writeReport(std::ostream &outputStream, const std::string &jsonFilename);
+
+} // namespace instrumentation
+
+#define HEAT_CONCATENATE_DETAIL(a, b) a##b
+#define HEAT_CONCATENATE(a, b) HEAT_CONCATENATE_DETAIL(a, b)
+
+#ifdef HEAT_INSTRUMENTATION
+#define HEAT_TIMED_SCOPE(name)                                                 \
+  static instrumentation::Statistic &HEAT_CONCATENATE(heatTimer, __LINE__) =   \
+      instrumentation::statistic(name, true);                                  \
+  instrumentation::ScopedTimer HEAT_CONCATENATE(heatScopedTimer, __LINE__)(    \
+      HEAT_CONCATENATE(heatTimer, __LINE__))
+#define HEAT_COUNT(name, n)                                                    \
+  do {                                                                         \
+    static instrumentation::Statistic &heatCounter =                           \
+        instrumentation::statistic(name, false);                               \
+    heatCounter.count.fetch_add((n), std::memory_order_relaxed);               \
+  } while (0)
+#define HEAT_WRITE_REPORT(outputStream, jsonFilename)                          \
+  instrumentation::writeReport(outputStream, jsonFilename)
+#else
+#define HEAT_TIMED_SCOPE(name)
+#define HEAT_COUNT(name, n)                                                    \
+  do {                                                                         \
+  } while (0)
+#define HEAT_WRITE_REPORT(outputStream, jsonFilename)                          \
+  do {                                                                         \
+  } while (0)
+#endif
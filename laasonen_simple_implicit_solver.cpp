@@ -1,34 +1,46 @@
 #include "laasonen_simple_implicit_solver.h"
+#include "solver_engine.h"
 #include <iostream>
 
 LaasonenSolver::LaasonenSolver() { schemeName = "Laasonen"; };
 
+std::unique_ptr<AbstractSolver> LaasonenSolver::clone() const {
+  LaasonenSolver *solver = new LaasonenSolver();
+  copySettingsTo(solver);
+  return std::unique_ptr<AbstractSolver>(solver);
+}
+
+void LaasonenSolver::solveInGrid(double pdeltaX, double pdeltaT,
+                                 SolutionGrid *storage, bool rollingWindow,
+                                 RowSink sink) {
+  solveInGridWithEngine(&engine, pdeltaX, pdeltaT, storage, rollingWindow,
+                        sink);
+}
+
+int LaasonenSolver::getOrderInTime() const {
+  return scheme::Laasonen::orderInTime;
+}
+
+double LaasonenSolver::getImplicitWeight() const {
+  return scheme::Laasonen::implicitWeight();
+}
+
 void LaasonenSolver::initializeMatrixAForThomasAlgo() {
-  double s = parameters.getDiffusivity() * deltaT / (deltaX * deltaX);
-  int numberOfSpacePoints = (int)(parameters.getWidth() / deltaX) + 1;
-  matrixA = std::vector<std::vector<double> >(
-      numberOfSpacePoints, std::vector<double>(numberOfSpacePoints, 0.));
-  matrixA[0][0] = 1;
-  matrixA[numberOfSpacePoints - 1][numberOfSpacePoints - 1] = 1;
-  for (int spaceIndex = 1; spaceIndex < numberOfSpacePoints - 1; spaceIndex++) {
-    matrixA[spaceIndex][spaceIndex] = 1;
-    matrixA[spaceIndex][spaceIndex + 1] =
-        -s / (1 + 2 * s + s * matrixA[spaceIndex - 1][spaceIndex]);
-  }
+  // -s T(i-1) + (1+2s) T(i) - s T(i+1) = T_previous(i) inside the wall
+  double s = scheme::Laasonen::coupling(parameters.getDiffusivity(), deltaT,
+                                        deltaX);
+  int numberOfSpacePoints = parameters.getNumberOfSpacePoints(deltaX);
+  allocateMatrixA(numberOfSpacePoints);
+  ImplicitKernels<scheme::Laasonen>::fillDiagonals(
+      s, numberOfSpacePoints, lowerDiagonal.data(), mainDiagonal.data(),
+      upperDiagonal.data());
+
+  factorizeMatrixA();
 }
 void LaasonenSolver::initializeMatrixBForThomasAlgo(
-    std::vector<double> *TpreviousTimeStep) {
-  double s = parameters.getDiffusivity() * deltaT / (deltaX * deltaX);
-  int numberOfSpacePoints = (int)((parameters.getWidth()) / deltaX) + 1;
-  matrixB = std::vector<double>(numberOfSpacePoints, -1);
-  matrixB[0] = ((*TpreviousTimeStep)[0] / 1);
-  for (int spaceIndex = 1; spaceIndex < numberOfSpacePoints - 1; spaceIndex++) {
-    double di = (*TpreviousTimeStep)[spaceIndex];
-    matrixB[spaceIndex] =
-        ((di - (-s * matrixB[spaceIndex - 1])) /
-         (1 + (2 * s) + s * matrixA[spaceIndex - 1][spaceIndex]));
-  }
-  double di = (*TpreviousTimeStep)[numberOfSpacePoints - 1];
-  matrixB[numberOfSpacePoints - 1] =
-      di / matrixA[numberOfSpacePoints - 1][numberOfSpacePoints - 1];
+    const double *TpreviousTimeStep) {
+  double s = scheme::Laasonen::coupling(parameters.getDiffusivity(), deltaT,
+                                        deltaX);
+  ImplicitKernels<scheme::Laasonen>::rightHandSide(
+      TpreviousTimeStep, matrixB.data(), matrixB.size(), s);
 }
@@ -9,7 +9,20 @@ public:
    */
   LaasonenSolver();
 
+
+  std::unique_ptr<AbstractSolver> clone() const override;
+
 protected:
+  /**
+   * @brief Solver of the time steps on regular meshes
+   *
+   */
+  SolverEngine<scheme::Laasonen> engine;
+
+  void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                   bool rollingWindow, RowSink sink) override;
+  int getOrderInTime() const override;
+  double getImplicitWeight() const override;
   /**
    * Compute the A matrix of the linear system given by Lassons scheme
    * and apply transformations required for solving the system with Thomas
@@ -23,6 +36,5 @@ protected:
    * Algorithm
    *
    */
-  void initializeMatrixBForThomasAlgo(
-      std::vector<double> *previousTimeStep) override;
+  void initializeMatrixBForThomasAlgo(const double *previousTimeStep) override;
 };
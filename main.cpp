@@ -1,28 +1,35 @@
 /*! \file */
 
 #include "abstract_solver.h"
+#include "adaptive_comparison.h"
+#include "adi_solver.h"
 #include "crank-nicholson_solver.h"
 #include "dufort-frankel_solver.h"
-#include "exact_solver.h"
+#include "csv_writer.h"
 #include "heat_diffusion_parameters.h"
+#include "exact_solver.h"
+#include "instrumentation.h"
 #include "laasonen_simple_implicit_solver.h"
-#include "richardson_solver.h"
-#include <fstream>
-#include <iomanip>
+#include "mesh_comparison.h"
+#include "norms.h"
+#include "result_cache.h"
+#include "result_file.h"
+#include "result_output.h"
+#include "solution_grid.h"
+#include "superposition_cache.h"
+#include "sweep_engine.h"
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 
-void resultToFile(std::string filename,
-                  std::vector<std::vector<double> > *numericalSolution,
-                  std::vector<std::vector<double> > *analyticalSolution,
-                  double deltaX, double deltaT);
-void addFirstStepRelsultToFile(
-    std::fstream *outputFileStream,
-    std::vector<std::vector<double> > *numericalSolution,
-    std::vector<std::vector<double> > *analyticalSolution, double deltaX,
-    double deltaT, std::string firstStepSolverName);
-double uniform_norm(std::vector<std::vector<double> > *matrix);
-double two_norm(std::vector<std::vector<double> > *matrix);
+/**
+ * @brief Directory of the result cache used with the --cache option
+ *
+ */
+const char RESULT_CACHE_DIRECTORY[] = ".heat_cache";
 
 /**
  * @brief This programm aim to solve numericaly a one-space dimensional heat
@@ -41,9 +48,65 @@ double two_norm(std::vector<std::vector<double> > *matrix);
  * using different schemes
  * -> Results/FirstStepSolvers for the results
  *
+ * All the solves are run in parallel by a SweepEngine (one thread per
+ * hardware thread).
+ *
+ * With the --binary option, the results of the first two parts are written
+ * in binary result files (.bin, see result_file.h) instead of CSV files. They
+ * can be converted to CSV with the result_to_csv tool.
+ *
+ * With the --adaptive option, the problem is also solved with the
+ * Crank-Nicholson scheme and an adaptive time step (see
+ * ImplicitSolver::solveAdaptive)
+ * -> Results/fullSolutionForSeveralSolvers/Crank-Nicholson adaptive.csv
+ * and the number of time steps is compared to the one of a uniform time step
+ * giving the same error at the time limit (see compareAdaptiveWithUniform).
+ * The Laasonen scheme is left out : its adaptive steps are kept short by the
+ * jump of temperature at the walls long after the errors of this transient
+ * have been damped, and it needs more steps than the uniform solve reaching
+ * the same error at the time limit.
+ *
+ * With the --cache option, the solutions of the sweep are kept on disk in
+ * RESULT_CACHE_DIRECTORY (see ResultCache) : the solutions computed by a
+ * previous run with the same problem, grids and code version are loaded
+ * instead of being solved again.
+ *
+ * With the --superposition option, the solves of the sweep differing only by
+ * their temperatures share one normalized solve, rescaled for each of them
+ * (see SuperpositionCache).
+ *
+ * With the --mesh option, the Laasonen, Crank-Nicholson and Dufort-Frankel
+ * schemes are also run on a mesh refined near the surfaces and on a mesh
+ * refined during the solve (see SpaceMesh and MeshRefinement), and their
+ * errors at a few times are compared to the ones of evenly spaced meshes.
+ *
+ * With the --adi option, the problem is also solved on a cross-section of the
+ * wall of L x L/2 with the 2D ADI scheme (see ADISolver), and the uniform norm
+ * of its errors at the time limit is printed.
+ *
  */
 int main(int argc, const char **argv) {
-  std::vector<std::vector<double> > numericalsolution, analyticalSolution;
+  bool binaryOutput = false;
+  bool adaptiveSolve = false;
+  bool meshSolve = false;
+  bool cachedSolve = false;
+  bool superpositionSolve = false;
+  bool adiSolve = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--binary") {
+      binaryOutput = true;
+    } else if (std::string(argv[i]) == "--adaptive") {
+      adaptiveSolve = true;
+    } else if (std::string(argv[i]) == "--mesh") {
+      meshSolve = true;
+    } else if (std::string(argv[i]) == "--cache") {
+      cachedSolve = true;
+    } else if (std::string(argv[i]) == "--superposition") {
+      superpositionSolve = true;
+    } else if (std::string(argv[i]) == "--adi") {
+      adiSolve = true;
+    }
+  }
 
   //==== Problem data =====
   double diffusivity = 93;         // cm²/hr
@@ -65,373 +128,246 @@ int main(int argc, const char **argv) {
   parameters.setTimeLimit(timeLimit);
 
   // ====== Solving ========
+  /* All the solves are independent : they are listed as jobs and run in
+   * parallel by the sweep engine, then the results are written in order */
 
-  ExactSolver analyticalSolver = ExactSolver();
-  LaasonenSolver laasonenSolver = LaasonenSolver();
-  RichardsonSolver richardsonSolver = RichardsonSolver();
-  CrankNicholsonSolver crankNicholsonSolver = CrankNicholsonSolver();
-  DufortFrankelSolver dufortFrankelSolver = DufortFrankelSolver();
+  std::vector<SweepJob> jobs;
 
   /* SOLVE ENTIRELY WITH DIFFERENT SCHEMES */
-  /*We use pointers to Abstract Solve because we cannot use a vector of
-   * AbstractSolver as it is an abstract class*/
-  std::vector<AbstractSolver *> solvers = {&laasonenSolver, &richardsonSolver,
-                                           &crankNicholsonSolver,
-                                           &dufortFrankelSolver};
-
-  analyticalSolver.setParameters(parameters);
-  analyticalSolver.solveRegularMeshes(deltaX, deltaT, &analyticalSolution);
-  resultToFile("Results/fullSolutionForSeveralSolvers/Analytical.csv",
-               &analyticalSolution, &analyticalSolution, deltaX, deltaT);
-
-  for (auto &solverPtr : solvers) {
-    (*solverPtr).setParameters(parameters);
-    (*solverPtr).solveRegularMeshes(deltaX, deltaT, &numericalsolution);
-    std::string filename = "Results/fullSolutionForSeveralSolvers/" +
-                           (*solverPtr).getSchemeName() + ".csv";
-    resultToFile(filename, &numericalsolution, &analyticalSolution, deltaX,
-                 deltaT);
-    numericalsolution.clear();
+  std::vector<std::string> schemes = {"Laasonen", "Richardson",
+                                      "Crank-Nicholson", "Dufort-Frankel"};
+  int analyticalJob = jobs.size();
+  jobs.push_back(SweepJob("Analytical", parameters, deltaX, deltaT));
+  int firstSchemeJob = jobs.size();
+  for (auto &scheme : schemes) {
+    jobs.push_back(SweepJob(scheme, parameters, deltaX, deltaT));
   }
 
   /* SOLVE WITH LAASONEN IMPLICIT SCHEME FOR DIFFERENT DELTA T */
+  /* For each deltaT : a Laasonen job followed by an analytical one */
   double laasonenDeltaTs[3] = {0.025, 0.05, 0.1};
+  int firstLaasonenDeltaTJob = jobs.size();
   for (double laasonenDeltaT : laasonenDeltaTs) {
-    std::string filename = "Results/LaasonnenSeveralDeltat/Laasonen Deltat = ";
-    filename.append(std::to_string(laasonenDeltaT));
-    filename.append(".csv");
-    std::vector<std::vector<double> > laasonenDeltaTSolution,
-        analyticalDeltaTSolution;
-    laasonenSolver.solveRegularMeshes(deltaX, laasonenDeltaT,
-                                      &laasonenDeltaTSolution);
-
-    analyticalSolver.solveRegularMeshes(deltaX, laasonenDeltaT,
-                                        &analyticalDeltaTSolution);
-    resultToFile(filename, &laasonenDeltaTSolution, &analyticalDeltaTSolution,
-                 deltaX, laasonenDeltaT);
+    jobs.push_back(SweepJob("Laasonen", parameters, deltaX, laasonenDeltaT));
+    jobs.push_back(SweepJob("Analytical", parameters, deltaX, laasonenDeltaT));
   }
 
   /* COMPARE DIFFERENT SOLUTION FOR COMPUTING FIRST STEP FOR RICHARDSON AND
    * DUFORT FRANKEL THREE-LEVEL SCHEMES*/
-  std::vector<AbstractSolver *> firstStepSolvers = {
-      &analyticalSolver, &crankNicholsonSolver, &laasonenSolver};
-  std::vector<AbstractSolver *> firstStepSolversWithRichardsonExtrapolation = {
-      &crankNicholsonSolver, &laasonenSolver};
-  std::vector<ExplicitSolver *> threeLevelsSolvers = {&dufortFrankelSolver,
-                                                      &richardsonSolver};
-  for (auto &threeLevelsSolver : threeLevelsSolvers) {
-    parameters.setTimeLimit(5 * deltaT);
-    threeLevelsSolver->setParameters(parameters);
-    std::string filename = "Results/FirstStepSolvers/" +
-                           threeLevelsSolver->getSchemeName() +
-                           " with serveral first steps" + ".csv";
-    std::fstream outputFileStream;
-    outputFileStream.open(filename, std::fstream::out | std::fstream::trunc);
-    outputFileStream << "deltaX:," << deltaX << ",deltaT:," << deltaT
-                     << std::endl
-                     << std::endl;
-
-    for (auto &firstStepSolverPtr : firstStepSolvers) {
-      threeLevelsSolver->setFirstStepSolver(firstStepSolverPtr, false);
-      threeLevelsSolver->solveRegularMeshes(deltaX, deltaT, &numericalsolution);
-      addFirstStepRelsultToFile(&outputFileStream, &numericalsolution,
-                                &analyticalSolution, deltaX, deltaT,
-                                firstStepSolverPtr->getSchemeName());
-      numericalsolution.clear();
+  std::vector<std::string> firstStepSchemes = {"Analytical", "Crank-Nicholson",
+                                               "Laasonen"};
+  std::vector<std::string> firstStepSchemesWithRichardsonExtrapolation = {
+      "Crank-Nicholson", "Laasonen"};
+  std::vector<std::string> threeLevelsSchemes = {"Dufort-Frankel",
+                                                 "Richardson"};
+  HeatDiffusionParameters firstStepParameters = parameters;
+  firstStepParameters.setTimeLimit(5 * deltaT);
+  int firstFirstStepJob = jobs.size();
+  for (auto &threeLevelsScheme : threeLevelsSchemes) {
+    for (auto &firstStepScheme : firstStepSchemes) {
+      jobs.push_back(SweepJob(threeLevelsScheme, firstStepParameters, deltaX,
+                              deltaT, firstStepScheme, false));
     }
-    for (auto &firstStepSolverPtr :
-         firstStepSolversWithRichardsonExtrapolation) {
-      threeLevelsSolver->setFirstStepSolver(firstStepSolverPtr, true);
-      threeLevelsSolver->solveRegularMeshes(deltaX, deltaT, &numericalsolution);
-      addFirstStepRelsultToFile(
-          &outputFileStream, &numericalsolution, &analyticalSolution, deltaX,
-          deltaT, (firstStepSolverPtr->getSchemeName() + "with RE"));
-      numericalsolution.clear();
+    for (auto &firstStepScheme : firstStepSchemesWithRichardsonExtrapolation) {
+      jobs.push_back(SweepJob(threeLevelsScheme, firstStepParameters, deltaX,
+                              deltaT, firstStepScheme, true));
     }
-    outputFileStream.close();
   }
-} /* End main*/
 
-/*=========== NORMS ===============*/
-
-/**
- * @brief Compute the two-norm / Euclidian norm of a matrix
- *
- * @param matrix : the matrix of which you want the norm
- * @return double : the two-norm of the matrix
- */
-double two_norm(std::vector<std::vector<double> > *matrix) {
-  int numberOfRows = (*matrix).size();
-  if (numberOfRows == 0) {
-    return (0);
+  SweepEngine sweepEngine;
+  std::unique_ptr<ResultCache> resultCache;
+  if (cachedSolve) {
+    resultCache.reset(new ResultCache(RESULT_CACHE_DIRECTORY));
+    sweepEngine.setResultCache(resultCache.get());
   }
-  int numberOfColumns = (*matrix)[0].size();
-  if (numberOfColumns == 0) {
-    return (0);
+  SuperpositionCache superpositionCache;
+  if (superpositionSolve) {
+    sweepEngine.setSuperpositionCache(&superpositionCache);
   }
-  double norm = 0;
-  for (std::vector<double> row : (*matrix)) {
-    for (double elt : row) {
-      norm += elt * elt;
-    }
+  std::vector<SweepResult> results = sweepEngine.run(jobs);
+  if (resultCache) {
+    std::cout << "Result cache : " << (*resultCache).getNumberOfHits()
+              << " solutions loaded, " << (*resultCache).getNumberOfMisses()
+              << " solved, " << (*resultCache).getNumberOfFailedStores()
+              << " not stored" << std::endl;
   }
-  norm = sqrtf(norm);
-  return norm;
-}
 
-/**
- * @brief Compute the uniform (maximum / infinity) norm of a matrix
- *
- * @param matrix : the matrix of which you want the norm
- * @return double : the uniform norm of the matrix
- */
-double uniform_norm(std::vector<std::vector<double> > *matrix) {
-  int numberOfRows = (*matrix).size();
-  if (numberOfRows == 0) {
-    return (0);
-  }
-  int numberOfColumns = (*matrix)[0].size();
-  if (numberOfColumns == 0) {
-    return (0);
-  }
-  double norm = 0;
-  for (std::vector<double> row : (*matrix)) {
-    for (double elt : row) {
-      if (norm <= fabs(elt)) {
-        norm = fabs(elt);
-      }
+  // ====== Writing the results ========
+  std::chrono::steady_clock::time_point outputStart =
+      std::chrono::steady_clock::now();
+
+  // Write a result in path.csv, or in path.bin with --binary
+  auto writeResult = [binaryOutput](const std::string &path,
+                                    const std::string &schemeName,
+                                    SolutionGrid *numericalSolution,
+                                    SolutionGrid *analyticalSolution,
+                                    double resultDeltaX, double resultDeltaT) {
+    if (binaryOutput) {
+      writeResultFile(path + ".bin", schemeName, *numericalSolution,
+                      analyticalSolution, resultDeltaX, resultDeltaT);
+    } else {
+      resultToFile(path + ".csv", numericalSolution, analyticalSolution,
+                   resultDeltaX, resultDeltaT);
     }
-  }
-  return norm;
-}
-
-/*=========== PRINT RESULT TO FILE ===============*/
-/**
- * @brief Printing the numerical solution and its errors compared to the
- * analytical solution
- * - The file will start with the following information :
- * ```
- * deltaX:,<value of deltaX>,deltaT:,<value of deltaT>
- * ```
- *
- * - Then we get the uniform norm and the two norm for all the points computed :
- * ```
- * Errors measurements :
- * Uniform norm :,<value of the uniform norm>
- * Two norm :,<value of the two norm>
- * ```
- *
- * - Then all the points of the numerical solution will be printed :
- * ```
- * Numerical solution :
- * t\x, ........... <values of x_j> ...................
- * ...
- * ...
- * ...
- * <values of t^n>      T^n_j
- * ...
- * ...
- * ...
- * ```
-
- * - Finally the error for each points of the numerical solution and the two
- norm and uniform norm for each time step will be printed :
- * ```
- * Errors (analytical - numerical ):
- * t\x, ..... <values of x_j> ............  Uniform norm(t)  Two norm(t)
- * ...                                <uniform norm T(t0)> <two norm T(t0)>
- * ...                                              .             .
- * ...                                              .             .
- * ...                                              .             .
- * <values of t^n> Analytical(x_j,t^n) - T^n_j      .             .
- * ...                                              .             .
- * ...                                <uniform norm T(tn)> <two norm T(tn)>
- * ...                                              .             .
- * ```
-
- * @param filename : name of the output file, should end with .csv
- * @param numericalSolution : pointer to the numerical solution
- * @param analyticalSolution : pointer to the analytical solution. The
- analytical solution should be solved for the same grid as the numerical one
- * @param deltaX : space step size
- * @param deltaT : time step size
- */
-void resultToFile(std::string filename,
-                  std::vector<std::vector<double> > *numericalSolution,
-                  std::vector<std::vector<double> > *analyticalSolution,
-                  double deltaX, double deltaT) {
-
-  std::fstream outputFileStream;
-  outputFileStream.open(filename, std::fstream::out | std::fstream::trunc);
-  outputFileStream << std::setprecision(16);
-  int numberOfRows = (*numericalSolution).size();
-  int numberOfColumns = (*numericalSolution)[0].size();
-  std::vector<std::vector<double> > errorMatrix;
-  std::vector<double> errorLine;
-  for (int i = 0; i < numberOfRows; i++) {
-    for (int j = 0; j < numberOfColumns; j++) {
-      errorLine.push_back((*analyticalSolution)[i][j] -
-                          (*numericalSolution)[i][j]);
+  };
+
+  // Speed of the solve of a result, which has none if it was loaded
+  auto speed = [](const SweepResult &result) {
+    std::ostringstream text;
+    if (result.fromCache) {
+      text << "loaded from the cache";
+    } else {
+      text << result.stepsPerSecond << " steps/s";
     }
-    errorMatrix.push_back(errorLine);
-    errorLine.clear();
+    return text.str();
+  };
+
+  SolutionGrid &analyticalSolution = results[analyticalJob].solution;
+  writeResult("Results/fullSolutionForSeveralSolvers/Analytical",
+              "Analytical", &analyticalSolution, &analyticalSolution, deltaX,
+              deltaT);
+
+  for (std::size_t i = 0; i < schemes.size(); i++) {
+    SweepResult &result = results[firstSchemeJob + i];
+    writeResult("Results/fullSolutionForSeveralSolvers/" + schemes[i],
+                schemes[i], &result.solution, &analyticalSolution, deltaX,
+                deltaT);
+    std::cout << schemes[i] << " : " << speed(result) << std::endl;
   }
 
-  double uniformNorm = uniform_norm(&errorMatrix);
-  double twoNorm = two_norm(&errorMatrix);
-
-  outputFileStream << "deltaX:," << deltaX << ",deltaT:," << deltaT << std::endl
-                   << std::endl;
+  for (int i = 0; i < 3; i++) {
+    double laasonenDeltaT = laasonenDeltaTs[i];
+    std::string filename = "Results/LaasonnenSeveralDeltat/Laasonen Deltat = ";
+    filename.append(std::to_string(laasonenDeltaT));
+    SweepResult &laasonenResult = results[firstLaasonenDeltaTJob + 2 * i];
+    SweepResult &analyticalResult = results[firstLaasonenDeltaTJob + 2 * i + 1];
+    writeResult(filename, "Laasonen", &laasonenResult.solution,
+                &analyticalResult.solution, deltaX, laasonenDeltaT);
+    std::cout << "Laasonen deltaT = " << laasonenDeltaT << " : "
+              << speed(laasonenResult) << std::endl;
+  }
 
-  outputFileStream << "Errors measurements : " << std::endl;
-  outputFileStream << "Uniform norm :," << uniformNorm << std::endl;
-  outputFileStream << "Two norm :," << twoNorm << std::endl << std::endl;
+  int job = firstFirstStepJob;
+  for (auto &threeLevelsScheme : threeLevelsSchemes) {
+    std::string filename = "Results/FirstStepSolvers/" + threeLevelsScheme +
+                           " with serveral first steps" + ".csv";
+    CsvWriter outputFile(filename);
+    outputFile << "deltaX:," << deltaX << ",deltaT:," << deltaT << "\n\n";
 
-  outputFileStream << "Numerical solution : " << std::endl;
-  outputFileStream << "t\\x";
-  for (int i = 0; i < numberOfColumns; i++) {
-    outputFileStream << "," << i * deltaX;
-  }
-  outputFileStream << "\n";
-  for (int i = 0; i < numberOfRows; i++) {
-    outputFileStream << i * deltaT;
-    for (int j = 0; j < numberOfColumns; j++) {
-      outputFileStream << "," << (*numericalSolution)[i][j];
+    for (auto &firstStepScheme : firstStepSchemes) {
+      addFirstStepRelsultToFile(&outputFile, &results[job++].solution,
+                                &analyticalSolution, deltaX, deltaT,
+                                firstStepScheme);
     }
-    outputFileStream << std::endl;
-  }
-
-  outputFileStream << std::endl
-                   << "Errors (analytical - numerical ): " << std::endl;
-  outputFileStream << "t\\x";
-  for (int i = 0; i < numberOfColumns; i++) {
-    outputFileStream << "," << i * deltaX;
-  }
-  outputFileStream << ",,uniform_norm(t),two_norm(t)\n";
-  for (int i = 0; i < numberOfRows; i++) {
-    outputFileStream << i * deltaT;
-    for (int j = 0; j < numberOfColumns; j++) {
-      outputFileStream << "," << errorMatrix[i][j];
+    for (auto &firstStepScheme : firstStepSchemesWithRichardsonExtrapolation) {
+      addFirstStepRelsultToFile(&outputFile, &results[job++].solution,
+                                &analyticalSolution, deltaX, deltaT,
+                                (firstStepScheme + "with RE"));
     }
-    std::vector<std::vector<double> > line;
-    line.push_back(errorMatrix[i]);
-    outputFileStream << ",," << uniform_norm(&line) << "," << two_norm(&line)
-                     << "\n";
+    outputFile.close();
   }
-  outputFileStream.close();
-}
-
-/**
- * @brief Add the numerical solution and its errors compared to the
- * analytical solution in an opened file stream
- *
- * This function was meant to easily print in a file different numerical
- solution find with different first step solvers. It will add a section to an
- open file following this structure :
- *
- * - The new section will start with the following informations :
- * ```
- *  First Step Solver :, <name of the first step solver>
- *  Errors measurements :
- *  Uniform norm :,<value of the uniform norm>
- *  Two norm :,<value of the two norm>
- * ```
- * - Then all the points of the numerical solution will be printed :
- * ```
- * Numerical solution :
- * t\x, ........... <values of x_j> ...................
- * ...
- * ...
- * ...
- * <values of t^n>      T^n_j
- * ...
- * ...
- * ...
- * ```
- *
- * - Finally the error for each points of the numerical solution and the two
- norm and uniform norm for each time step will be printed :
- * ```
- * Errors (analytical - numerical ):
- * t\x, ..... <values of x_j> ............  Uniform norm(t)  Two norm(t)
- * ...                                <uniform norm T(t0)> <two norm T(t0)>
- * ...                                              .             .
- * ...                                              .             .
- * ...                                              .             .
- * <values of t^n> Analytical(x_j,t^n) - T^n_j      .             .
- * ...                                              .             .
- * ...                                <uniform norm T(tn)> <two norm T(tn)>
- * ...                                              .             .
- * ```
- *
- * @param outputFileStream : where the output data are sent
- * @param numericalSolution : pointer to the numerical solution
- * @param analyticalSolution : pointer to the analytical solution. The
- analytical solution should be solved for the same grid as the numerical one
- * @param deltaX : space step size
- * @param deltaT : time step size
- * @param firstStepSolverName : name of the solver used to compute the first
- step
- */
 
-void addFirstStepRelsultToFile(
-    std::fstream *outputFileStream,
-    std::vector<std::vector<double> > *numericalSolution,
-    std::vector<std::vector<double> > *analyticalSolution, double deltaX,
-    double deltaT, std::string firstStepSolverName) {
-  (*outputFileStream) << std::setprecision(16);
-  int numberOfRows = (*numericalSolution).size();
-  int numberOfColumns = (*numericalSolution)[0].size();
-  std::vector<std::vector<double> > errorMatrix;
-  std::vector<double> errorLine;
-  for (int i = 0; i < numberOfRows; i++) {
-    for (int j = 0; j < numberOfColumns; j++) {
-      errorLine.push_back((*analyticalSolution)[i][j] -
-                          (*numericalSolution)[i][j]);
+  /* SOLVE WITH AN ADAPTIVE TIME STEP */
+  if (adaptiveSolve) {
+    double adaptiveTolerance = 1e-2; // °C on a time step
+    CrankNicholsonSolver crankNicholsonSolver;
+    std::vector<ImplicitSolver *> adaptiveSolvers = {&crankNicholsonSolver};
+    ExactSolver exactSolver;
+    exactSolver.setParameters(parameters);
+    // The first adaptive time steps are very short : the series needs more
+    // terms than the default ones
+    exactSolver.setTolerance(1e-6);
+    std::vector<AdaptiveComparison> comparisons;
+    for (ImplicitSolver *adaptiveSolver : adaptiveSolvers) {
+      AdaptiveSolution adaptiveSolution;
+      comparisons.push_back(compareAdaptiveWithUniform(
+          adaptiveSolver, parameters, deltaX, deltaT, adaptiveTolerance,
+          &adaptiveSolution));
+      SolutionGrid adaptiveAnalyticalSolution;
+      exactSolver.solveAtTimes(deltaX, adaptiveSolution.times,
+                               &adaptiveAnalyticalSolution);
+      adaptiveResultToFile("Results/fullSolutionForSeveralSolvers/" +
+                               (*adaptiveSolver).getSchemeName() +
+                               " adaptive.csv",
+                           adaptiveSolution, &adaptiveAnalyticalSolution,
+                           deltaX);
     }
-    errorMatrix.push_back(errorLine);
-    errorLine.clear();
+    writeAdaptiveReport(std::cout, comparisons);
   }
 
-  double uniformNorm = uniform_norm(&errorMatrix);
-  double twoNorm = two_norm(&errorMatrix);
-  (*outputFileStream) << std::endl
-                      << " First Step Solver :," << firstStepSolverName
-                      << std::endl;
-
-  (*outputFileStream) << "Errors measurements : " << std::endl;
-  (*outputFileStream) << "Uniform norm :," << uniformNorm << std::endl;
-  (*outputFileStream) << "Two norm :," << twoNorm << std::endl << std::endl;
-
-  (*outputFileStream) << "Numerical solution : " << std::endl;
-  (*outputFileStream) << "t\\x";
-  for (int i = 0; i < numberOfColumns; i++) {
-    (*outputFileStream) << "," << i * deltaX;
-  }
-  (*outputFileStream) << "\n";
-  for (int i = 0; i < numberOfRows; i++) {
-    (*outputFileStream) << i * deltaT;
-    for (int j = 0; j < numberOfColumns; j++) {
-      (*outputFileStream) << "," << (*numericalSolution)[i][j];
+  /* SOLVE ON MESHES REFINED NEAR THE SURFACES */
+  if (meshSolve) {
+    // Small enough for the errors to come from the space steps
+    double meshDeltaT = 1e-5; // hours
+    std::vector<double> measureTimes = {0.001, 0.01, 0.1, timeLimit};
+    SpaceMesh gradedMesh = SpaceMesh::graded(L, 0.02, 1.05, 0.25);
+    std::vector<std::pair<std::string, SpaceMesh>> meshes = {
+        {"uniform mesh deltaX = 0.05", SpaceMesh::uniform(L, deltaX)},
+        {"graded mesh", gradedMesh},
+        {"uniform mesh with as many points",
+         SpaceMesh::uniform(L, L / (gradedMesh.getNumberOfPoints() - 1))}};
+    // Refined from a coarse mesh where the temperature jumps by more than
+    // 1°C between two points, at every time step
+    SpaceMesh coarseMesh = SpaceMesh::uniform(L, 1);
+    MeshRefinement refinement(1, 0.02, 1, 1);
+
+    LaasonenSolver laasonenSolver;
+    CrankNicholsonSolver crankNicholsonSolver;
+    DufortFrankelSolver dufortFrankelSolver;
+    std::vector<AbstractSolver *> meshSolvers = {
+        &laasonenSolver, &crankNicholsonSolver, &dufortFrankelSolver};
+    std::vector<MeshComparison> comparisons;
+    for (AbstractSolver *meshSolver : meshSolvers) {
+      for (auto &mesh : meshes) {
+        comparisons.push_back(measureMeshErrors(meshSolver, parameters,
+                                                mesh.first, mesh.second,
+                                                meshDeltaT, MeshRefinement(),
+                                                measureTimes));
+      }
+      comparisons.push_back(measureMeshErrors(
+          meshSolver, parameters, "refined mesh", coarseMesh, meshDeltaT,
+          refinement, measureTimes));
     }
-    (*outputFileStream) << std::endl;
+    writeMeshReport(std::cout, comparisons);
   }
 
-  (*outputFileStream) << std::endl
-                      << "Errors (analytical - numerical ): " << std::endl;
-  (*outputFileStream) << "t\\x";
-  for (int i = 0; i < numberOfColumns; i++) {
-    (*outputFileStream) << "," << i * deltaX;
-  }
-  (*outputFileStream) << ",,uniform_norm(t),two_norm(t)\n";
-  for (int i = 0; i < numberOfRows; i++) {
-    (*outputFileStream) << i * deltaT;
-    for (int j = 0; j < numberOfColumns; j++) {
-      (*outputFileStream) << "," << errorMatrix[i][j];
+  /* SOLVE A 2D CROSS-SECTION OF THE WALL */
+  if (adiSolve) {
+    double height = L / 2; // cm
+    // Small enough to damp the oscillations caused by the jump of temperature
+    // at the surfaces, as with the Crank-Nicholson scheme
+    double adiDeltaT = 0.001; // hours
+    ADISolver adiSolver;
+    adiSolver.setParameters(parameters, height);
+    SolutionGrid adiSolution, adiAnalyticalSolution;
+    std::chrono::steady_clock::time_point adiStart =
+        std::chrono::steady_clock::now();
+    adiSolver.solve(deltaX, adiDeltaT, &adiSolution);
+    double adiSeconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - adiStart)
+                            .count();
+    int numberOfTimeSteps = parameters.getNumberOfTimeSteps(adiDeltaT);
+    adiSolver.exactSolution(deltaX, (numberOfTimeSteps - 1) * adiDeltaT,
+                            &adiAnalyticalSolution);
+    for (int j = 0; j < adiSolution.getNumberOfRows(); j++) {
+      for (int i = 0; i < adiSolution.getNumberOfColumns(); i++) {
+        adiAnalyticalSolution(j, i) -= adiSolution(j, i);
+      }
     }
-    std::vector<std::vector<double> > line;
-    line.push_back(errorMatrix[i]);
-    (*outputFileStream) << ",," << uniform_norm(&line) << "," << two_norm(&line)
-                        << "\n";
+    std::cout << "ADI " << L << " x " << height << " cm : "
+              << adiSolution.getNumberOfColumns() << " x "
+              << adiSolution.getNumberOfRows() << " points, "
+              << numberOfTimeSteps - 1 << " time steps in " << adiSeconds
+              << " s, uniform norm of the errors at the time limit : "
+              << norms::uniformNorm(adiAnalyticalSolution.view()) << std::endl;
   }
-}
+
+  double outputSeconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - outputStart)
+                             .count();
+  std::cout << "Output : " << CsvWriter::getTotalBytesWritten()
+            << " bytes of CSV, "
+            << CsvWriter::getTotalBytesWritten() / outputSeconds
+            << " bytes/s" << std::endl;
+  HEAT_WRITE_REPORT(std::cout, "instrumentation.json");
+} /* End main*/
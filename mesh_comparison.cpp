@@ -0,0 +1,76 @@
+#include "mesh_comparison.h"
+#include "exact_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+/**
+ * @brief Tolerance of the analytical solution used as a reference, well
+ * below the errors measured
+ *
+ */
+const double REFERENCE_TOLERANCE = 1e-10;
+} // namespace
+
+MeshComparison measureMeshErrors(AbstractSolver *solver,
+                                 const HeatDiffusionParameters &parameters,
+                                 const std::string &meshName,
+                                 const SpaceMesh &mesh, double deltaT,
+                                 const MeshRefinement &refinement,
+                                 const std::vector<double> &times) {
+  (*solver).setParameters(parameters);
+  ExactSolver exactSolver;
+  exactSolver.setParameters(parameters);
+  exactSolver.setTolerance(REFERENCE_TOLERANCE);
+
+  MeshComparison comparison;
+  comparison.schemeName = (*solver).getSchemeName();
+  comparison.meshName = meshName;
+  comparison.times = times;
+  comparison.numberOfPoints.assign(times.size(), 0);
+  comparison.errors.assign(times.size(), 0);
+  std::vector<double> analyticalSolution;
+  (*solver).solveOnMesh(
+      mesh, deltaT,
+      [&](int timeIndex, const SpaceMesh &stepMesh,
+          const double *temperatures) {
+        for (std::size_t i = 0; i < times.size(); i++) {
+          if (lround(times[i] / deltaT) != timeIndex) {
+            continue;
+          }
+          int numberOfPoints = stepMesh.getNumberOfPoints();
+          analyticalSolution.resize(numberOfPoints);
+          exactSolver.solveOnMeshAt(stepMesh, timeIndex * deltaT,
+                                    analyticalSolution.data());
+          double error = 0;
+          for (int j = 0; j < numberOfPoints; j++) {
+            error =
+                std::max(error, fabs(analyticalSolution[j] - temperatures[j]));
+          }
+          comparison.numberOfPoints[i] = numberOfPoints;
+          comparison.errors[i] = error;
+        }
+      },
+      refinement);
+  return comparison;
+}
+
+void writeMeshReport(std::ostream &outputStream,
+                     const std::vector<MeshComparison> &comparisons) {
+  std::ios::fmtflags flags = outputStream.flags();
+  std::streamsize precision = outputStream.precision();
+  outputStream << std::setprecision(3);
+  for (const MeshComparison &comparison : comparisons) {
+    outputStream << comparison.schemeName << " on " << comparison.meshName
+                 << " :";
+    for (std::size_t i = 0; i < comparison.times.size(); i++) {
+      outputStream << " t = " << comparison.times[i] << " : "
+                   << comparison.numberOfPoints[i] << " points, error "
+                   << comparison.errors[i] << ";";
+    }
+    outputStream << "\n";
+  }
+  outputStream.flags(flags);
+  outputStream.precision(precision);
+}
@@ -0,0 +1,57 @@
+#pragma once // Include guard
+#include "abstract_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "space_mesh.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Errors of a solve on a mesh at a few times (see measureMeshErrors)
+ *
+ */
+struct MeshComparison {
+  std::string schemeName;
+  std::string meshName;
+  /**
+   * @brief For each time measured : the time, the number of points of the
+   * mesh at this time and the uniform norm of the errors
+   *
+   */
+  std::vector<double> times;
+  std::vector<int> numberOfPoints;
+  std::vector<double> errors;
+};
+
+/**
+ * @brief Solve the issue on a mesh and measure the uniform norm of the
+ * errors at some times, the analytical solution being computed on the mesh
+ * of each of these times by an ExactSolver with a tolerance well below the
+ * errors. Each time is rounded to the closest time step.
+ *
+ * Can throw an invalid_argument exception if the parameters are not
+ * initialized
+ *
+ * @param solver : solver to use, its parameters are replaced by parameters
+ * @param parameters : parameters of the issue
+ * @param meshName : name of the mesh in the report
+ * @param mesh : mesh of the solve
+ * @param deltaT : size of the time step
+ * @param refinement : how the mesh is adapted during the solve
+ * @param times : times at which the errors are measured
+ * @return MeshComparison : the errors
+ */
+MeshComparison measureMeshErrors(AbstractSolver *solver,
+                                 const HeatDiffusionParameters &parameters,
+                                 const std::string &meshName,
+                                 const SpaceMesh &mesh, double deltaT,
+                                 const MeshRefinement &refinement,
+                                 const std::vector<double> &times);
+
+/**
+ * @brief Write one line per measure : scheme, mesh, and the number of points
+ * and the error at each time
+ *
+ */
+void writeMeshReport(std::ostream &outputStream,
+                     const std::vector<MeshComparison> &comparisons);
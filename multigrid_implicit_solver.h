@@ -0,0 +1,196 @@
+#pragma once // Include guard
+#include "exact_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "multigrid_solver.h"
+#include "solution_grid.h"
+#include "solver_engine.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+/**
+ * @brief Solver of the heat conduction problem on a rectangle (2D) or a box
+ * (3D) with an implicit scheme policy (scheme::Laasonen or
+ * scheme::CrankNicholson), each time step being solved by a MultigridSolver
+ *
+ * The box is width x height x depth (depth 0 for a rectangle), with the
+ * surface temperature on all its faces and the internal temperature inside
+ * at t=0, and the same space step deltaX in all the directions. Each time
+ * step solves
+ * T(n+1) - w D deltaT d2T(n+1) = T(n) + (1 - w) D deltaT d2T(n)
+ * with w the implicit weight of the scheme and d2 the sum of the three points
+ * second differences along each direction, the previous time step being the
+ * first guess of the V-cycles. The temperatures are stored as described in
+ * MultigridSolver : row k * ny + j holds the points y = j * deltaX,
+ * z = k * deltaX.
+ */
+template <class Scheme> class MultigridImplicitSolver {
+  static_assert(Scheme::isImplicit,
+                "MultigridImplicitSolver needs an implicit scheme");
+
+public:
+  /**
+   * @brief Function called with each time step computed, given by its index
+   * (time timeIndex * deltaT) and its temperatures
+   *
+   */
+  typedef std::function<void(int timeIndex, const SolutionGrid &temperatures)>
+      FieldSink;
+
+  /**
+   * @brief Set up the parameters of the problem : the width of the box is
+   * the width of parameters
+   *
+   * Can throw an invalid_argument exception if parameters are not all
+   * initialized, if height is not positive or if depth is negative
+   *
+   * @param problemParameters : parameters of the problem
+   * @param pheight : height of the box
+   * @param pdepth : depth of the box, 0 for a rectangle
+   */
+  void setParameters(const HeatDiffusionParameters &problemParameters,
+                     double pheight, double pdepth = 0) {
+    if (!problemParameters.checkInitialization()) {
+      throw(std::invalid_argument(
+          "Parameters have not yet been properly initialized"));
+    }
+    if (pheight <= 0 || pdepth < 0) {
+      throw(std::invalid_argument(
+          "the height should be positive and the depth not negative"));
+    }
+    parameters = problemParameters;
+    height = pheight;
+    depth = pdepth;
+  }
+
+  /**
+   * @brief Set the tolerance of the multigrid solve of each time step (see
+   * MultigridSolver::setTolerance)
+   *
+   */
+  void setTolerance(double tolerance) { multigrid.setTolerance(tolerance); }
+
+  /**
+   * @brief Solve the problem up to the time limit
+   *
+   * Can throw an invalid_argument exception if the parameters are not set or
+   * if deltaX or deltaT are not positive, or the exceptions of
+   * MultigridSolver::solve
+   *
+   * @param deltaX : size of the space step, in all the directions
+   * @param deltaT : size of the time step
+   * @param temperatures : where the temperatures at the last time step are
+   * stored
+   */
+  void solve(double deltaX, double deltaT, SolutionGrid *temperatures) {
+    solveStreaming(deltaX, deltaT, FieldSink());
+    *temperatures = current;
+  }
+
+  /**
+   * @brief Solve the problem up to the time limit, handing each time step to
+   * sink, the initial state included. Only the current time step is kept in
+   * memory.
+   *
+   * @param deltaX : size of the space step, in all the directions
+   * @param deltaT : size of the time step
+   * @param sink : function called with each time step, in order, can be
+   * empty
+   */
+  void solveStreaming(double deltaX, double deltaT, FieldSink sink) {
+    if (height <= 0) {
+      throw(std::invalid_argument(
+          "Parameters have not yet been properly initialized"));
+    }
+    if (deltaX <= 0 || deltaT <= 0) {
+      throw(std::invalid_argument("deltaX and deltaT should be positive"));
+    }
+    HeatDiffusionParameters directionParameters(parameters);
+    int numberOfColumns = parameters.getNumberOfSpacePoints(deltaX);
+    directionParameters.setWidth(height);
+    int numberOfRows = directionParameters.getNumberOfSpacePoints(deltaX);
+    int numberOfLayers = 1;
+    if (depth > 0) {
+      directionParameters.setWidth(depth);
+      numberOfLayers = directionParameters.getNumberOfSpacePoints(deltaX);
+    }
+    // w D deltaT / deltaX^2 for both schemes
+    double c = Scheme::coupling(parameters.getDiffusivity(), deltaT, deltaX);
+    multigrid.setOperator(numberOfColumns, numberOfRows, numberOfLayers, c, c,
+                          c);
+    double explicitWeight =
+        (1 - Scheme::implicitWeight()) / Scheme::implicitWeight();
+
+    initialState(numberOfColumns, numberOfRows, numberOfLayers);
+    rightHandSide = current;
+    if (sink) {
+      sink(0, current);
+    }
+    numberOfCycles = 0;
+    double timeStop = parameters.getTimeStop();
+    for (int timeIndex = 1; (timeIndex * deltaT) <= timeStop; timeIndex++) {
+      multigrid.explicitPart(current, explicitWeight, &rightHandSide);
+      numberOfCycles += multigrid.solve(rightHandSide, &current);
+      if (sink) {
+        sink(timeIndex, current);
+      }
+    }
+  }
+
+  /**
+   * @brief Analytical solution at a given time, on the grid of solve (see
+   * ExactSolver::solveBoxAt)
+   *
+   */
+  void exactSolution(double deltaX, double time,
+                     SolutionGrid *temperatures) const {
+    ExactSolver exactSolver;
+    exactSolver.setParameters(parameters);
+    exactSolver.solveBoxAt(deltaX, height, depth, time, temperatures);
+  }
+
+  /**
+   * @brief Get the number of V-cycles of the last solve, over all its time
+   * steps
+   *
+   */
+  int getNumberOfCycles() const { return numberOfCycles; }
+
+  /**
+   * @brief Get the number of levels of the multigrid solver of the last solve
+   *
+   */
+  int getNumberOfLevels() const { return multigrid.getNumberOfLevels(); }
+
+private:
+  HeatDiffusionParameters parameters;
+  double height = 0;
+  double depth = 0;
+  MultigridSolver multigrid;
+  /**
+   * @brief temperatures of the current time step, and right hand side of the
+   * next one
+   *
+   */
+  SolutionGrid current, rightHandSide;
+  int numberOfCycles = 0;
+
+  void initialState(int numberOfColumns, int numberOfRows,
+                    int numberOfLayers) {
+    current.resize(numberOfRows * numberOfLayers, numberOfColumns);
+    double surfaceTemperature = parameters.getSurfaceTemperature();
+    double internalTemperature = parameters.getInternalTemperature();
+    for (int k = 0; k < numberOfLayers; k++) {
+      bool surfaceLayer =
+          numberOfLayers > 1 && (k == 0 || k == numberOfLayers - 1);
+      for (int j = 0; j < numberOfRows; j++) {
+        double *line = current.row(k * numberOfRows + j);
+        bool surface = surfaceLayer || j == 0 || j == numberOfRows - 1;
+        std::fill(line, line + numberOfColumns,
+                  surface ? surfaceTemperature : internalTemperature);
+        line[0] = surfaceTemperature;
+        line[numberOfColumns - 1] = surfaceTemperature;
+      }
+    }
+  }
+};
@@ -0,0 +1,406 @@
+#include "multigrid_solver.h"
+#include "instrumentation.h"
+#include "norms.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+constexpr double MultigridSolver::DEFAULT_TOLERANCE;
+
+namespace {
+
+/**
+ * @brief Largest number of Gauss-Seidel sweeps on the coarsest level, and
+ * reduction of its residual at which they stop
+ *
+ */
+const int MAXIMUM_COARSEST_SWEEPS = 1000;
+const double COARSEST_REDUCTION = 1e-3;
+
+/**
+ * @brief Number of Gauss-Seidel sweeps on the coarsest level between two
+ * checks of its residual
+ *
+ */
+const int COARSEST_SWEEPS_PER_CHECK = 8;
+
+/**
+ * @brief Whether a direction of n points can be made coarser : its number of
+ * intervals should be even, and the coarser direction keep at least one
+ * inner point
+ *
+ */
+bool canBeCoarser(int numberOfPoints) {
+  return (numberOfPoints - 1) % 2 == 0 && numberOfPoints - 1 >= 4;
+}
+
+/**
+ * @brief Call body(j, k) for every row of a grid inside the box (0 < j <
+ * ny - 1, and 0 < k < nz - 1 in 3D or k = 0 in 2D), by blocks of
+ * MultigridSolver::LINES_PER_TASK rows spread over the thread pool
+ *
+ */
+void forEachInnerRow(int numberOfRows, int numberOfLayers,
+                     const std::function<void(int, int)> &body) {
+  int innerRows = numberOfRows - 2;
+  int firstLayer = numberOfLayers > 1 ? 1 : 0;
+  int innerLayers = numberOfLayers > 1 ? numberOfLayers - 2 : 1;
+  int numberOfLines = innerRows * innerLayers;
+  int numberOfBlocks =
+      (numberOfLines + MultigridSolver::LINES_PER_TASK - 1) /
+      MultigridSolver::LINES_PER_TASK;
+  ThreadPool::shared().parallelFor(0, numberOfBlocks, [&](int block) {
+    int firstLine = block * MultigridSolver::LINES_PER_TASK;
+    int lastLine =
+        std::min(numberOfLines, firstLine + MultigridSolver::LINES_PER_TASK);
+    for (int line = firstLine; line < lastLine; line++) {
+      body(1 + line % innerRows, firstLayer + line / innerRows);
+    }
+  });
+}
+
+/**
+ * @brief Rows of a coarser level (or finer one) contributing to a row along
+ * one direction, with their weights
+ *
+ */
+struct Stencil {
+  int numberOfTerms;
+  int indices[3];
+  double weights[3];
+};
+
+/**
+ * @brief Full weighting of the fine rows around the coarse row index
+ *
+ */
+Stencil restrictionStencil(int index, bool coarser) {
+  if (!coarser) {
+    return {1, {index, 0, 0}, {1, 0, 0}};
+  }
+  return {3, {2 * index - 1, 2 * index, 2 * index + 1}, {0.25, 0.5, 0.25}};
+}
+
+/**
+ * @brief Linear interpolation of the coarse rows around the fine row index
+ *
+ */
+Stencil interpolationStencil(int index, bool coarser) {
+  if (!coarser) {
+    return {1, {index, 0, 0}, {1, 0, 0}};
+  }
+  if (index % 2 == 0) {
+    return {1, {index / 2, 0, 0}, {1, 0, 0}};
+  }
+  return {2, {(index - 1) / 2, (index + 1) / 2, 0}, {0.5, 0.5, 0}};
+}
+
+} // namespace
+
+void MultigridSolver::setOperator(int numberOfColumns, int numberOfRows,
+                                  int numberOfLayers, double couplingX,
+                                  double couplingY, double couplingZ) {
+  if (numberOfColumns < 3 || numberOfRows < 3 || numberOfLayers < 1 ||
+      numberOfLayers == 2) {
+    throw(std::invalid_argument(
+        "the box should have at least 3 points in each direction"));
+  }
+  if (couplingX < 0 || couplingY < 0 || couplingZ < 0) {
+    throw(std::invalid_argument("the couplings should not be negative"));
+  }
+  levels.clear();
+  Level level;
+  level.numberOfColumns = numberOfColumns;
+  level.numberOfRows = numberOfRows;
+  level.numberOfLayers = numberOfLayers;
+  level.couplingX = couplingX;
+  level.couplingY = couplingY;
+  level.couplingZ = numberOfLayers > 1 ? couplingZ : 0;
+  while (true) {
+    level.diagonal =
+        1 + 2 * (level.couplingX + level.couplingY + level.couplingZ);
+    level.coarserX = canBeCoarser(level.numberOfColumns);
+    level.coarserY = canBeCoarser(level.numberOfRows);
+    level.coarserZ =
+        level.numberOfLayers > 1 && canBeCoarser(level.numberOfLayers);
+    int gridRows = level.numberOfRows * level.numberOfLayers;
+    level.residual.resize(gridRows, level.numberOfColumns);
+    // The finest level works on the grids given to solve
+    if (!levels.empty()) {
+      level.correction.resize(gridRows, level.numberOfColumns);
+      level.rightHandSide.resize(gridRows, level.numberOfColumns);
+    }
+    levels.push_back(level);
+    if (!level.coarserX && !level.coarserY && !level.coarserZ) {
+      break;
+    }
+    if (level.coarserX) {
+      level.numberOfColumns = (level.numberOfColumns - 1) / 2 + 1;
+      level.couplingX /= 4;
+    }
+    if (level.coarserY) {
+      level.numberOfRows = (level.numberOfRows - 1) / 2 + 1;
+      level.couplingY /= 4;
+    }
+    if (level.coarserZ) {
+      level.numberOfLayers = (level.numberOfLayers - 1) / 2 + 1;
+      level.couplingZ /= 4;
+    }
+  }
+}
+
+void MultigridSolver::setTolerance(double ptolerance) {
+  if (ptolerance <= 0) {
+    throw(std::invalid_argument("the tolerance should be positive"));
+  }
+  tolerance = ptolerance;
+}
+
+void MultigridSolver::setMaximumNumberOfCycles(int numberOfCycles) {
+  if (numberOfCycles <= 0) {
+    throw(std::invalid_argument(
+        "the maximum number of cycles should be positive"));
+  }
+  maximumNumberOfCycles = numberOfCycles;
+}
+
+int MultigridSolver::solve(const SolutionGrid &rightHandSide,
+                           SolutionGrid *solution) {
+  HEAT_TIMED_SCOPE("multigrid.solve");
+  if (levels.empty()) {
+    throw(std::logic_error("the operator of the multigrid solver is not set"));
+  }
+  Level &finest = levels[0];
+  int gridRows = finest.numberOfRows * finest.numberOfLayers;
+  if (rightHandSide.getNumberOfRows() != gridRows ||
+      rightHandSide.getNumberOfColumns() != finest.numberOfColumns ||
+      (*solution).getNumberOfRows() != gridRows ||
+      (*solution).getNumberOfColumns() != finest.numberOfColumns) {
+    throw(std::invalid_argument(
+        "the grids should have the size of the operator"));
+  }
+  double largestResidual = tolerance * norms::uniformNorm(rightHandSide.view());
+  computeResidual(finest, rightHandSide, *solution, &finest.residual);
+  int numberOfCycles = 0;
+  while (norms::uniformNorm(finest.residual.view()) > largestResidual) {
+    if (numberOfCycles == maximumNumberOfCycles) {
+      throw(std::runtime_error("the multigrid solver did not converge in " +
+                               std::to_string(maximumNumberOfCycles) +
+                               " cycles"));
+    }
+    vCycle(0, rightHandSide, solution);
+    numberOfCycles++;
+    computeResidual(finest, rightHandSide, *solution, &finest.residual);
+  }
+  HEAT_COUNT("multigrid.cycles", numberOfCycles);
+  return numberOfCycles;
+}
+
+void MultigridSolver::vCycle(int levelIndex, const SolutionGrid &rightHandSide,
+                             SolutionGrid *solution) {
+  Level &level = levels[levelIndex];
+  if (levelIndex + 1 == (int)levels.size()) {
+    solveCoarsest(level, rightHandSide, solution);
+    return;
+  }
+  smooth(level, rightHandSide, solution, SMOOTHING_SWEEPS);
+  computeResidual(level, rightHandSide, *solution, &level.residual);
+  Level &coarse = levels[levelIndex + 1];
+  restrictResidual(level, &coarse);
+  coarse.correction.resize(coarse.numberOfRows * coarse.numberOfLayers,
+                           coarse.numberOfColumns);
+  vCycle(levelIndex + 1, coarse.rightHandSide, &coarse.correction);
+  addCorrection(level, coarse, solution);
+  smooth(level, rightHandSide, solution, SMOOTHING_SWEEPS);
+}
+
+void MultigridSolver::solveCoarsest(Level &level,
+                                    const SolutionGrid &rightHandSide,
+                                    SolutionGrid *solution) const {
+  computeResidual(level, rightHandSide, *solution, &level.residual);
+  double largestResidual =
+      COARSEST_REDUCTION * norms::uniformNorm(level.residual.view());
+  for (int sweeps = 0; sweeps < MAXIMUM_COARSEST_SWEEPS;
+       sweeps += COARSEST_SWEEPS_PER_CHECK) {
+    smooth(level, rightHandSide, solution, COARSEST_SWEEPS_PER_CHECK);
+    computeResidual(level, rightHandSide, *solution, &level.residual);
+    if (norms::uniformNorm(level.residual.view()) <= largestResidual) {
+      return;
+    }
+  }
+}
+
+void MultigridSolver::smooth(const Level &level,
+                             const SolutionGrid &rightHandSide,
+                             SolutionGrid *solution, int numberOfSweeps) const {
+  int numberOfColumns = level.numberOfColumns;
+  int numberOfRows = level.numberOfRows;
+  bool threeDimensional = level.numberOfLayers > 1;
+  double cx = level.couplingX;
+  double cy = level.couplingY;
+  double cz = level.couplingZ;
+  double inverseDiagonal = 1 / level.diagonal;
+  for (int sweep = 0; sweep < numberOfSweeps; sweep++) {
+    // The points of a colour only depend on the points of the other one :
+    // the rows of a colour can be relaxed in any order
+    for (int colour = 0; colour < 2; colour++) {
+      forEachInnerRow(numberOfRows, level.numberOfLayers, [&](int j, int k) {
+        int row = k * numberOfRows + j;
+        double *u = (*solution).row(row);
+        const double *f = rightHandSide.row(row);
+        const double *south = (*solution).row(row - 1);
+        const double *north = (*solution).row(row + 1);
+        int first = ((1 + j + k) % 2 == colour) ? 1 : 2;
+        if (threeDimensional) {
+          const double *below = (*solution).row(row - numberOfRows);
+          const double *above = (*solution).row(row + numberOfRows);
+          for (int i = first; i < numberOfColumns - 1; i += 2) {
+            u[i] = (f[i] + cx * (u[i - 1] + u[i + 1]) +
+                    cy * (south[i] + north[i]) + cz * (below[i] + above[i])) *
+                   inverseDiagonal;
+          }
+        } else {
+          for (int i = first; i < numberOfColumns - 1; i += 2) {
+            u[i] = (f[i] + cx * (u[i - 1] + u[i + 1]) +
+                    cy * (south[i] + north[i])) *
+                   inverseDiagonal;
+          }
+        }
+      });
+    }
+  }
+}
+
+void MultigridSolver::computeResidual(const Level &level,
+                                      const SolutionGrid &rightHandSide,
+                                      const SolutionGrid &solution,
+                                      SolutionGrid *residual) const {
+  int numberOfColumns = level.numberOfColumns;
+  int numberOfRows = level.numberOfRows;
+  bool threeDimensional = level.numberOfLayers > 1;
+  double cx = level.couplingX;
+  double cy = level.couplingY;
+  double cz = level.couplingZ;
+  double diagonal = level.diagonal;
+  forEachInnerRow(numberOfRows, level.numberOfLayers, [&](int j, int k) {
+    int row = k * numberOfRows + j;
+    const double *u = solution.row(row);
+    const double *f = rightHandSide.row(row);
+    const double *south = solution.row(row - 1);
+    const double *north = solution.row(row + 1);
+    double *r = (*residual).row(row);
+    for (int i = 1; i < numberOfColumns - 1; i++) {
+      r[i] = f[i] - (diagonal * u[i] - cx * (u[i - 1] + u[i + 1]) -
+                     cy * (south[i] + north[i]));
+    }
+    if (threeDimensional) {
+      const double *below = solution.row(row - numberOfRows);
+      const double *above = solution.row(row + numberOfRows);
+      for (int i = 1; i < numberOfColumns - 1; i++) {
+        r[i] += cz * (below[i] + above[i]);
+      }
+    }
+  });
+}
+
+void MultigridSolver::restrictResidual(const Level &level,
+                                       Level *coarse) const {
+  int numberOfRows = level.numberOfRows;
+  int coarseColumns = (*coarse).numberOfColumns;
+  int coarseRows = (*coarse).numberOfRows;
+  bool threeDimensional = level.numberOfLayers > 1;
+  forEachInnerRow(coarseRows, (*coarse).numberOfLayers, [&](int J, int K) {
+    double *coarseRow = (*coarse).rightHandSide.row(K * coarseRows + J);
+    std::fill(coarseRow + 1, coarseRow + coarseColumns - 1, 0.0);
+    Stencil alongY = restrictionStencil(J, level.coarserY);
+    Stencil alongZ = threeDimensional ? restrictionStencil(K, level.coarserZ)
+                                      : restrictionStencil(0, false);
+    for (int b = 0; b < alongZ.numberOfTerms; b++) {
+      for (int a = 0; a < alongY.numberOfTerms; a++) {
+        const double *r = level.residual.row(
+            alongZ.indices[b] * numberOfRows + alongY.indices[a]);
+        double weight = alongY.weights[a] * alongZ.weights[b];
+        if (level.coarserX) {
+          for (int I = 1; I < coarseColumns - 1; I++) {
+            coarseRow[I] += weight * (0.25 * r[2 * I - 1] + 0.5 * r[2 * I] +
+                                      0.25 * r[2 * I + 1]);
+          }
+        } else {
+          for (int I = 1; I < coarseColumns - 1; I++) {
+            coarseRow[I] += weight * r[I];
+          }
+        }
+      }
+    }
+  });
+}
+
+void MultigridSolver::addCorrection(const Level &level, const Level &coarse,
+                                    SolutionGrid *solution) const {
+  int numberOfColumns = level.numberOfColumns;
+  int numberOfRows = level.numberOfRows;
+  int coarseRows = coarse.numberOfRows;
+  bool threeDimensional = level.numberOfLayers > 1;
+  forEachInnerRow(numberOfRows, level.numberOfLayers, [&](int j, int k) {
+    double *u = (*solution).row(k * numberOfRows + j);
+    Stencil alongY = interpolationStencil(j, level.coarserY);
+    Stencil alongZ = threeDimensional ? interpolationStencil(k, level.coarserZ)
+                                      : interpolationStencil(0, false);
+    for (int b = 0; b < alongZ.numberOfTerms; b++) {
+      for (int a = 0; a < alongY.numberOfTerms; a++) {
+        const double *c = coarse.correction.row(
+            alongZ.indices[b] * coarseRows + alongY.indices[a]);
+        double weight = alongY.weights[a] * alongZ.weights[b];
+        if (level.coarserX) {
+          for (int i = 1; i < numberOfColumns - 1; i += 2) {
+            u[i] += weight * (0.5 * (c[i / 2] + c[i / 2 + 1]));
+          }
+          for (int i = 2; i < numberOfColumns - 1; i += 2) {
+            u[i] += weight * c[i / 2];
+          }
+        } else {
+          for (int i = 1; i < numberOfColumns - 1; i++) {
+            u[i] += weight * c[i];
+          }
+        }
+      }
+    }
+  });
+}
+
+void MultigridSolver::explicitPart(const SolutionGrid &temperatures,
+                                   double weight, SolutionGrid *result) const {
+  if (levels.empty()) {
+    throw(std::logic_error("the operator of the multigrid solver is not set"));
+  }
+  const Level &finest = levels[0];
+  int numberOfColumns = finest.numberOfColumns;
+  int numberOfRows = finest.numberOfRows;
+  bool threeDimensional = finest.numberOfLayers > 1;
+  double cx = finest.couplingX;
+  double cy = finest.couplingY;
+  double cz = finest.couplingZ;
+  forEachInnerRow(numberOfRows, finest.numberOfLayers, [&](int j, int k) {
+    int row = k * numberOfRows + j;
+    const double *u = temperatures.row(row);
+    const double *south = temperatures.row(row - 1);
+    const double *north = temperatures.row(row + 1);
+    double *B = (*result).row(row);
+    for (int i = 1; i < numberOfColumns - 1; i++) {
+      B[i] = cx * (u[i - 1] - 2 * u[i] + u[i + 1]) +
+             cy * (south[i] - 2 * u[i] + north[i]);
+    }
+    if (threeDimensional) {
+      const double *below = temperatures.row(row - numberOfRows);
+      const double *above = temperatures.row(row + numberOfRows);
+      for (int i = 1; i < numberOfColumns - 1; i++) {
+        B[i] += cz * (below[i] - 2 * u[i] + above[i]);
+      }
+    }
+    for (int i = 1; i < numberOfColumns - 1; i++) {
+      B[i] = u[i] + weight * B[i];
+    }
+  });
+}
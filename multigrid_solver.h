@@ -0,0 +1,190 @@
+#pragma once // Include guard
+#include "solution_grid.h"
+#include <vector>
+
+/**
+ * @brief Matrix-free geometric multigrid solver of the linear systems of the
+ * implicit schemes in 2D and 3D
+ *
+ * The system is A u = f on a box of nx x ny x nz points (nz = 1 in 2D) with
+ * the values of u given on the faces of the box (Dirichlet boundary
+ * conditions). Inside the box :
+ * (A u)(i,j,k) = (1 + 2 cx + 2 cy + 2 cz) u(i,j,k)
+ *   - cx (u(i-1,j,k) + u(i+1,j,k)) - cy (u(i,j-1,k) + u(i,j+1,k))
+ *   - cz (u(i,j,k-1) + u(i,j,k+1))
+ * that is I - D deltaT d2/dx2 with the three points second differences, as for
+ * the 1D implicit schemes. A grid of the box is a SolutionGrid of ny * nz rows
+ * of nx columns : row k * ny + j holds the points (i, j, k) for all i.
+ *
+ * Each V-cycle smooths the error with red-black Gauss-Seidel sweeps, restricts
+ * the residual to a coarser grid by full weighting, solves the coarse system
+ * recursively, and adds the correction interpolated linearly. A direction is
+ * made coarser (every other point kept, coupling divided by 4) while its
+ * number of intervals is even and at least 4; the levels stop when no
+ * direction can be made coarser, and the coarsest system is solved by
+ * Gauss-Seidel sweeps. The cycles are thus cheapest when the number of
+ * intervals of each direction is a multiple of a large power of 2 : every
+ * level has then about 1/4 (2D) or 1/8 (3D) of the points of the previous
+ * one, and a cycle costs O(N) for N points.
+ *
+ * Nothing is allocated by solve once setOperator has been called. All the
+ * sweeps are spread over the threads of ThreadPool::shared() by blocks of
+ * LINES_PER_TASK rows of the grids; the results do not depend on the number of
+ * threads.
+ */
+class MultigridSolver {
+public:
+  /**
+   * @brief Default largest residual allowed, relative to the right hand side
+   * (see setTolerance)
+   *
+   */
+  static constexpr double DEFAULT_TOLERANCE = 1e-8;
+
+  /**
+   * @brief Default largest number of V-cycles of a solve
+   *
+   */
+  static const int DEFAULT_MAXIMUM_NUMBER_OF_CYCLES = 50;
+
+  /**
+   * @brief Number of Gauss-Seidel sweeps before and after the coarse
+   * correction of each level
+   *
+   */
+  static const int SMOOTHING_SWEEPS = 2;
+
+  /**
+   * @brief Number of rows of a grid handled by one task of the thread pool
+   *
+   */
+  static const int LINES_PER_TASK = 16;
+
+  /**
+   * @brief Set the size of the grids and the couplings of the operator, and
+   * build the coarser levels
+   *
+   * Can throw an invalid_argument exception if a size is too small (at least
+   * 3 points in x and y, 1 or at least 3 in z) or a coupling negative
+   *
+   * @param numberOfColumns : number of points nx along x
+   * @param numberOfRows : number of points ny along y
+   * @param numberOfLayers : number of points nz along z, 1 in 2D
+   * @param couplingX : cx = D deltaT / deltaX^2 times the implicit weight
+   * @param couplingY : cy, same along y
+   * @param couplingZ : cz, same along z (not used in 2D)
+   */
+  void setOperator(int numberOfColumns, int numberOfRows, int numberOfLayers,
+                   double couplingX, double couplingY, double couplingZ);
+
+  /**
+   * @brief Set the largest residual allowed : a solve stops once the uniform
+   * norm of f - A u is at most tolerance times the one of f
+   *
+   * Can throw an invalid_argument exception if tolerance is not positive
+   */
+  void setTolerance(double tolerance);
+
+  /**
+   * @brief Set the largest number of V-cycles of a solve
+   *
+   * Can throw an invalid_argument exception if it is not positive
+   */
+  void setMaximumNumberOfCycles(int numberOfCycles);
+
+  /**
+   * @brief Solve A u = f with V-cycles
+   *
+   * Can throw a logic_error exception if setOperator has not been called, an
+   * invalid_argument one if the grids do not have the size of the operator,
+   * or a runtime_error one if the tolerance is not reached within the
+   * maximum number of cycles
+   *
+   * @param rightHandSide : f, its values on the faces are not used
+   * @param solution : u, holding the first guess inside the box and the
+   * boundary conditions on its faces, which are kept
+   * @return int : number of V-cycles done
+   */
+  int solve(const SolutionGrid &rightHandSide, SolutionGrid *solution);
+
+  /**
+   * @brief Compute result = u + weight * (cx d2x + cy d2y + cz d2z) u inside
+   * the box, the explicit part of a scheme mixing both time levels (weight
+   * (1 - w) / w for an implicit weight w). The faces of result are not
+   * written.
+   *
+   * Can throw a logic_error exception if setOperator has not been called
+   */
+  void explicitPart(const SolutionGrid &temperatures, double weight,
+                    SolutionGrid *result) const;
+
+  /**
+   * @brief Get the number of levels, the finest one included
+   *
+   */
+  int getNumberOfLevels() const { return (int)levels.size(); }
+
+private:
+  /**
+   * @brief Grid size and operator of a level, with the grids of its
+   * correction, of its right hand side (unused on the finest level, where
+   * the ones of solve are used) and of its residual
+   *
+   */
+  struct Level {
+    int numberOfColumns, numberOfRows, numberOfLayers;
+    double couplingX, couplingY, couplingZ;
+    double diagonal;
+    /**
+     * @brief whether the next level is coarser along each direction
+     *
+     */
+    bool coarserX, coarserY, coarserZ;
+    SolutionGrid correction, rightHandSide, residual;
+  };
+
+  std::vector<Level> levels;
+  double tolerance = DEFAULT_TOLERANCE;
+  int maximumNumberOfCycles = DEFAULT_MAXIMUM_NUMBER_OF_CYCLES;
+
+  void vCycle(int levelIndex, const SolutionGrid &rightHandSide,
+              SolutionGrid *solution);
+
+  /**
+   * @brief Red-black Gauss-Seidel sweeps on a level
+   *
+   */
+  void smooth(const Level &level, const SolutionGrid &rightHandSide,
+              SolutionGrid *solution, int numberOfSweeps) const;
+
+  /**
+   * @brief Gauss-Seidel sweeps on the coarsest level, until its residual is
+   * reduced enough
+   *
+   */
+  void solveCoarsest(Level &level, const SolutionGrid &rightHandSide,
+                     SolutionGrid *solution) const;
+
+  /**
+   * @brief residual = f - A u inside the box of a level
+   *
+   */
+  void computeResidual(const Level &level, const SolutionGrid &rightHandSide,
+                         const SolutionGrid &solution,
+                         SolutionGrid *residual) const;
+
+  /**
+   * @brief Right hand side of the next level : full weighting of the
+   * residual of a level
+   *
+   */
+  void restrictResidual(const Level &level, Level *coarse) const;
+
+  /**
+   * @brief Add the correction of the next level, interpolated linearly, to
+   * the solution of a level
+   *
+   */
+  void addCorrection(const Level &level, const Level &coarse,
+                     SolutionGrid *solution) const;
+};
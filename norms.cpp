@@ -0,0 +1,438 @@
+#include "norms.h"
+#include "simd_dispatch.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// The vectorized kernels add each value to the same lane, with the same
+// operations, as the scalar one and no fused multiply-add is used : all the
+// versions give bit-identical sums.
+
+namespace norms {
+
+namespace {
+
+/**
+ * @brief Number of chunks handled by one iteration of a parallelFor
+ *
+ */
+const int CHUNKS_PER_TASK = 16;
+
+/**
+ * @brief Number of values summed pairwise without splitting them
+ *
+ */
+const std::size_t PAIRWISE_BLOCK_SIZE = 4;
+
+/**
+ * @brief Weight of the values of the norms without weights
+ *
+ */
+const double UNIT_WEIGHT = 1;
+
+/**
+ * @brief Values summed together : value k is values[k * stride], weighted by
+ * weights[k * weightStride]
+ *
+ */
+struct Chunk {
+  const double *values;
+  std::ptrdiff_t stride;
+  const double *weights;
+  std::ptrdiff_t weightStride;
+  int numberOfValues;
+};
+
+/**
+ * @brief Segments of a view (its rows, or its column if it has only one),
+ * each cut into chunksPerSegment chunks of at most CHUNK_SIZE values
+ *
+ */
+struct Segments {
+  /**
+   * @brief The whole first segment
+   *
+   */
+  Chunk first;
+  int numberOfSegments;
+  std::ptrdiff_t segmentStride;
+  int chunksPerSegment;
+
+  int numberOfChunks() const { return numberOfSegments * chunksPerSegment; }
+
+  /**
+   * @brief Get chunk c, counted segment by segment
+   *
+   */
+  Chunk chunk(int c) const {
+    int segment = c / chunksPerSegment;
+    int firstValue = (c % chunksPerSegment) * CHUNK_SIZE;
+    Chunk chunk = {
+        first.values + segment * segmentStride + firstValue * first.stride,
+        first.stride, first.weights + firstValue * first.weightStride,
+        first.weightStride,
+        std::min(CHUNK_SIZE, first.numberOfValues - firstValue)};
+    return chunk;
+  }
+};
+
+Segments splitIntoSegments(const SolutionView &matrix,
+                           const double *columnWeights) {
+  Segments segments;
+  const double *weights = columnWeights ? columnWeights : &UNIT_WEIGHT;
+  if (matrix.numberOfRows <= 0 || matrix.numberOfColumns <= 0) {
+    segments.first = {matrix.data, 1, weights, 0, 0};
+    segments.numberOfSegments = 0;
+    segments.segmentStride = 0;
+  } else if (matrix.numberOfColumns == 1) {
+    segments.first = {matrix.data, matrix.rowStride, weights, 0,
+                      matrix.numberOfRows};
+    segments.numberOfSegments = 1;
+    segments.segmentStride = 0;
+  } else {
+    segments.first = {matrix.data, matrix.columnStride, weights,
+                      columnWeights ? 1 : 0, matrix.numberOfColumns};
+    segments.numberOfSegments = matrix.numberOfRows;
+    segments.segmentStride = matrix.rowStride;
+  }
+  segments.chunksPerSegment =
+      (segments.first.numberOfValues + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  return segments;
+}
+
+/**
+ * @brief Whether the chunks of a view are shared with the threads of
+ * ThreadPool::shared()
+ *
+ */
+bool isParallel(const SolutionView &matrix) {
+  return (long)matrix.numberOfRows * matrix.numberOfColumns >=
+         PARALLEL_THRESHOLD;
+}
+
+/**
+ * @brief Call computeChunk(c, chunk c) for each chunk of the segments, on the
+ * threads of ThreadPool::shared() when the view is large
+ *
+ */
+template <class ComputeChunk>
+void forEachChunk(const SolutionView &matrix, const Segments &segments,
+                  ComputeChunk computeChunk) {
+  int numberOfChunks = segments.numberOfChunks();
+  if (!isParallel(matrix)) {
+    for (int c = 0; c < numberOfChunks; c++) {
+      computeChunk(c, segments.chunk(c));
+    }
+    return;
+  }
+  int numberOfTasks = (numberOfChunks + CHUNKS_PER_TASK - 1) / CHUNKS_PER_TASK;
+  ThreadPool::shared().parallelFor(0, numberOfTasks, [&](int task) {
+    int last = std::min(numberOfChunks, (task + 1) * CHUNKS_PER_TASK);
+    for (int c = task * CHUNKS_PER_TASK; c < last; c++) {
+      computeChunk(c, segments.chunk(c));
+    }
+  });
+}
+
+/*=========== SUMS ===============*/
+
+template <Sum S> inline double term(double value, double weight) {
+  return (S == ABSOLUTE_VALUES) ? fabs(value) * weight
+                                : value * value * weight;
+}
+
+/**
+ * @brief Add value to sum with Kahan's compensated summation. Once the sum
+ * overflows, the compensation is reset instead of becoming inf - inf = NaN,
+ * so that the sum stays infinite.
+ *
+ */
+inline void kahanAdd(double value, double *sum, double *compensation) {
+  double corrected = value - *compensation;
+  double newSum = *sum + corrected;
+  *compensation = std::isfinite(newSum) ? (newSum - *sum) - corrected : 0;
+  *sum = newSum;
+}
+
+/**
+ * @brief Number of lanes on which the values of a chunk are summed
+ *
+ */
+const int NUMBER_OF_LANES = 8;
+
+/**
+ * @brief Add the values [first, numberOfValues) of a chunk to the lanes
+ *
+ */
+template <Sum S>
+void sumScalar(const Chunk &chunk, int first, double *sums,
+               double *compensations) {
+  for (int k = first; k < chunk.numberOfValues; k++) {
+    kahanAdd(term<S>(chunk.values[k * chunk.stride],
+                     chunk.weights[k * chunk.weightStride]),
+             &sums[k % NUMBER_OF_LANES], &compensations[k % NUMBER_OF_LANES]);
+  }
+}
+
+#ifdef HEAT_SIMD_X86
+template <Sum S>
+__attribute__((target("sse2"))) inline __m128d termSSE2(__m128d values,
+                                                        __m128d weights) {
+  if (S == ABSOLUTE_VALUES) {
+    return _mm_mul_pd(_mm_andnot_pd(_mm_set1_pd(-0.), values), weights);
+  }
+  return _mm_mul_pd(_mm_mul_pd(values, values), weights);
+}
+
+__attribute__((target("sse2"))) inline void
+kahanAddSSE2(__m128d values, __m128d *sum, __m128d *compensation) {
+  __m128d corrected = _mm_sub_pd(values, *compensation);
+  __m128d newSum = _mm_add_pd(*sum, corrected);
+  // newSum - newSum is NaN, which is not ordered, when newSum is not finite
+  __m128d finite = _mm_cmpord_pd(_mm_sub_pd(newSum, newSum), newSum);
+  *compensation =
+      _mm_and_pd(_mm_sub_pd(_mm_sub_pd(newSum, *sum), corrected), finite);
+  *sum = newSum;
+}
+
+template <Sum S>
+__attribute__((target("sse2"))) void
+sumSSE2(const Chunk &chunk, double *sums, double *compensations) {
+  __m128d sum[4], compensation[4], weights[4];
+  for (int l = 0; l < 4; l++) {
+    sum[l] = _mm_setzero_pd();
+    compensation[l] = _mm_setzero_pd();
+    weights[l] = _mm_set1_pd(chunk.weights[0]);
+  }
+  int k = 0;
+  for (; k + NUMBER_OF_LANES <= chunk.numberOfValues; k += NUMBER_OF_LANES) {
+    for (int l = 0; l < 4; l++) {
+      if (chunk.weightStride != 0) {
+        weights[l] = _mm_loadu_pd(chunk.weights + k + 2 * l);
+      }
+      kahanAddSSE2(termSSE2<S>(_mm_loadu_pd(chunk.values + k + 2 * l),
+                               weights[l]),
+                   &sum[l], &compensation[l]);
+    }
+  }
+  for (int l = 0; l < 4; l++) {
+    _mm_storeu_pd(sums + 2 * l, sum[l]);
+    _mm_storeu_pd(compensations + 2 * l, compensation[l]);
+  }
+  sumScalar<S>(chunk, k, sums, compensations);
+}
+
+template <Sum S>
+__attribute__((target("avx2"))) inline __m256d termAVX2(__m256d values,
+                                                        __m256d weights) {
+  if (S == ABSOLUTE_VALUES) {
+    return _mm256_mul_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.), values),
+                         weights);
+  }
+  return _mm256_mul_pd(_mm256_mul_pd(values, values), weights);
+}
+
+__attribute__((target("avx2"))) inline void
+kahanAddAVX2(__m256d values, __m256d *sum, __m256d *compensation) {
+  __m256d corrected = _mm256_sub_pd(values, *compensation);
+  __m256d newSum = _mm256_add_pd(*sum, corrected);
+  // newSum - newSum is NaN, which is not ordered, when newSum is not finite
+  __m256d finite = _mm256_cmp_pd(_mm256_sub_pd(newSum, newSum), newSum,
+                                 _CMP_ORD_Q);
+  *compensation = _mm256_and_pd(
+      _mm256_sub_pd(_mm256_sub_pd(newSum, *sum), corrected), finite);
+  *sum = newSum;
+}
+
+template <Sum S>
+__attribute__((target("avx2"))) void
+sumAVX2(const Chunk &chunk, double *sums, double *compensations) {
+  __m256d sumLow = _mm256_setzero_pd(), sumHigh = _mm256_setzero_pd();
+  __m256d compensationLow = _mm256_setzero_pd(),
+          compensationHigh = _mm256_setzero_pd();
+  __m256d weightLow = _mm256_set1_pd(chunk.weights[0]), weightHigh = weightLow;
+  int k = 0;
+  for (; k + NUMBER_OF_LANES <= chunk.numberOfValues; k += NUMBER_OF_LANES) {
+    if (chunk.weightStride != 0) {
+      weightLow = _mm256_loadu_pd(chunk.weights + k);
+      weightHigh = _mm256_loadu_pd(chunk.weights + k + 4);
+    }
+    kahanAddAVX2(termAVX2<S>(_mm256_loadu_pd(chunk.values + k), weightLow),
+                 &sumLow, &compensationLow);
+    kahanAddAVX2(termAVX2<S>(_mm256_loadu_pd(chunk.values + k + 4),
+                             weightHigh),
+                 &sumHigh, &compensationHigh);
+  }
+  _mm256_storeu_pd(sums, sumLow);
+  _mm256_storeu_pd(sums + 4, sumHigh);
+  _mm256_storeu_pd(compensations, compensationLow);
+  _mm256_storeu_pd(compensations + 4, compensationHigh);
+  sumScalar<S>(chunk, k, sums, compensations);
+}
+#endif
+
+template <Sum S> double chunkSum(const Chunk &chunk) {
+  double sums[NUMBER_OF_LANES] = {0, 0, 0, 0, 0, 0, 0, 0};
+  double compensations[NUMBER_OF_LANES] = {0, 0, 0, 0, 0, 0, 0, 0};
+  bool contiguous = chunk.stride == 1;
+  switch (contiguous ? simd::activeInstructionSet() : simd::SCALAR) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    sumAVX2<S>(chunk, sums, compensations);
+    break;
+  case simd::SSE2:
+    sumSSE2<S>(chunk, sums, compensations);
+    break;
+#endif
+  default:
+    sumScalar<S>(chunk, 0, sums, compensations);
+  }
+  double lanes[NUMBER_OF_LANES];
+  for (int l = 0; l < NUMBER_OF_LANES; l++) {
+    lanes[l] = sums[l] - compensations[l];
+  }
+  return pairwiseSum(lanes, NUMBER_OF_LANES);
+}
+
+/*=========== MAXIMUM ===============*/
+
+double maximumScalar(const Chunk &chunk, int first, double maximum) {
+  for (int k = first; k < chunk.numberOfValues; k++) {
+    double value = fabs(chunk.values[k * chunk.stride]);
+    if (maximum <= value) {
+      maximum = value;
+    }
+  }
+  return maximum;
+}
+
+#ifdef HEAT_SIMD_X86
+__attribute__((target("avx2"))) double maximumAVX2(const Chunk &chunk) {
+  const __m256d signBit = _mm256_set1_pd(-0.);
+  __m256d maximum = _mm256_setzero_pd();
+  int k = 0;
+  for (; k + 4 <= chunk.numberOfValues; k += 4) {
+    // A NaN value is ignored, as in the scalar version
+    maximum = _mm256_max_pd(
+        _mm256_andnot_pd(signBit, _mm256_loadu_pd(chunk.values + k)), maximum);
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, maximum);
+  double result = std::max(std::max(lanes[0], lanes[1]),
+                           std::max(lanes[2], lanes[3]));
+  return maximumScalar(chunk, k, result);
+}
+#endif
+
+double chunkMaximum(const Chunk &chunk) {
+#ifdef HEAT_SIMD_X86
+  if (chunk.stride == 1 && simd::activeInstructionSet() == simd::AVX2) {
+    return maximumAVX2(chunk);
+  }
+#endif
+  return maximumScalar(chunk, 0, 0);
+}
+
+/**
+ * @brief Number of chunk sums of a view kept on the stack by viewSum
+ *
+ */
+const int LOCAL_CHUNK_SUMS = 64;
+
+/**
+ * @brief Store the sums of the chunks of a view in sums
+ *
+ */
+void computeChunkSums(const SolutionView &matrix, const Segments &segments,
+                      Sum sum, double *sums) {
+  forEachChunk(matrix, segments, [&](int c, const Chunk &chunk) {
+    sums[c] = (sum == ABSOLUTE_VALUES) ? chunkSum<ABSOLUTE_VALUES>(chunk)
+                                       : chunkSum<SQUARES>(chunk);
+  });
+}
+
+/**
+ * @brief Pairwise sum of the chunk sums of a view
+ *
+ */
+double viewSum(const SolutionView &matrix, Sum sum,
+               const double *columnWeights) {
+  Segments segments = splitIntoSegments(matrix, columnWeights);
+  int numberOfChunks = segments.numberOfChunks();
+  if (numberOfChunks <= LOCAL_CHUNK_SUMS) {
+    double sums[LOCAL_CHUNK_SUMS];
+    computeChunkSums(matrix, segments, sum, sums);
+    return pairwiseSum(sums, numberOfChunks);
+  }
+  std::vector<double> sums(numberOfChunks);
+  computeChunkSums(matrix, segments, sum, sums.data());
+  return pairwiseSum(sums.data(), numberOfChunks);
+}
+
+} // namespace
+
+void appendChunkSums(const SolutionView &matrix, Sum sum,
+                     const double *columnWeights,
+                     std::vector<double> *chunkSums) {
+  Segments segments = splitIntoSegments(matrix, columnWeights);
+  std::size_t first = (*chunkSums).size();
+  (*chunkSums).resize(first + segments.numberOfChunks());
+  computeChunkSums(matrix, segments, sum, (*chunkSums).data() + first);
+}
+
+double pairwiseSum(const double *values, std::size_t numberOfValues) {
+  if (numberOfValues <= PAIRWISE_BLOCK_SIZE) {
+    double sum = 0;
+    for (std::size_t k = 0; k < numberOfValues; k++) {
+      sum += values[k];
+    }
+    return sum;
+  }
+  std::size_t half = numberOfValues / 2;
+  return pairwiseSum(values, half) +
+         pairwiseSum(values + half, numberOfValues - half);
+}
+
+double oneNorm(const SolutionView &matrix) {
+  return viewSum(matrix, ABSOLUTE_VALUES, nullptr);
+}
+
+double twoNorm(const SolutionView &matrix) {
+  return sqrt(viewSum(matrix, SQUARES, nullptr));
+}
+
+double uniformNorm(const SolutionView &matrix) {
+  Segments segments = splitIntoSegments(matrix, nullptr);
+  double maximum = 0;
+  if (!isParallel(matrix)) {
+    for (int c = 0; c < segments.numberOfChunks(); c++) {
+      maximum = std::max(maximum, chunkMaximum(segments.chunk(c)));
+    }
+    return maximum;
+  }
+  std::vector<double> maxima(segments.numberOfChunks());
+  forEachChunk(matrix, segments, [&](int c, const Chunk &chunk) {
+    maxima[c] = chunkMaximum(chunk);
+  });
+  for (double chunkMaximum : maxima) {
+    maximum = std::max(maximum, chunkMaximum);
+  }
+  return maximum;
+}
+
+double weightedOneNorm(const SolutionView &matrix,
+                       const double *columnWeights) {
+  return viewSum(matrix, ABSOLUTE_VALUES, columnWeights);
+}
+
+double weightedTwoNorm(const SolutionView &matrix,
+                       const double *columnWeights) {
+  return sqrt(viewSum(matrix, SQUARES, columnWeights));
+}
+
+} // namespace norms
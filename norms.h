@@ -0,0 +1,101 @@
+#pragma once // Include guard
+#include "solution_grid.h"
+#include <vector>
+
+/**
+ * @brief Norms of any view on a solution : a whole grid, a row, a column or a
+ * sub-block (see SolutionGrid::rowView, columnView and blockView)
+ *
+ * The values are read segment by segment : the rows of the view, or its only
+ * column when it has a single one. Each segment is cut into chunks of
+ * CHUNK_SIZE values. A chunk is summed on 8 lanes (value k of the chunk goes
+ * to lane k % 8) with Kahan compensation on each lane, then the lanes and
+ * the sums of the chunks are added pairwise. This order only depends on the
+ * view : the result is the same whatever the instruction set (see
+ * simd_dispatch.h) and the number of threads of ThreadPool::shared(), which
+ * share the chunks of large views.
+ *
+ * Weighted norms take one weight per column of the view (for example the
+ * width of the cell of each point), applied as weight * |x| or weight * x^2.
+ * All the norms of an empty view are 0.
+ */
+namespace norms {
+
+/**
+ * @brief Number of values of a chunk
+ *
+ */
+const int CHUNK_SIZE = 1024;
+
+/**
+ * @brief Number of values of a view above which its chunks are shared with
+ * the threads of ThreadPool::shared()
+ *
+ */
+const long PARALLEL_THRESHOLD = 1 << 17;
+
+/**
+ * @brief Quantity summed over the values of a view
+ *
+ */
+enum Sum { ABSOLUTE_VALUES, SQUARES };
+
+/**
+ * @brief One norm : sum of |x|
+ *
+ */
+double oneNorm(const SolutionView &matrix);
+
+/**
+ * @brief Two norm / Euclidian norm : square root of the sum of x^2
+ *
+ */
+double twoNorm(const SolutionView &matrix);
+
+/**
+ * @brief Uniform norm (maximum / infinity norm) : maximum of |x|
+ *
+ */
+double uniformNorm(const SolutionView &matrix);
+
+/**
+ * @brief Weighted one norm : sum of weight(j) * |x(i, j)|
+ *
+ * @param matrix : view on the values
+ * @param columnWeights : one weight per column of the view
+ */
+double weightedOneNorm(const SolutionView &matrix,
+                       const double *columnWeights);
+
+/**
+ * @brief Weighted two norm : square root of the sum of weight(j) * x(i, j)^2
+ *
+ * @param matrix : view on the values
+ * @param columnWeights : one weight per column of the view
+ */
+double weightedTwoNorm(const SolutionView &matrix,
+                       const double *columnWeights);
+
+/**
+ * @brief Append the sums of each chunk of a view to chunkSums, in order. The
+ * norms of a view are pairwiseSum of its chunk sums : a norm over several
+ * views (for example the rows of a solution computed one at a time) is
+ * obtained by appending their chunk sums to the same vector.
+ *
+ * @param matrix : view on the values
+ * @param sum : quantity summed
+ * @param columnWeights : one weight per column of the view, or nullptr
+ * @param chunkSums : where the sums are appended
+ */
+void appendChunkSums(const SolutionView &matrix, Sum sum,
+                     const double *columnWeights,
+                     std::vector<double> *chunkSums);
+
+/**
+ * @brief Sum of values added pairwise : the two halves are summed
+ * recursively, then added
+ *
+ */
+double pairwiseSum(const double *values, std::size_t numberOfValues);
+
+} // namespace norms
@@ -0,0 +1,141 @@
+#include "parallel_tridiagonal_solver.h"
+#include "solver_engine.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Partitions smaller than this are not worth the synchronisation
+ *
+ */
+const int MINIMUM_PARTITION_SIZE = 1024;
+} // namespace
+
+ParallelTridiagonalSolver::ParallelTridiagonalSolver(ThreadPool *ppool)
+    : pool(ppool), size(0){};
+
+int ParallelTridiagonalSolver::getNumberOfPartitions() const {
+  return (partitionStart.empty() ? 0 : partitionStart.size() - 1);
+};
+
+void ParallelTridiagonalSolver::factorize(int psize,
+                                          const double *lowerDiagonal,
+                                          const double *mainDiagonal,
+                                          const double *upperDiagonal,
+                                          int numberOfPartitions) {
+  if (psize < 1) {
+    throw(std::invalid_argument("the system should have at least one unknown"));
+  }
+  size = psize;
+  if (numberOfPartitions <= 0) {
+    numberOfPartitions = 2 * (*pool).getNumberOfThreads();
+  }
+  numberOfPartitions =
+      std::max(1, std::min(numberOfPartitions, size / MINIMUM_PARTITION_SIZE));
+
+  // Partition k covers [partitionStart[k], partitionStart[k+1] - 2], the
+  // point partitionStart[k+1] - 1 being the separator after it
+  partitionStart.resize(numberOfPartitions + 1);
+  for (int k = 0; k <= numberOfPartitions; k++) {
+    partitionStart[k] = (int)((long long)k * (size + 1) / numberOfPartitions);
+  }
+
+  lower.assign(lowerDiagonal, lowerDiagonal + size);
+  upper.assign(upperDiagonal, upperDiagonal + size);
+  pivots.resize(size);
+  modifiedUpperDiagonal.resize(size);
+  leftSpike.assign(size, 0.);
+  rightSpike.assign(size, 0.);
+  std::vector<double> spikeB(size);
+
+  // Factorization of each partition on its own and computation of its spikes
+  (*pool).parallelFor(0, numberOfPartitions, [&](int k) {
+    int first = partitionStart[k];
+    int length = partitionStart[k + 1] - 1 - first;
+    factorizeTridiagonal(length, lowerDiagonal + first, mainDiagonal + first,
+                         upperDiagonal + first, &pivots[first],
+                         &modifiedUpperDiagonal[first]);
+    if (k > 0) {
+      std::fill(&spikeB[first], &spikeB[first] + length, 0.);
+      spikeB[first] = -lowerDiagonal[first];
+      solveFactorizedTridiagonal(length, lowerDiagonal + first, &pivots[first],
+                                 &modifiedUpperDiagonal[first], &spikeB[first],
+                                 &leftSpike[first]);
+    }
+    if (k < numberOfPartitions - 1) {
+      int last = first + length - 1;
+      std::fill(&spikeB[first], &spikeB[first] + length, 0.);
+      spikeB[last] = -upperDiagonal[last];
+      solveFactorizedTridiagonal(length, lowerDiagonal + first, &pivots[first],
+                                 &modifiedUpperDiagonal[first], &spikeB[first],
+                                 &rightSpike[first]);
+    }
+  });
+
+  // System of the separators :
+  // a V(p-1) X(previous separator) + (b + a W(p-1) + c V(p+1)) X(p)
+  //   + c W(p+1) X(next separator) = B(p) - a Y(p-1) - c Y(p+1)
+  int numberOfSeparators = numberOfPartitions - 1;
+  separatorLower.resize(numberOfSeparators);
+  separatorPivots.resize(numberOfSeparators);
+  separatorModifiedUpper.resize(numberOfSeparators);
+  separatorB.resize(numberOfSeparators);
+  separatorX.resize(numberOfSeparators);
+  if (numberOfSeparators > 0) {
+    std::vector<double> separatorMain(numberOfSeparators),
+        separatorUpper(numberOfSeparators);
+    for (int k = 0; k < numberOfSeparators; k++) {
+      int p = partitionStart[k + 1] - 1;
+      double a = lowerDiagonal[p];
+      double c = upperDiagonal[p];
+      separatorLower[k] = a * leftSpike[p - 1];
+      separatorMain[k] =
+          mainDiagonal[p] + a * rightSpike[p - 1] + c * leftSpike[p + 1];
+      separatorUpper[k] = c * rightSpike[p + 1];
+    }
+    factorizeTridiagonal(numberOfSeparators, separatorLower.data(),
+                         separatorMain.data(), separatorUpper.data(),
+                         separatorPivots.data(),
+                         separatorModifiedUpper.data());
+  }
+}
+
+void ParallelTridiagonalSolver::solve(double *B, double *X) {
+  int numberOfPartitions = getNumberOfPartitions();
+
+  // Y : each partition solved on its own, stored in X
+  (*pool).parallelFor(0, numberOfPartitions, [&](int k) {
+    int first = partitionStart[k];
+    int length = partitionStart[k + 1] - 1 - first;
+    solveFactorizedTridiagonal(length, &lower[first], &pivots[first],
+                               &modifiedUpperDiagonal[first], B + first,
+                               X + first);
+  });
+
+  // Separators, solved sequentially and stored in X
+  int numberOfSeparators = numberOfPartitions - 1;
+  if (numberOfSeparators > 0) {
+    for (int k = 0; k < numberOfSeparators; k++) {
+      int p = partitionStart[k + 1] - 1;
+      separatorB[k] = B[p] - lower[p] * X[p - 1] - upper[p] * X[p + 1];
+    }
+    solveFactorizedTridiagonal(numberOfSeparators, separatorLower.data(),
+                               separatorPivots.data(),
+                               separatorModifiedUpper.data(),
+                               separatorB.data(), separatorX.data());
+    for (int k = 0; k < numberOfSeparators; k++) {
+      X[partitionStart[k + 1] - 1] = separatorX[k];
+    }
+  }
+
+  // X = Y + V X(left separator) + W X(right separator)
+  (*pool).parallelFor(0, numberOfPartitions, [&](int k) {
+    int first = partitionStart[k];
+    int end = partitionStart[k + 1] - 1;
+    double leftSeparator = (k > 0) ? X[first - 1] : 0;
+    double rightSeparator = (k < numberOfPartitions - 1) ? X[end] : 0;
+    for (int i = first; i < end; i++) {
+      X[i] += leftSpike[i] * leftSeparator + rightSpike[i] * rightSeparator;
+    }
+  });
+}
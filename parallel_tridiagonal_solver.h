@@ -0,0 +1,83 @@
+#pragma once // Include guard
+#include "thread_pool.h"
+#include <vector>
+
+/**
+ * @brief Solver of a tridiagonal linear system AX=B spreading the work of one
+ * system over the threads of a ThreadPool (partition method)
+ *
+ * The unknowns are split into partitions separated by single separator
+ * points. Inside partition k, once the separators are known :
+ * X(i) = Y(i) + V(i) X(left separator) + W(i) X(right separator)
+ * where Y solves the partition with its own right hand side and V and W (the
+ * spikes) only depend on A. The separators are given by a small tridiagonal
+ * system solved sequentially. The factorization of A and the spikes are
+ * computed once by factorize() and reused by every call to solve().
+ *
+ * The results match the sequential Thomas algorithm up to rounding.
+ */
+class ParallelTridiagonalSolver {
+public:
+  /**
+   * @brief Construct a new Parallel Tridiagonal Solver using a given pool
+   *
+   * @param pool : threads used to solve the partitions
+   */
+  explicit ParallelTridiagonalSolver(ThreadPool *pool = &ThreadPool::shared());
+
+  /**
+   * @brief Factorize A and compute the spikes of each partition
+   *
+   * @param size : number of unknowns
+   * @param lowerDiagonal : A[i][i-1], the first value is ignored
+   * @param mainDiagonal : A[i][i]
+   * @param upperDiagonal : A[i][i+1], the last value is ignored
+   * @param numberOfPartitions : number of partitions, 0 means two per thread
+   * of the pool. It is reduced if the partitions would be too small.
+   */
+  void factorize(int size, const double *lowerDiagonal,
+                 const double *mainDiagonal, const double *upperDiagonal,
+                 int numberOfPartitions = 0);
+
+  /**
+   * @brief Solve AX=B with the last factorized A
+   *
+   * @param B : right hand side, it is overwritten
+   * @param X : where to store the solution
+   */
+  void solve(double *B, double *X);
+
+  /**
+   * @brief Get the number of partitions of the last factorization
+   *
+   */
+  int getNumberOfPartitions() const;
+
+private:
+  ThreadPool *pool;
+  int size;
+  /**
+   * @brief first point of each partition, the separator before partition k
+   * (k > 0) is partitionStart[k] - 1. partitionStart[numberOfPartitions] is
+   * size + 1 so that partition k ends at partitionStart[k+1] - 2.
+   *
+   */
+  std::vector<int> partitionStart;
+  std::vector<double> lower, upper;
+  /**
+   * @brief factorization of the partitions (at the partition indices)
+   *
+   */
+  std::vector<double> pivots, modifiedUpperDiagonal;
+  /**
+   * @brief spikes : coefficients of the left and right separators
+   *
+   */
+  std::vector<double> leftSpike, rightSpike;
+  /**
+   * @brief factorization of the system of the separators
+   *
+   */
+  std::vector<double> separatorLower, separatorPivots,
+      separatorModifiedUpper, separatorB, separatorX;
+};
@@ -0,0 +1,194 @@
+#include "result_cache.h"
+#include "instrumentation.h"
+#include "result_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const char FILE_EXTENSION[] = ".bin";
+
+/**
+ * @brief Exact text of a double (hexadecimal floating point), so that two
+ * doubles give the same text only if they are equal
+ */
+std::string exactText(double value) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%a", value);
+  return text;
+}
+
+bool endsWith(const std::string &text, const std::string &suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+ResultCache::ResultCache(const std::string &pdirectory,
+                         std::uint64_t pmaximumSize)
+    : directory(pdirectory), maximumSize(pmaximumSize) {
+  if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw(std::runtime_error("cannot create the directory " + directory));
+  }
+};
+
+std::string ResultCache::keyOf(const AbstractSolver &solver,
+                               const HeatDiffusionParameters &parameters,
+                               double deltaX, double deltaT) {
+  return "version " + std::to_string(CODE_VERSION) + "\n" +
+         solver.getConfigurationName() + "\n" +
+         exactText(parameters.getDiffusivity()) + " " +
+         exactText(parameters.getSurfaceTemperature()) + " " +
+         exactText(parameters.getInternalTemperature()) + " " +
+         exactText(parameters.getWidth()) + " " +
+         exactText(parameters.getTimeStop()) + " " + exactText(deltaX) + " " +
+         exactText(deltaT);
+}
+
+std::uint64_t ResultCache::hash(const std::string &key) {
+  std::uint64_t hashValue = 14695981039346656037ull;
+  for (unsigned char character : key) {
+    hashValue ^= character;
+    hashValue *= 1099511628211ull;
+  }
+  return hashValue;
+}
+
+std::string ResultCache::pathOf(const std::string &key) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                (unsigned long long)hash(key));
+  return directory + "/" + name + FILE_EXTENSION;
+}
+
+bool ResultCache::load(const std::string &key, double deltaX, double deltaT,
+                       SolutionGrid *solution) {
+  HEAT_TIMED_SCOPE("result_cache.load");
+  std::string path = pathOf(key);
+  bool found = false;
+  if (access(path.c_str(), R_OK) == 0) {
+    try {
+      ResultFile file(path);
+      // A file of another key can only come from a collision of the hashes
+      if (file.getKey() == key && file.getHeader().deltaX == deltaX &&
+          file.getHeader().deltaT == deltaT) {
+        SolutionView stored = file.getSolution();
+        (*solution).resize(stored.numberOfRows, stored.numberOfColumns);
+        for (int i = 0; i < stored.numberOfRows; i++) {
+          std::memcpy((*solution).row(i), stored.data + i * stored.rowStride,
+                      stored.numberOfColumns * sizeof(double));
+        }
+        found = true;
+      }
+    } catch (const std::exception &) {
+      // A file being removed or not a valid result file : solved again
+    }
+  }
+  if (found) {
+    // The modification time tells the least recently used files
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  if (found) {
+    numberOfHits++;
+    HEAT_COUNT("result_cache.hits", 1);
+  } else {
+    numberOfMisses++;
+    HEAT_COUNT("result_cache.misses", 1);
+  }
+  return found;
+}
+
+void ResultCache::store(const std::string &key, const std::string &schemeName,
+                        const SolutionGrid &solution, double deltaX,
+                        double deltaT) {
+  HEAT_TIMED_SCOPE("result_cache.store");
+  std::string path = pathOf(key);
+  long long storeNumber;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    storeNumber = numberOfStores++;
+  }
+  // Readers never see a partially written file
+  std::string temporaryPath = path + "." + std::to_string(getpid()) + "." +
+                              std::to_string(storeNumber) + ".tmp";
+  bool stored = false;
+  try {
+    writeResultFile(temporaryPath, schemeName, solution, nullptr, deltaX,
+                    deltaT, key);
+    stored = std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+  } catch (const std::exception &) {
+    // Full disk, read-only directory... : the solution is only not cached
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!stored) {
+    std::remove(temporaryPath.c_str());
+    numberOfFailedStores++;
+    HEAT_COUNT("result_cache.failed_stores", 1);
+    return;
+  }
+  evict(path);
+}
+
+void ResultCache::evict(const std::string &keptPath) {
+  DIR *directoryStream = opendir(directory.c_str());
+  if (!directoryStream) {
+    return;
+  }
+  // (modification time, path, size) of each file of the cache
+  std::vector<std::pair<std::pair<long long, std::string>, std::uint64_t>>
+      files;
+  std::uint64_t totalSize = 0;
+  while (struct dirent *entry = readdir(directoryStream)) {
+    std::string name = (*entry).d_name;
+    if (!endsWith(name, FILE_EXTENSION)) {
+      continue;
+    }
+    std::string path = directory + "/" + name;
+    struct stat fileStatus;
+    if (stat(path.c_str(), &fileStatus) != 0) {
+      continue;
+    }
+    long long modificationTime =
+        (long long)fileStatus.st_mtim.tv_sec * 1000000000 +
+        fileStatus.st_mtim.tv_nsec;
+    files.push_back(std::make_pair(std::make_pair(modificationTime, path),
+                                   (std::uint64_t)fileStatus.st_size));
+    totalSize += fileStatus.st_size;
+  }
+  closedir(directoryStream);
+
+  std::sort(files.begin(), files.end());
+  for (std::size_t i = 0; i < files.size() && totalSize > maximumSize; i++) {
+    const std::string &path = files[i].first.second;
+    if (path != keptPath && std::remove(path.c_str()) == 0) {
+      totalSize -= files[i].second;
+      HEAT_COUNT("result_cache.evictions", 1);
+    }
+  }
+}
+
+long long ResultCache::getNumberOfHits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfHits;
+}
+
+long long ResultCache::getNumberOfMisses() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfMisses;
+}
+
+long long ResultCache::getNumberOfFailedStores() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfFailedStores;
+}
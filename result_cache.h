@@ -0,0 +1,145 @@
+#pragma once // Include guard
+#include "abstract_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "solution_grid.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Solutions kept on disk between runs, as binary result files (see
+ * result_file.h)
+ *
+ * A solution is identified by a key made of everything it depends on : the
+ * configuration of the solver (scheme and settings changing the results, see
+ * AbstractSolver::getConfigurationName), the parameters of the problem,
+ * deltaX, deltaT and CODE_VERSION. It is stored in the directory of the cache
+ * in a file named after the 64 bits FNV-1a hash of the key, with the key
+ * itself after the header of the file. Loading a solution maps the file,
+ * checks its key and copies the solution, without solving anything.
+ *
+ * The files are bounded to maximumSize bytes : after each store, the least
+ * recently used files (by their modification time, updated on each load) are
+ * removed until the total size fits. Files are written under a temporary name
+ * and renamed, so several threads or programms can share a directory. A file
+ * that cannot be written is only counted : the cache is never needed to
+ * solve.
+ */
+class ResultCache {
+public:
+  /**
+   * @brief Version of the solvers, part of every key. It should be increased
+   * whenever a change of the solvers changes their results, so that the
+   * solutions computed before are not used anymore.
+   *
+   */
+  static const std::uint32_t CODE_VERSION = 1;
+
+  /**
+   * @brief Default maximum size of the files of the cache : 1 GiB
+   *
+   */
+  static const std::uint64_t DEFAULT_MAXIMUM_SIZE = 1ull << 30;
+
+  /**
+   * @brief Open a cache in directory, creating the directory if needed
+   *
+   * Can throw a runtime_error exception if the directory cannot be created
+   *
+   * @param directory : directory of the files of the cache
+   * @param maximumSize : maximum total size of the files in bytes
+   */
+  explicit ResultCache(const std::string &directory,
+                       std::uint64_t maximumSize = DEFAULT_MAXIMUM_SIZE);
+
+  /**
+   * @brief Key of the solution of solver with the given problem and grid
+   *
+   * @param solver : solver of the solution, with its settings
+   * @param parameters : parameters of the problem
+   * @param deltaX : size of the space step
+   * @param deltaT : size of the time step
+   * @return std::string : the key, with the doubles written exactly
+   */
+  static std::string keyOf(const AbstractSolver &solver,
+                           const HeatDiffusionParameters &parameters,
+                           double deltaX, double deltaT);
+
+  /**
+   * @brief 64 bits FNV-1a hash of a key
+   *
+   */
+  static std::uint64_t hash(const std::string &key);
+
+  /**
+   * @brief Path of the file storing the solution of key
+   *
+   */
+  std::string pathOf(const std::string &key) const;
+
+  /**
+   * @brief Load the solution of key if it is in the cache. A file of another
+   * key with the same hash is not loaded.
+   *
+   * @param key : key of the solution (see keyOf)
+   * @param deltaX : size of the space step, checked against the file
+   * @param deltaT : size of the time step, checked against the file
+   * @param solution : grid where the solution is copied
+   * @return true if the solution has been found
+   */
+  bool load(const std::string &key, double deltaX, double deltaT,
+            SolutionGrid *solution);
+
+  /**
+   * @brief Store the solution of key, then remove the least recently used
+   * files if the cache is too large. If the file cannot be written (full
+   * disk, read-only directory...), nothing is stored and the failure is
+   * counted.
+   *
+   * @param key : key of the solution (see keyOf)
+   * @param schemeName : name of the scheme, stored in the header of the file
+   * @param solution : solution to store
+   * @param deltaX : size of the space step
+   * @param deltaT : size of the time step
+   */
+  void store(const std::string &key, const std::string &schemeName,
+             const SolutionGrid &solution, double deltaX, double deltaT);
+
+  /**
+   * @brief Number of solutions found and not found by load
+   *
+   */
+  long long getNumberOfHits() const;
+  long long getNumberOfMisses() const;
+
+  /**
+   * @brief Number of solutions that could not be stored
+   *
+   */
+  long long getNumberOfFailedStores() const;
+
+private:
+  std::string directory;
+  std::uint64_t maximumSize;
+
+  /**
+   * @brief Protects the counters, and the files during an eviction
+   *
+   */
+  mutable std::mutex mutex;
+  long long numberOfHits = 0;
+  long long numberOfMisses = 0;
+  /**
+   * @brief Number of files written, to give each temporary file its own name
+   *
+   */
+  long long numberOfStores = 0;
+  long long numberOfFailedStores = 0;
+
+  /**
+   * @brief Remove the least recently used files until the total size is at
+   * most maximumSize. The file at keptPath is never removed.
+   *
+   */
+  void evict(const std::string &keptPath);
+};
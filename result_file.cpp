@@ -0,0 +1,213 @@
+#include "result_file.h"
+#include "error_accumulator.h"
+#include "instrumentation.h"
+#include "result_output.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char MAGIC[8] = "HEATRES";
+const std::uint32_t VERSION = 1;
+/**
+ * @brief Alignment in bytes of the blocks in the file
+ *
+ */
+const std::uint64_t BLOCK_ALIGNMENT = 64;
+/**
+ * @brief Number of rows of errors computed before being written
+ *
+ */
+const std::size_t ERROR_BUFFER_SIZE = 1 << 20;
+
+std::uint64_t alignedOffset(std::uint64_t offset) {
+  return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+}
+
+void writeBytes(std::FILE *file, const void *data, std::size_t size,
+                const std::string &filename) {
+  if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+    std::fclose(file);
+    throw(std::runtime_error("cannot write " + filename));
+  }
+}
+
+} // namespace
+
+static_assert(sizeof(ResultFileHeader) == 256,
+              "the header should keep the same size");
+
+void writeResultFile(const std::string &filename, const std::string &schemeName,
+                     const SolutionGrid &numericalSolution,
+                     const SolutionGrid *analyticalSolution, double deltaX,
+                     double deltaT, const std::string &key) {
+  HEAT_TIMED_SCOPE("output.binary_file");
+  int numberOfRows = numericalSolution.getNumberOfRows();
+  int numberOfColumns = numericalSolution.getNumberOfColumns();
+  std::ptrdiff_t rowStride = numericalSolution.getRowStride();
+  if (analyticalSolution &&
+      ((*analyticalSolution).getNumberOfRows() != numberOfRows ||
+       (*analyticalSolution).getNumberOfColumns() != numberOfColumns)) {
+    throw(std::invalid_argument(
+        "the analytical solution should have the size of the numerical one"));
+  }
+
+  ResultFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  header.headerSize = sizeof(header);
+  header.numberOfRows = numberOfRows;
+  header.numberOfColumns = numberOfColumns;
+  header.rowStride = rowStride;
+  header.deltaX = deltaX;
+  header.deltaT = deltaT;
+  std::strncpy(header.schemeName, schemeName.c_str(),
+               sizeof(header.schemeName) - 1);
+  std::uint64_t blockSize =
+      (std::uint64_t)numberOfRows * rowStride * sizeof(double);
+  header.keyOffset = key.empty() ? 0 : sizeof(header);
+  header.keySize = key.size();
+  header.solutionOffset = alignedOffset(sizeof(header) + key.size());
+  header.errorsOffset =
+      analyticalSolution ? alignedOffset(header.solutionOffset + blockSize) : 0;
+
+  std::FILE *file = std::fopen(filename.c_str(), "wb");
+  if (!file) {
+    throw(std::runtime_error("cannot open " + filename));
+  }
+  // The norms are only known once the errors are written : the header is
+  // written again at the end
+  writeBytes(file, &header, sizeof(header), filename);
+  std::vector<char> keyBlock(header.solutionOffset - sizeof(header), 0);
+  std::copy(key.begin(), key.end(), keyBlock.begin());
+  writeBytes(file, keyBlock.data(), keyBlock.size(), filename);
+  // The rows of a SolutionGrid are contiguous, padding included : the whole
+  // solution is written at once
+  if (numberOfRows > 0) {
+    writeBytes(file, numericalSolution.row(0), blockSize, filename);
+  }
+
+  if (analyticalSolution) {
+    ErrorAccumulator errorNorms;
+    int rowsPerBuffer =
+        std::max(1, (int)(ERROR_BUFFER_SIZE / sizeof(double) / rowStride));
+    std::vector<double> buffer((std::size_t)rowsPerBuffer * rowStride, 0.);
+    for (int firstRow = 0; firstRow < numberOfRows; firstRow += rowsPerBuffer) {
+      int lastRow = std::min(numberOfRows, firstRow + rowsPerBuffer);
+      for (int i = firstRow; i < lastRow; i++) {
+        errorNorms.addRow(numericalSolution.row(i),
+                          (*analyticalSolution).row(i), numberOfColumns,
+                          buffer.data() + (i - firstRow) * rowStride);
+      }
+      writeBytes(file, buffer.data(),
+                 (std::size_t)(lastRow - firstRow) * rowStride * sizeof(double),
+                 filename);
+    }
+    header.uniformNorm = errorNorms.getUniformNorm();
+    header.twoNorm = errorNorms.getTwoNorm();
+    std::fseek(file, 0, SEEK_SET);
+    writeBytes(file, &header, sizeof(header), filename);
+  }
+  if (std::fclose(file) != 0) {
+    throw(std::runtime_error("cannot write " + filename));
+  }
+}
+
+ResultFile::ResultFile(const std::string &filename)
+    : header(nullptr), mapping(nullptr), mappingSize(0) {
+  int fileDescriptor = open(filename.c_str(), O_RDONLY);
+  if (fileDescriptor < 0) {
+    throw(std::runtime_error("cannot open " + filename));
+  }
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) != 0) {
+    close(fileDescriptor);
+    throw(std::runtime_error("cannot read " + filename));
+  }
+  mappingSize = fileStatus.st_size;
+  if (mappingSize < sizeof(ResultFileHeader)) {
+    close(fileDescriptor);
+    throw(std::invalid_argument(filename + " is not a result file"));
+  }
+  mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor,
+                 0);
+  close(fileDescriptor);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw(std::runtime_error("cannot map " + filename));
+  }
+  header = static_cast<const ResultFileHeader *>(mapping);
+
+  std::uint64_t blockSize = (std::uint64_t)(*header).numberOfRows *
+                            (*header).rowStride * sizeof(double);
+  bool valid =
+      std::memcmp((*header).magic, MAGIC, sizeof(MAGIC)) == 0 &&
+      (*header).version == VERSION &&
+      (*header).headerSize == sizeof(ResultFileHeader) &&
+      (*header).numberOfRows >= 0 && (*header).numberOfColumns >= 0 &&
+      (*header).rowStride >= (*header).numberOfColumns &&
+      (*header).solutionOffset + blockSize <= mappingSize &&
+      (*header).errorsOffset + blockSize <= mappingSize &&
+      (*header).keyOffset + (*header).keySize <= mappingSize;
+  if (!valid) {
+    munmap(mapping, mappingSize);
+    throw(std::invalid_argument(filename + " is not a valid result file"));
+  }
+};
+
+ResultFile::~ResultFile() { munmap(mapping, mappingSize); };
+
+std::string ResultFile::getSchemeName() const {
+  return std::string((*header).schemeName,
+                     strnlen((*header).schemeName, sizeof((*header).schemeName)));
+};
+
+std::string ResultFile::getKey() const {
+  return std::string(static_cast<const char *>(mapping) + (*header).keyOffset,
+                     (*header).keySize);
+};
+
+SolutionView ResultFile::blockView(std::uint64_t offset) const {
+  SolutionView block = {
+      reinterpret_cast<const double *>(static_cast<const char *>(mapping) +
+                                       offset),
+      (int)(*header).numberOfRows, (int)(*header).numberOfColumns,
+      (std::ptrdiff_t)(*header).rowStride, 1};
+  return block;
+}
+
+SolutionView ResultFile::getSolution() const {
+  return blockView((*header).solutionOffset);
+};
+
+SolutionView ResultFile::getErrors() const {
+  if (!hasErrors()) {
+    throw(std::logic_error("the result file has no errors"));
+  }
+  return blockView((*header).errorsOffset);
+};
+
+void resultFileToCsv(const std::string &binaryFilename,
+                     const std::string &csvFilename) {
+  ResultFile result(binaryFilename);
+  if (!result.hasErrors()) {
+    throw(std::invalid_argument(binaryFilename +
+                                " has no errors to write in the CSV layout"));
+  }
+  const ResultFileHeader &header = result.getHeader();
+  CsvWriter outputFile(csvFilename);
+  outputFile.setPrecision(16);
+  outputFile << "deltaX:," << header.deltaX << ",deltaT:," << header.deltaT
+             << "\n\n";
+  writeSolutionAndErrors(outputFile, result.getSolution(), result.getErrors(),
+                         header.deltaX, header.deltaT);
+  outputFile.close();
+}
@@ -0,0 +1,151 @@
+#pragma once // Include guard
+#include "solution_grid.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Header of a binary result file
+ *
+ * A result file is this header, an optional key identifying the result (see
+ * ResultCache), then raw blocks of doubles, each of them starting on a
+ * multiple of 64 bytes : the numerical solution, then the errors
+ * (analytical - numerical) if an analytical solution was given. The
+ * blocks are stored row by row with the rows padded as in SolutionGrid, so
+ * that a mapped file can be read in place through SolutionViews. Values are
+ * stored with the byte order of the machine that wrote them.
+ */
+struct ResultFileHeader {
+  /**
+   * @brief "HEATRES" followed by a 0
+   *
+   */
+  char magic[8];
+  std::uint32_t version;
+  /**
+   * @brief size of the header in bytes
+   *
+   */
+  std::uint32_t headerSize;
+  std::int64_t numberOfRows;
+  std::int64_t numberOfColumns;
+  /**
+   * @brief distance (in doubles) between two consecutive rows of a block
+   *
+   */
+  std::int64_t rowStride;
+  double deltaX;
+  double deltaT;
+  /**
+   * @brief uniform and two norms of the errors, 0 without errors
+   *
+   */
+  double uniformNorm;
+  double twoNorm;
+  /**
+   * @brief position in bytes of the blocks from the start of the file, 0 for
+   * a missing block
+   *
+   */
+  std::uint64_t solutionOffset;
+  std::uint64_t errorsOffset;
+  /**
+   * @brief position in bytes of the key from the start of the file and its
+   * size, 0 without a key
+   *
+   */
+  std::uint64_t keyOffset;
+  std::uint64_t keySize;
+  /**
+   * @brief name of the scheme, ended by a 0
+   *
+   */
+  char schemeName[64];
+  char reserved[88];
+};
+
+/**
+ * @brief Write a result in a binary file, with large sequential writes
+ *
+ * Can throw a runtime_error exception if the file cannot be written, or an
+ * invalid_argument exception if the analytical solution does not have the
+ * size of the numerical one
+ *
+ * @param filename : name of the output file
+ * @param schemeName : name of the scheme stored in the header
+ * @param numericalSolution : solution to store
+ * @param analyticalSolution : analytical solution on the same grid, to store
+ * the errors. Can be nullptr.
+ * @param deltaX : space step size
+ * @param deltaT : time step size
+ * @param key : key stored after the header, can be empty
+ */
+void writeResultFile(const std::string &filename, const std::string &schemeName,
+                     const SolutionGrid &numericalSolution,
+                     const SolutionGrid *analyticalSolution, double deltaX,
+                     double deltaT, const std::string &key = std::string());
+
+/**
+ * @brief Binary result file mapped in memory, read-only. The values are read
+ * in place, without any copy.
+ *
+ */
+class ResultFile {
+public:
+  /**
+   * @brief Map a result file
+   *
+   * Can throw a runtime_error exception if the file cannot be read, or an
+   * invalid_argument exception if it is not a valid result file
+   */
+  explicit ResultFile(const std::string &filename);
+
+  /**
+   * @brief Unmap the file
+   *
+   */
+  ~ResultFile();
+
+  ResultFile(const ResultFile &) = delete;
+  ResultFile &operator=(const ResultFile &) = delete;
+
+  const ResultFileHeader &getHeader() const { return *header; }
+  std::string getSchemeName() const;
+  /**
+   * @brief Key stored after the header, empty if none
+   *
+   */
+  std::string getKey() const;
+  bool hasErrors() const { return (*header).errorsOffset != 0; }
+
+  /**
+   * @brief View on the numerical solution
+   *
+   */
+  SolutionView getSolution() const;
+
+  /**
+   * @brief View on the errors (analytical - numerical)
+   *
+   * Can throw a logic_error exception if the file has no errors
+   */
+  SolutionView getErrors() const;
+
+private:
+  const ResultFileHeader *header;
+  void *mapping;
+  std::size_t mappingSize;
+
+  SolutionView blockView(std::uint64_t offset) const;
+};
+
+/**
+ * @brief Write a binary result file in the CSV layout of resultToFile
+ *
+ * Can throw the exceptions of ResultFile, or an invalid_argument exception
+ * if the file has no errors
+ *
+ * @param binaryFilename : name of the binary result file
+ * @param csvFilename : name of the CSV file to write
+ */
+void resultFileToCsv(const std::string &binaryFilename,
+                     const std::string &csvFilename);
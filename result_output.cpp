@@ -0,0 +1,166 @@
+#include "result_output.h"
+#include "error_accumulator.h"
+#include "instrumentation.h"
+#include "norms.h"
+#include <vector>
+
+/*=========== NORMS ===============*/
+
+double two_norm(const SolutionView &matrix) { return norms::twoNorm(matrix); }
+
+double uniform_norm(const SolutionView &matrix) {
+  return norms::uniformNorm(matrix);
+}
+
+/*=========== PRINT RESULT TO FILE ===============*/
+
+namespace {
+/**
+ * @brief Write the norms, the numerical solution and the errors. The errors
+ * of row i are given by errorRow(i, buffer), which stores them in buffer, and
+ * their norms by errorNorms, which must have all the rows already. Row i is
+ * at the time times[i], or i * deltaT when times is null.
+ *
+ */
+template <class ErrorRow>
+void writeSolutionAndErrorRows(CsvWriter &outputStream,
+                               const SolutionView &numericalSolution,
+                               ErrorRow errorRow,
+                               const ErrorAccumulator &errorNorms,
+                               double deltaX, double deltaT,
+                               const double *times = nullptr) {
+  int numberOfRows = numericalSolution.numberOfRows;
+  int numberOfColumns = numericalSolution.numberOfColumns;
+  auto time = [&](int i) { return times ? times[i] : i * deltaT; };
+
+  outputStream << "Errors measurements : " << "\n";
+  outputStream << "Uniform norm :," << errorNorms.getUniformNorm() << "\n";
+  outputStream << "Two norm :," << errorNorms.getTwoNorm() << "\n\n";
+
+  outputStream << "Numerical solution : " << "\n";
+  outputStream << "t\\x";
+  for (int i = 0; i < numberOfColumns; i++) {
+    outputStream << "," << i * deltaX;
+  }
+  outputStream << "\n";
+  for (int i = 0; i < numberOfRows; i++) {
+    outputStream << time(i);
+    for (int j = 0; j < numberOfColumns; j++) {
+      outputStream << "," << numericalSolution(i, j);
+    }
+    outputStream << "\n";
+  }
+
+  outputStream << "\nErrors (analytical - numerical ): " << "\n";
+  outputStream << "t\\x";
+  for (int i = 0; i < numberOfColumns; i++) {
+    outputStream << "," << i * deltaX;
+  }
+  outputStream << ",,uniform_norm(t),two_norm(t)\n";
+  std::vector<double> errors(numberOfColumns);
+  for (int i = 0; i < numberOfRows; i++) {
+    errorRow(i, errors.data());
+    outputStream << time(i);
+    for (int j = 0; j < numberOfColumns; j++) {
+      outputStream << "," << errors[j];
+    }
+    outputStream << ",," << errorNorms.getRowUniformNorm(i) << ","
+                 << errorNorms.getRowTwoNorm(i) << "\n";
+  }
+}
+
+/**
+ * @brief Copy row i of a view in a contiguous buffer
+ *
+ */
+void copyRow(const SolutionView &matrix, int i, double *row) {
+  for (int j = 0; j < matrix.numberOfColumns; j++) {
+    row[j] = matrix(i, j);
+  }
+}
+
+/**
+ * @brief Write the norms, the numerical solution and the errors computed
+ * from the analytical solution. The errors are computed twice, once for the
+ * norms written first and once when writing them, instead of being stored.
+ *
+ */
+void writeSolutionAndComputedErrors(CsvWriter &outputStream,
+                                    const SolutionGrid &numericalSolution,
+                                    const SolutionGrid &analyticalSolution,
+                                    double deltaX, double deltaT,
+                                    const double *times = nullptr) {
+  int numberOfColumns = numericalSolution.getNumberOfColumns();
+  ErrorAccumulator errorNorms;
+  for (int i = 0; i < numericalSolution.getNumberOfRows(); i++) {
+    errorNorms.addRow(numericalSolution.row(i), analyticalSolution.row(i),
+                      numberOfColumns);
+  }
+  writeSolutionAndErrorRows(
+      outputStream, numericalSolution.view(),
+      [&](int i, double *errors) {
+        const double *numericalRow = numericalSolution.row(i);
+        const double *analyticalRow = analyticalSolution.row(i);
+        for (int j = 0; j < numberOfColumns; j++) {
+          errors[j] = analyticalRow[j] - numericalRow[j];
+        }
+      },
+      errorNorms, deltaX, deltaT, times);
+}
+} // namespace
+
+void writeSolutionAndErrors(CsvWriter &outputStream,
+                            const SolutionView &numericalSolution,
+                            const SolutionView &errors, double deltaX,
+                            double deltaT) {
+  ErrorAccumulator errorNorms;
+  std::vector<double> row(errors.numberOfColumns);
+  for (int i = 0; i < errors.numberOfRows; i++) {
+    copyRow(errors, i, row.data());
+    errorNorms.addErrorRow(row.data(), errors.numberOfColumns);
+  }
+  writeSolutionAndErrorRows(
+      outputStream, numericalSolution,
+      [&](int i, double *errorRow) { copyRow(errors, i, errorRow); },
+      errorNorms, deltaX, deltaT);
+}
+
+void resultToFile(std::string filename, SolutionGrid *numericalSolution,
+                  SolutionGrid *analyticalSolution, double deltaX,
+                  double deltaT) {
+  HEAT_TIMED_SCOPE("output.result_to_file");
+  CsvWriter outputFile(filename);
+  outputFile.setPrecision(16);
+
+  outputFile << "deltaX:," << deltaX << ",deltaT:," << deltaT << "\n\n";
+  writeSolutionAndComputedErrors(outputFile, *numericalSolution,
+                                 *analyticalSolution, deltaX, deltaT);
+  outputFile.close();
+}
+
+void addFirstStepRelsultToFile(CsvWriter *outputFile,
+                               SolutionGrid *numericalSolution,
+                               SolutionGrid *analyticalSolution, double deltaX,
+                               double deltaT, std::string firstStepSolverName) {
+  HEAT_TIMED_SCOPE("output.first_step_section");
+  (*outputFile).setPrecision(16);
+  (*outputFile) << "\n First Step Solver :," << firstStepSolverName << "\n";
+  writeSolutionAndComputedErrors(*outputFile, *numericalSolution,
+                                 *analyticalSolution, deltaX, deltaT);
+}
+
+void adaptiveResultToFile(std::string filename,
+                          const AdaptiveSolution &solution,
+                          SolutionGrid *analyticalSolution, double deltaX) {
+  HEAT_TIMED_SCOPE("output.adaptive_result_to_file");
+  CsvWriter outputFile(filename);
+  outputFile.setPrecision(16);
+
+  outputFile << "deltaX:," << deltaX << ",accepted steps:,"
+             << solution.acceptedSteps << ",rejected steps:,"
+             << solution.rejectedSteps << "\n\n";
+  writeSolutionAndComputedErrors(outputFile, solution.temperatures,
+                                 *analyticalSolution, deltaX, 0,
+                                 solution.times.data());
+  outputFile.close();
+}
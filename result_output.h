@@ -0,0 +1,177 @@
+#pragma once // Include guard
+#include "csv_writer.h"
+#include "implicit_solver.h"
+#include "solution_grid.h"
+#include <string>
+
+/*=========== NORMS ===============*/
+
+/**
+ * @brief Compute the two-norm / Euclidian norm of a matrix (see
+ * norms::twoNorm)
+ *
+ * @param matrix : view on the matrix of which you want the norm
+ * @return double : the two-norm of the matrix
+ */
+double two_norm(const SolutionView &matrix);
+
+/**
+ * @brief Compute the uniform (maximum / infinity) norm of a matrix (see
+ * norms::uniformNorm)
+ *
+ * @param matrix : view on the matrix of which you want the norm
+ * @return double : the uniform norm of the matrix
+ */
+double uniform_norm(const SolutionView &matrix);
+
+/*=========== PRINT RESULT TO FILE ===============*/
+
+/**
+ * @brief Write the part shared by all the result layouts : the norms of the
+ * errors, the numerical solution and the errors with the norms of each time
+ * step (see resultToFile)
+ *
+ * @param outputStream : where the output data are sent, with a precision
+ * of 16 digits for the layouts of this file
+ * @param numericalSolution : view on the numerical solution
+ * @param errors : view on the errors (analytical - numerical), of the same
+ * size as the numerical solution
+ * @param deltaX : space step size
+ * @param deltaT : time step size
+ */
+void writeSolutionAndErrors(CsvWriter &outputStream,
+                            const SolutionView &numericalSolution,
+                            const SolutionView &errors, double deltaX,
+                            double deltaT);
+
+/**
+ * @brief Printing the numerical solution and its errors compared to the
+ * analytical solution
+ * - The file will start with the following information :
+ * ```
+ * deltaX:,<value of deltaX>,deltaT:,<value of deltaT>
+ * ```
+ *
+ * - Then we get the uniform norm and the two norm for all the points computed :
+ * ```
+ * Errors measurements :
+ * Uniform norm :,<value of the uniform norm>
+ * Two norm :,<value of the two norm>
+ * ```
+ *
+ * - Then all the points of the numerical solution will be printed :
+ * ```
+ * Numerical solution :
+ * t\x, ........... <values of x_j> ...................
+ * ...
+ * ...
+ * ...
+ * <values of t^n>      T^n_j
+ * ...
+ * ...
+ * ...
+ * ```
+
+ * - Finally the error for each points of the numerical solution and the two
+ norm and uniform norm for each time step will be printed :
+ * ```
+ * Errors (analytical - numerical ):
+ * t\x, ..... <values of x_j> ............  Uniform norm(t)  Two norm(t)
+ * ...                                <uniform norm T(t0)> <two norm T(t0)>
+ * ...                                              .             .
+ * ...                                              .             .
+ * ...                                              .             .
+ * <values of t^n> Analytical(x_j,t^n) - T^n_j      .             .
+ * ...                                              .             .
+ * ...                                <uniform norm T(tn)> <two norm T(tn)>
+ * ...                                              .             .
+ * ```
+
+ * @param filename : name of the output file, should end with .csv
+ * @param numericalSolution : pointer to the numerical solution
+ * @param analyticalSolution : pointer to the analytical solution. The
+ analytical solution should be solved for the same grid as the numerical one
+ * @param deltaX : space step size
+ * @param deltaT : time step size
+ */
+void resultToFile(std::string filename, SolutionGrid *numericalSolution,
+                  SolutionGrid *analyticalSolution, double deltaX,
+                  double deltaT);
+
+
+/**
+ * @brief Add the numerical solution and its errors compared to the
+ * analytical solution in an opened file
+ *
+ * This function was meant to easily print in a file different numerical
+ solution find with different first step solvers. It will add a section to an
+ open file following this structure :
+ *
+ * - The new section will start with the following informations :
+ * ```
+ *  First Step Solver :, <name of the first step solver>
+ *  Errors measurements :
+ *  Uniform norm :,<value of the uniform norm>
+ *  Two norm :,<value of the two norm>
+ * ```
+ * - Then all the points of the numerical solution will be printed :
+ * ```
+ * Numerical solution :
+ * t\x, ........... <values of x_j> ...................
+ * ...
+ * ...
+ * ...
+ * <values of t^n>      T^n_j
+ * ...
+ * ...
+ * ...
+ * ```
+ *
+ * - Finally the error for each points of the numerical solution and the two
+ norm and uniform norm for each time step will be printed :
+ * ```
+ * Errors (analytical - numerical ):
+ * t\x, ..... <values of x_j> ............  Uniform norm(t)  Two norm(t)
+ * ...                                <uniform norm T(t0)> <two norm T(t0)>
+ * ...                                              .             .
+ * ...                                              .             .
+ * ...                                              .             .
+ * <values of t^n> Analytical(x_j,t^n) - T^n_j      .             .
+ * ...                                              .             .
+ * ...                                <uniform norm T(tn)> <two norm T(tn)>
+ * ...                                              .             .
+ * ```
+ *
+ * @param outputFile : where the output data are sent
+ * @param numericalSolution : pointer to the numerical solution
+ * @param analyticalSolution : pointer to the analytical solution. The
+ analytical solution should be solved for the same grid as the numerical one
+ * @param deltaX : space step size
+ * @param deltaT : time step size
+ * @param firstStepSolverName : name of the solver used to compute the first
+ step
+ */
+
+void addFirstStepRelsultToFile(CsvWriter *outputFile,
+                               SolutionGrid *numericalSolution,
+                               SolutionGrid *analyticalSolution, double deltaX,
+                               double deltaT, std::string firstStepSolverName);
+
+/**
+ * @brief Printing a solution computed with a variable time step and its
+ * errors compared to the analytical solution. The layout is the one of
+ * resultToFile, except for the first line :
+ * ```
+ * deltaX:,<value of deltaX>,accepted steps:,<n>,rejected steps:,<m>
+ * ```
+ * and the first column, which holds the times of the solution.
+ *
+ * @param filename : name of the output file, should end with .csv
+ * @param solution : solution of ImplicitSolver::solveAdaptive
+ * @param analyticalSolution : pointer to the analytical solution at the
+ times of the solution (see ExactSolver::solveAtTimes)
+ * @param deltaX : space step size
+ */
+void adaptiveResultToFile(std::string filename,
+                          const AdaptiveSolution &solution,
+                          SolutionGrid *analyticalSolution, double deltaX);
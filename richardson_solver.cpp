@@ -1,20 +1,40 @@
 #include "richardson_solver.h"
+#include "solver_engine.h"
 
 RichardsonSolver::RichardsonSolver() {
   schemeName = "Richardson";
   threeLevelScheme = true;
 };
 
-double
-RichardsonSolver::nextStep(int spaceStep, int timeStep,
-                           std::vector<std::vector<double> > *TSolution) const {
+std::unique_ptr<AbstractSolver> RichardsonSolver::clone() const {
+  RichardsonSolver *solver = new RichardsonSolver();
+  copySettingsTo(solver);
+  return std::unique_ptr<AbstractSolver>(solver);
+}
+
+double RichardsonSolver::nextStep(int spaceStep, int,
+                                  const double *previousTimeStep,
+                                  const double *beforePreviousTimeStep) const {
   // According to richardson scheme :
-  double nextStep = (*TSolution)[timeStep - 2][spaceStep] +
-                    2 * parameters.getDiffusivity() *
-                        (deltaT / (deltaX * deltaX)) *
-                        ((*TSolution)[timeStep - 1][spaceStep + 1] -
-                         2 * (*TSolution)[timeStep - 1][spaceStep] +
-                         (*TSolution)[timeStep - 1][spaceStep - 1]);
+  double r = scheme::Richardson::coupling(parameters.getDiffusivity(), deltaT,
+                                          deltaX);
+  return (scheme::Richardson::point(previousTimeStep, beforePreviousTimeStep,
+                                    spaceStep, r));
+}
+
+void RichardsonSolver::solveInGrid(double pdeltaX, double pdeltaT,
+                                   SolutionGrid *storage, bool rollingWindow,
+                                   RowSink sink) {
+  solveInGridWithEngine(&engine, pdeltaX, pdeltaT, storage, rollingWindow,
+                        sink);
+}
 
-  return (nextStep);
+void RichardsonSolver::nextRowOnMesh(
+    const SpaceMesh &mesh, const double *previousTimeStep,
+    const double *beforePreviousTimeStep, double *TSolutionAtOneTime,
+    int firstSpaceStep, int lastSpaceStep) const {
+  scheme::Richardson::meshRow(previousTimeStep, beforePreviousTimeStep,
+                              TSolutionAtOneTime, mesh, firstSpaceStep,
+                              lastSpaceStep,
+                              parameters.getDiffusivity() * deltaT);
 }
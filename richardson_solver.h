@@ -6,7 +6,21 @@ class RichardsonSolver : public ExplicitSolver {
 public:
   RichardsonSolver();
 
+  std::unique_ptr<AbstractSolver> clone() const override;
+
 protected:
-  double nextStep(int spaceStep, int timeStep,
-                  std::vector<std::vector<double> > *TSolution) const override;
+  /**
+   * @brief Solver of the time steps on regular meshes
+   *
+   */
+  SolverEngine<scheme::Richardson> engine;
+
+  void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                   bool rollingWindow, RowSink sink) override;
+  double nextStep(int spaceStep, int timeStep, const double *previousTimeStep,
+                  const double *beforePreviousTimeStep) const override;
+  void nextRowOnMesh(const SpaceMesh &mesh, const double *previousTimeStep,
+                     const double *beforePreviousTimeStep,
+                     double *TSolutionAtOneTime, int firstSpaceStep,
+                     int lastSpaceStep) const override;
 };
@@ -0,0 +1,51 @@
+#include "simd_dispatch.h"
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#endif
+
+namespace simd {
+
+namespace {
+std::atomic<int> requestedInstructionSet(AVX2);
+}
+
+InstructionSet detectInstructionSet() {
+  static const InstructionSet detected = []() {
+#ifdef HEAT_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return SSE2;
+    }
+#endif
+    return SCALAR;
+  }();
+  return detected;
+}
+
+InstructionSet activeInstructionSet() {
+  int requested = requestedInstructionSet.load(std::memory_order_relaxed);
+  int detected = detectInstructionSet();
+  return (InstructionSet)(requested < detected ? requested : detected);
+}
+
+void setInstructionSet(InstructionSet instructionSet) {
+  requestedInstructionSet.store(instructionSet, std::memory_order_relaxed);
+}
+
+const char *instructionSetName(InstructionSet instructionSet) {
+  switch (instructionSet) {
+  case AVX2:
+    return "avx2";
+  case SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+} // namespace simd
@@ -0,0 +1,46 @@
+#pragma once // Include guard
+
+/**
+ * @brief Selection at runtime of the instruction set used by the vectorized
+ * kernels. The best instruction set supported by the processor is detected
+ * once; it can be lowered with setInstructionSet (for benchmarks or to compare
+ * with the scalar kernels).
+ *
+ */
+namespace simd {
+
+/**
+ * @brief Instruction sets for which vectorized kernels are available, from
+ * the least to the most capable
+ *
+ */
+enum InstructionSet { SCALAR = 0, SSE2 = 1, AVX2 = 2 };
+
+/**
+ * @brief Get the best instruction set supported by the processor
+ *
+ */
+InstructionSet detectInstructionSet();
+
+/**
+ * @brief Get the instruction set the kernels should use : the detected one
+ * unless a lower one has been requested with setInstructionSet
+ *
+ */
+InstructionSet activeInstructionSet();
+
+/**
+ * @brief Request the kernels to use a given instruction set. If the processor
+ * does not support it, the detected instruction set is used instead.
+ *
+ * @param instructionSet : instruction set to use
+ */
+void setInstructionSet(InstructionSet instructionSet);
+
+/**
+ * @brief Get the name of an instruction set ("scalar", "sse2" or "avx2")
+ *
+ */
+const char *instructionSetName(InstructionSet instructionSet);
+
+} // namespace simd
@@ -0,0 +1,145 @@
+#include "solution_grid.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Allocate numberOfValues doubles aligned on SolutionGrid::ALIGNMENT
+ * bytes. The pointer to give back to ::operator delete is stored in
+ * allocation.
+ */
+double *allocateAligned(std::size_t numberOfValues, void **allocation) {
+  if (numberOfValues == 0) {
+    *allocation = nullptr;
+    return nullptr;
+  }
+  *allocation = ::operator new(numberOfValues * sizeof(double) +
+                               SolutionGrid::ALIGNMENT);
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(*allocation);
+  address = (address + SolutionGrid::ALIGNMENT - 1) &
+            ~(std::uintptr_t)(SolutionGrid::ALIGNMENT - 1);
+  return reinterpret_cast<double *>(address);
+}
+} // namespace
+
+SolutionGrid::SolutionGrid()
+    : buffer(nullptr), allocation(nullptr), numberOfRows(0),
+      numberOfColumns(0), rowStride(0), capacityInRows(0){};
+
+SolutionGrid::SolutionGrid(int pnumberOfRows, int pnumberOfColumns)
+    : SolutionGrid() {
+  resize(pnumberOfRows, pnumberOfColumns);
+};
+
+SolutionGrid::SolutionGrid(const SolutionGrid &other) : SolutionGrid() {
+  rowStride = other.rowStride;
+  numberOfColumns = other.numberOfColumns;
+  grow(other.numberOfRows);
+  numberOfRows = other.numberOfRows;
+  std::copy(other.buffer, other.buffer + numberOfRows * rowStride, buffer);
+};
+
+SolutionGrid::SolutionGrid(SolutionGrid &&other) noexcept : SolutionGrid() {
+  std::swap(buffer, other.buffer);
+  std::swap(allocation, other.allocation);
+  std::swap(numberOfRows, other.numberOfRows);
+  std::swap(numberOfColumns, other.numberOfColumns);
+  std::swap(rowStride, other.rowStride);
+  std::swap(capacityInRows, other.capacityInRows);
+};
+
+SolutionGrid &SolutionGrid::operator=(SolutionGrid other) {
+  std::swap(buffer, other.buffer);
+  std::swap(allocation, other.allocation);
+  std::swap(numberOfRows, other.numberOfRows);
+  std::swap(numberOfColumns, other.numberOfColumns);
+  std::swap(rowStride, other.rowStride);
+  std::swap(capacityInRows, other.capacityInRows);
+  return *this;
+};
+
+SolutionGrid::~SolutionGrid() { ::operator delete(allocation); };
+
+std::ptrdiff_t SolutionGrid::strideFor(int pnumberOfColumns) {
+  const std::ptrdiff_t valuesPerAlignment = ALIGNMENT / sizeof(double);
+  return ((pnumberOfColumns + valuesPerAlignment - 1) / valuesPerAlignment) *
+         valuesPerAlignment;
+}
+
+void SolutionGrid::grow(int requiredRows) {
+  if (requiredRows <= capacityInRows) {
+    return;
+  }
+  int newCapacity = std::max(requiredRows, 2 * capacityInRows);
+  void *newAllocation;
+  double *newBuffer =
+      allocateAligned((std::size_t)newCapacity * rowStride, &newAllocation);
+  std::copy(buffer, buffer + numberOfRows * rowStride, newBuffer);
+  std::fill(newBuffer + numberOfRows * rowStride,
+            newBuffer + newCapacity * rowStride, 0.);
+  ::operator delete(allocation);
+  allocation = newAllocation;
+  buffer = newBuffer;
+  capacityInRows = newCapacity;
+}
+
+void SolutionGrid::resize(int pnumberOfRows, int pnumberOfColumns) {
+  if (pnumberOfRows < 0 || pnumberOfColumns < 0) {
+    throw(std::invalid_argument("size of a grid should be positive"));
+  }
+  std::ptrdiff_t newStride = strideFor(pnumberOfColumns);
+  std::size_t capacity = (std::size_t)capacityInRows * rowStride;
+  numberOfRows = 0;
+  numberOfColumns = pnumberOfColumns;
+  rowStride = newStride;
+  // Keeping the same buffer if it is big enough
+  capacityInRows = (rowStride > 0) ? capacity / rowStride : 0;
+  grow(pnumberOfRows);
+  numberOfRows = pnumberOfRows;
+  std::fill(buffer, buffer + numberOfRows * rowStride, 0.);
+}
+
+void SolutionGrid::clear() { numberOfRows = 0; }
+
+void SolutionGrid::reserve(int pnumberOfRows) { grow(pnumberOfRows); }
+
+void SolutionGrid::appendRow(const double *values, int pnumberOfColumns) {
+  if (numberOfRows == 0 && pnumberOfColumns != numberOfColumns) {
+    resize(0, pnumberOfColumns);
+  } else if (pnumberOfColumns != numberOfColumns) {
+    throw(std::invalid_argument(
+        "the row does not have the same size as the rows of the grid"));
+  }
+  grow(numberOfRows + 1);
+  double *newRow = row(numberOfRows);
+  std::copy(values, values + numberOfColumns, newRow);
+  std::fill(newRow + numberOfColumns, newRow + rowStride, 0.);
+  numberOfRows++;
+}
+
+SolutionView SolutionGrid::view() const {
+  SolutionView gridView = {buffer, numberOfRows, numberOfColumns, rowStride, 1};
+  return gridView;
+}
+
+SolutionView SolutionGrid::rowView(int i) const {
+  return blockView(i, 0, 1, numberOfColumns);
+}
+
+SolutionView SolutionGrid::columnView(int j) const {
+  return blockView(0, j, numberOfRows, 1);
+}
+
+SolutionView SolutionGrid::blockView(int firstRow, int firstColumn,
+                                     int blockRows, int blockColumns) const {
+  if (firstRow < 0 || firstColumn < 0 || blockRows < 0 || blockColumns < 0 ||
+      firstRow + blockRows > numberOfRows ||
+      firstColumn + blockColumns > numberOfColumns) {
+    throw(std::out_of_range("block is outside of the grid"));
+  }
+  SolutionView block = {buffer + firstRow * rowStride + firstColumn, blockRows,
+                        blockColumns, rowStride, 1};
+  return block;
+}
@@ -0,0 +1,191 @@
+#pragma once // Include guard
+#include <cstddef>
+
+/**
+ * @brief Read-only strided view on a block of a SolutionGrid
+ * Element (i, j) of the view is data[i * rowStride + j * columnStride]. A row,
+ * a column or any rectangular sub-block of a grid can be seen this way.
+ *
+ */
+struct SolutionView {
+  /**
+   * @brief first element of the view
+   *
+   */
+  const double *data;
+  /**
+   * @brief number of rows of the view
+   *
+   */
+  int numberOfRows;
+  /**
+   * @brief number of columns of the view
+   *
+   */
+  int numberOfColumns;
+  /**
+   * @brief distance (in doubles) between two consecutive rows
+   *
+   */
+  std::ptrdiff_t rowStride;
+  /**
+   * @brief distance (in doubles) between two consecutive columns
+   *
+   */
+  std::ptrdiff_t columnStride;
+
+  /**
+   * @brief Get the element (i, j) of the view
+   *
+   */
+  double operator()(int i, int j) const {
+    return data[i * rowStride + j * columnStride];
+  }
+};
+
+/**
+ * @brief Solution of the heat conduction problem on a regular grid
+ * Row n holds the temperatures at time n * deltaT, column j the temperatures
+ * at x = j * deltaX.
+ *
+ * All the values are stored in a single buffer aligned on ALIGNMENT bytes.
+ * Each row starts on an aligned address : the distance between two rows
+ * (getRowStride()) is the number of columns rounded up to a multiple of
+ * ALIGNMENT / sizeof(double). The padding values are kept to 0.
+ */
+class SolutionGrid {
+public:
+  /**
+   * @brief Alignment in bytes of the buffer and of each row
+   *
+   */
+  static const std::size_t ALIGNMENT = 64;
+
+  /**
+   * @brief Construct an empty grid
+   *
+   */
+  SolutionGrid();
+
+  /**
+   * @brief Construct a grid of numberOfRows x numberOfColumns values set to 0
+   *
+   */
+  SolutionGrid(int numberOfRows, int numberOfColumns);
+
+  SolutionGrid(const SolutionGrid &other);
+  SolutionGrid(SolutionGrid &&other) noexcept;
+  SolutionGrid &operator=(SolutionGrid other);
+
+  /**
+   * @brief Destroy the Solution Grid object and free its buffer
+   *
+   */
+  ~SolutionGrid();
+
+  /**
+   * @brief Change the size of the grid. Values are set to 0. The buffer is
+   * only reallocated if it is too small.
+   *
+   */
+  void resize(int numberOfRows, int numberOfColumns);
+
+  /**
+   * @brief Remove all the rows, keeping the buffer and the number of columns
+   *
+   */
+  void clear();
+
+  /**
+   * @brief Make sure numberOfRows rows can be stored without reallocation
+   *
+   */
+  void reserve(int numberOfRows);
+
+  /**
+   * @brief Add a row at the end of the grid. If the grid is empty, the number
+   * of columns is set to numberOfColumns, otherwise it should match it.
+   *
+   * Can throw an invalid_argument exception if the sizes do not match
+   *
+   * @param values : numberOfColumns values to copy
+   * @param numberOfColumns : number of values of the row
+   */
+  void appendRow(const double *values, int numberOfColumns);
+
+  /**
+   * @brief Get a pointer to the first value of the row i
+   *
+   */
+  double *row(int i) { return buffer + i * rowStride; }
+  const double *row(int i) const { return buffer + i * rowStride; }
+
+  /**
+   * @brief Get the value at row i and column j
+   *
+   */
+  double &operator()(int i, int j) { return buffer[i * rowStride + j]; }
+  double operator()(int i, int j) const { return buffer[i * rowStride + j]; }
+
+  /**
+   * @brief Get the first value of the last row
+   *
+   */
+  const double *lastRow() const { return row(numberOfRows - 1); }
+
+  int getNumberOfRows() const { return numberOfRows; }
+  int getNumberOfColumns() const { return numberOfColumns; }
+  std::ptrdiff_t getRowStride() const { return rowStride; }
+  bool isEmpty() const { return numberOfRows == 0; }
+
+  /**
+   * @brief View on the whole grid
+   *
+   */
+  SolutionView view() const;
+
+  /**
+   * @brief View on the row i (1 x numberOfColumns)
+   *
+   */
+  SolutionView rowView(int i) const;
+
+  /**
+   * @brief View on the column j (numberOfRows x 1)
+   *
+   */
+  SolutionView columnView(int j) const;
+
+  /**
+   * @brief View on the block of blockRows x blockColumns values starting at
+   * row firstRow and column firstColumn
+   *
+   */
+  SolutionView blockView(int firstRow, int firstColumn, int blockRows,
+                         int blockColumns) const;
+
+private:
+  /**
+   * @brief Row stride for a given number of columns
+   *
+   */
+  static std::ptrdiff_t strideFor(int numberOfColumns);
+
+  /**
+   * @brief Make sure the buffer can hold requiredRows rows of the current
+   * stride, keeping the existing values
+   *
+   */
+  void grow(int requiredRows);
+
+  double *buffer;
+  void *allocation;
+  int numberOfRows;
+  int numberOfColumns;
+  std::ptrdiff_t rowStride;
+  /**
+   * @brief number of rows that fit in the buffer
+   *
+   */
+  int capacityInRows;
+};
@@ -0,0 +1,698 @@
+#pragma once // Include guard
+#include "abstract_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "instrumentation.h"
+#include "parallel_tridiagonal_solver.h"
+#include "solution_grid.h"
+#include "space_mesh.h"
+#include "stencil_kernels.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Scheme policies used by SolverEngine
+ * Each policy describes one numerical scheme with static inline functions so
+ * that the engine specialised on it has no virtual call in its loops.
+ *
+ * Implicit schemes solve for each time step the linear system
+ * -c T(i-1) + (1+2c) T(i) - c T(i+1) = rightHandSide(i) inside the wall.
+ * Explicit schemes compute each point of a new time step from the previous
+ * ones.
+ */
+namespace scheme {
+
+/**
+ * @brief Laasonen simple implicit scheme
+ *
+ */
+struct Laasonen {
+  static const bool isImplicit = true;
+  static const bool isThreeLevel = false;
+  static const char *name() { return "Laasonen"; }
+  /**
+   * @brief The local error of a time step is O(deltaT^(orderInTime + 1))
+   *
+   */
+  static const int orderInTime = 1;
+  /**
+   * @brief Weight of the new time step in the second derivative :
+   * T(n+1) - T(n) = D deltaT (w d2T(n+1) + (1 - w) d2T(n)). Used on the
+   * meshes that are not evenly spaced.
+   *
+   */
+  static double implicitWeight() { return 1; }
+
+  /**
+   * @brief s = diffusivity * deltaT / deltaX^2
+   *
+   */
+  static double coupling(double diffusivity, double deltaT, double deltaX) {
+    return diffusivity * deltaT / (deltaX * deltaX);
+  }
+
+  static double rightHandSide(const double *previousTimeStep, int spaceStep,
+                              double) {
+    return previousTimeStep[spaceStep];
+  }
+};
+
+/**
+ * @brief Crank-Nicholson scheme
+ *
+ */
+struct CrankNicholson {
+  static const bool isImplicit = true;
+  static const bool isThreeLevel = false;
+  static const char *name() { return "Crank-Nicholson"; }
+  static const int orderInTime = 2;
+  static double implicitWeight() { return 0.5; }
+
+  /**
+   * @brief c = s/2 = diffusivity * deltaT / (2 deltaX^2) as defined in the
+   * report
+   *
+   */
+  static double coupling(double diffusivity, double deltaT, double deltaX) {
+    return diffusivity * deltaT / (2 * deltaX * deltaX);
+  }
+
+  static double rightHandSide(const double *previousTimeStep, int spaceStep,
+                              double c) {
+    return (1 - (2 * c)) * previousTimeStep[spaceStep] +
+           c * previousTimeStep[spaceStep + 1] +
+           c * previousTimeStep[spaceStep - 1];
+  }
+};
+
+/**
+ * @brief Richardson three-level explicit scheme
+ *
+ */
+struct Richardson {
+  static const bool isImplicit = false;
+  static const bool isThreeLevel = true;
+  static const char *name() { return "Richardson"; }
+
+  /**
+   * @brief r = 2 * diffusivity * deltaT / deltaX^2
+   *
+   */
+  static double coupling(double diffusivity, double deltaT, double deltaX) {
+    return 2 * diffusivity * (deltaT / (deltaX * deltaX));
+  }
+
+  static double point(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep, int spaceStep,
+                      double r) {
+    return beforePreviousTimeStep[spaceStep] +
+           r * (previousTimeStep[spaceStep + 1] -
+                2 * previousTimeStep[spaceStep] +
+                previousTimeStep[spaceStep - 1]);
+  }
+
+  /**
+   * @brief Points [firstSpaceStep, lastSpaceStep) of a new time step : short
+   * rows are computed inline, the others by the kernel chosen at runtime
+   *
+   */
+  static void row(const double *previousTimeStep,
+                  const double *beforePreviousTimeStep,
+                  double *TSolutionAtOneTime, int firstSpaceStep,
+                  int lastSpaceStep, double r) {
+    if (lastSpaceStep - firstSpaceStep < stencil::SHORT_ROW_LENGTH) {
+      stencil::richardsonShortRow(previousTimeStep, beforePreviousTimeStep,
+                                  TSolutionAtOneTime, firstSpaceStep,
+                                  lastSpaceStep, r);
+    } else {
+      stencil::richardsonRow(previousTimeStep, beforePreviousTimeStep,
+                             TSolutionAtOneTime, firstSpaceStep,
+                             lastSpaceStep, r);
+    }
+  }
+
+  static void meshRow(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep,
+                      double *TSolutionAtOneTime, const SpaceMesh &mesh,
+                      int firstSpaceStep, int lastSpaceStep,
+                      double diffusivityDeltaT) {
+    stencil::richardsonMeshRow(previousTimeStep, beforePreviousTimeStep,
+                               TSolutionAtOneTime, mesh.getLowerCoefficients(),
+                               mesh.getUpperCoefficients(), firstSpaceStep,
+                               lastSpaceStep, diffusivityDeltaT);
+  }
+};
+
+/**
+ * @brief DuFort-Frankel three-level explicit scheme
+ *
+ */
+struct DufortFrankel {
+  static const bool isImplicit = false;
+  static const bool isThreeLevel = true;
+  static const char *name() { return "Dufort-Frankel"; }
+
+  /**
+   * @brief r = 2 * diffusivity * deltaT / deltaX^2
+   *
+   */
+  static double coupling(double diffusivity, double deltaT, double deltaX) {
+    return 2 * diffusivity * (deltaT / (deltaX * deltaX));
+  }
+
+  static double point(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep, int spaceStep,
+                      double r) {
+    return (beforePreviousTimeStep[spaceStep] +
+            r * (previousTimeStep[spaceStep + 1] -
+                 beforePreviousTimeStep[spaceStep] +
+                 previousTimeStep[spaceStep - 1])) /
+           (1 + r);
+  }
+
+  static void row(const double *previousTimeStep,
+                  const double *beforePreviousTimeStep,
+                  double *TSolutionAtOneTime, int firstSpaceStep,
+                  int lastSpaceStep, double r) {
+    if (lastSpaceStep - firstSpaceStep < stencil::SHORT_ROW_LENGTH) {
+      stencil::dufortFrankelShortRow(previousTimeStep, beforePreviousTimeStep,
+                                     TSolutionAtOneTime, firstSpaceStep,
+                                     lastSpaceStep, r);
+    } else {
+      stencil::dufortFrankelRow(previousTimeStep, beforePreviousTimeStep,
+                                TSolutionAtOneTime, firstSpaceStep,
+                                lastSpaceStep, r);
+    }
+  }
+
+  static void meshRow(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep,
+                      double *TSolutionAtOneTime, const SpaceMesh &mesh,
+                      int firstSpaceStep, int lastSpaceStep,
+                      double diffusivityDeltaT) {
+    stencil::dufortFrankelMeshRow(
+        previousTimeStep, beforePreviousTimeStep, TSolutionAtOneTime,
+        mesh.getLowerCoefficients(), mesh.getUpperCoefficients(),
+        firstSpaceStep, lastSpaceStep, diffusivityDeltaT);
+  }
+};
+
+} // namespace scheme
+
+/**
+ * @brief Building blocks of the Thomas algorithm for an implicit scheme
+ * policy. They work on raw arrays so that they can be shared by
+ * SolverEngine and by the polymorphic ImplicitSolver classes.
+ *
+ */
+template <class Scheme> struct ImplicitKernels {
+  /**
+   * @brief Fill the three diagonals of the A matrix of the scheme, with the
+   * Dirichlet boundary conditions on the first and last rows
+   *
+   */
+  static void fillDiagonals(double c, int numberOfSpacePoints,
+                            double *lowerDiagonal, double *mainDiagonal,
+                            double *upperDiagonal) {
+    std::fill(lowerDiagonal, lowerDiagonal + numberOfSpacePoints, -c);
+    std::fill(mainDiagonal, mainDiagonal + numberOfSpacePoints, 1 + (2 * c));
+    std::fill(upperDiagonal, upperDiagonal + numberOfSpacePoints, -c);
+    // Boundary conditions : T(0) and T(L) are given
+    lowerDiagonal[0] = 0;
+    mainDiagonal[0] = 1;
+    upperDiagonal[0] = 0;
+    lowerDiagonal[numberOfSpacePoints - 1] = 0;
+    mainDiagonal[numberOfSpacePoints - 1] = 1;
+    upperDiagonal[numberOfSpacePoints - 1] = 0;
+  }
+
+  /**
+   * @brief Fill B, the right hand side of the linear system
+   *
+   */
+  static void rightHandSide(const double *previousTimeStep, double *B,
+                            int numberOfSpacePoints, double c) {
+    B[0] = previousTimeStep[0];
+    for (int i = 1; i < numberOfSpacePoints - 1; i++) {
+      B[i] = Scheme::rightHandSide(previousTimeStep, i, c);
+    }
+    B[numberOfSpacePoints - 1] = previousTimeStep[numberOfSpacePoints - 1];
+  }
+};
+
+/**
+ * @brief Forward elimination of the Thomas algorithm applied to A only :
+ * compute the pivots and the modified super-diagonal
+ *
+ */
+inline void factorizeTridiagonal(int size, const double *lowerDiagonal,
+                                 const double *mainDiagonal,
+                                 const double *upperDiagonal, double *pivots,
+                                 double *modifiedUpperDiagonal) {
+  pivots[0] = mainDiagonal[0];
+  modifiedUpperDiagonal[0] = upperDiagonal[0] / pivots[0];
+  for (int i = 1; i < size; i++) {
+    pivots[i] = mainDiagonal[i] - lowerDiagonal[i] * modifiedUpperDiagonal[i - 1];
+    modifiedUpperDiagonal[i] = upperDiagonal[i] / pivots[i];
+  }
+}
+
+/**
+ * @brief Forward elimination on B and backward substitution of the Thomas
+ * algorithm, once A has been factorized by factorizeTridiagonal. B is
+ * overwritten.
+ *
+ */
+inline void solveFactorizedTridiagonal(int size, const double *lowerDiagonal,
+                                       const double *pivots,
+                                       const double *modifiedUpperDiagonal,
+                                       double *B, double *X) {
+  B[0] = B[0] / pivots[0];
+  for (int i = 1; i < size; i++) {
+    B[i] = (B[i] - lowerDiagonal[i] * B[i - 1]) / pivots[i];
+  }
+  X[size - 1] = B[size - 1];
+  for (int i = size - 2; i >= 0; i--) {
+    X[i] = B[i] - X[i + 1] * modifiedUpperDiagonal[i];
+  }
+}
+
+/**
+ * @brief Initial state of the wall : the surface temperature at both ends, the
+ * internal temperature elsewhere
+ *
+ */
+inline void fillInitialState(const HeatDiffusionParameters &parameters,
+                             double *TInitialState, int numberOfSpacePoints) {
+  std::fill(TInitialState, TInitialState + numberOfSpacePoints,
+            parameters.getInternalTemperature());
+  TInitialState[0] = parameters.getSurfaceTemperature();
+  TInitialState[numberOfSpacePoints - 1] = parameters.getSurfaceTemperature();
+}
+
+/**
+ * @brief Richardson's extrapolation of the first time step Tc = 4/3 Tb - Ta/3,
+ * grid B having half the space step and a quarter of the time step of grid A
+ *
+ * @param TLastStepGridA : temperatures of grid A at t=deltaT
+ * @param TLastStepGridB : temperatures of grid B at t=deltaT
+ * @param TFirstStep : where to store the extrapolated temperatures
+ * @param numberOfSpacePoints : number of points of grid A
+ */
+inline void extrapolateFirstStep(const double *TLastStepGridA,
+                                 const double *TLastStepGridB,
+                                 double *TFirstStep, int numberOfSpacePoints) {
+  for (int j = 0; j < numberOfSpacePoints; j++) {
+    TFirstStep[j] = (4 * TLastStepGridB[2 * j] - TLastStepGridA[j]) / 3;
+  }
+}
+
+/**
+ * @brief Compute the time steps [firstTimeIndex, endTimeIndex) of an explicit
+ * scheme row by row. Time step n is stored in row n % (number of rows) of
+ * storage, which can hold all the time steps or only the ones needed by the
+ * scheme.
+ *
+ * @param storage : grid where the time steps are computed
+ * @param firstTimeIndex : first time step to compute
+ * @param endTimeIndex : time step after the last one to compute
+ * @param surfaceTemperature : temperature at both ends of each time step
+ * @param threeLevelScheme : whether the scheme reads the time step n-2
+ * @param row : computes the points [first, last) of time step n, called as
+ * row(n, time step n-1, time step n-2 or nullptr, time step n, first, last)
+ * @param sink : function called with each time step, can be empty
+ */
+template <class Row>
+void advanceRowByRow(SolutionGrid *storage, int firstTimeIndex,
+                     int endTimeIndex, double surfaceTemperature,
+                     bool threeLevelScheme, Row row,
+                     const AbstractSolver::RowSink &sink) {
+  int numberOfRows = (*storage).getNumberOfRows();
+  int numberOfSpacePoints = (*storage).getNumberOfColumns();
+  for (int timeIndex = firstTimeIndex; timeIndex < endTimeIndex; timeIndex++) {
+    double *TSolutionAtOneTime = (*storage).row(timeIndex % numberOfRows);
+    const double *previousTimeStep =
+        (*storage).row((timeIndex - 1) % numberOfRows);
+    const double *beforePreviousTimeStep =
+        threeLevelScheme ? (*storage).row((timeIndex - 2) % numberOfRows)
+                         : nullptr;
+    // using left boundary condition to get the first value
+    TSolutionAtOneTime[0] = surfaceTemperature;
+    // using the explicit scheme to get the values from the middle
+    row(timeIndex, previousTimeStep, beforePreviousTimeStep,
+        TSolutionAtOneTime, 1, numberOfSpacePoints - 1);
+    // using right boundary condition to get the last value
+    TSolutionAtOneTime[numberOfSpacePoints - 1] = surfaceTemperature;
+    if (sink) {
+      sink(timeIndex, TSolutionAtOneTime, numberOfSpacePoints);
+    }
+  }
+}
+
+/**
+ * @brief Compute the time steps [firstTimeIndex, endTimeIndex) of an explicit
+ * scheme in storage, which holds all the time steps, by blocks of
+ * levelsPerTile levels. Each block is swept from left to right by tiles of
+ * tileWidth points that lean one point to the left at each level, so that the
+ * rows of a tile are still in cache when the next level is computed. The
+ * operations done on each point are the same as row by row.
+ *
+ * @param storage : grid with all the time steps
+ * @param firstTimeIndex : first time step to compute
+ * @param endTimeIndex : time step after the last one to compute
+ * @param tileWidth : number of points of a tile at each level
+ * @param levelsPerTile : number of levels of a block
+ * @param surfaceTemperature : temperature at both ends of each time step
+ * @param threeLevelScheme : whether the scheme reads the time step n-2
+ * @param row : computes the points [first, last) of a time step, as for
+ * advanceRowByRow
+ * @param sink : function called with each time step, can be empty
+ */
+template <class Row>
+void advanceByTiles(SolutionGrid *storage, int firstTimeIndex,
+                    int endTimeIndex, int tileWidth, int levelsPerTile,
+                    double surfaceTemperature, bool threeLevelScheme, Row row,
+                    const AbstractSolver::RowSink &sink) {
+  int numberOfSpacePoints = (*storage).getNumberOfColumns();
+  for (int blockStart = firstTimeIndex; blockStart < endTimeIndex;
+       blockStart += levelsPerTile) {
+    int blockEnd = std::min(endTimeIndex, blockStart + levelsPerTile);
+    // Boundary conditions first, they are read by the tiles
+    for (int timeIndex = blockStart; timeIndex < blockEnd; timeIndex++) {
+      (*storage)(timeIndex, 0) = surfaceTemperature;
+      (*storage)(timeIndex, numberOfSpacePoints - 1) = surfaceTemperature;
+    }
+    // Each tile covers [tileStart, tileStart + tileWidth) at the first level
+    // of the block and is shifted one point to the left at each level, so
+    // that the points it needs at the previous levels have been computed by
+    // itself or by the tiles on its left. The last tile has to go beyond the
+    // right surface to cover it at the last level.
+    int numberOfLevels = blockEnd - blockStart;
+    for (int tileStart = 1;
+         tileStart < numberOfSpacePoints - 2 + numberOfLevels;
+         tileStart += tileWidth) {
+      for (int timeIndex = blockStart; timeIndex < blockEnd; timeIndex++) {
+        int shift = timeIndex - blockStart;
+        int firstSpaceStep = std::max(1, tileStart - shift);
+        int lastSpaceStep =
+            std::min(numberOfSpacePoints - 1, tileStart + tileWidth - shift);
+        if (firstSpaceStep < lastSpaceStep) {
+          row(timeIndex, (*storage).row(timeIndex - 1),
+              threeLevelScheme ? (*storage).row(timeIndex - 2) : nullptr,
+              (*storage).row(timeIndex), firstSpaceStep, lastSpaceStep);
+        }
+      }
+    }
+    if (sink) {
+      for (int timeIndex = blockStart; timeIndex < blockEnd; timeIndex++) {
+        sink(timeIndex, (*storage).row(timeIndex), numberOfSpacePoints);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Solver of the heat conduction problem specialised at compile time on
+ * a scheme policy of the scheme namespace. All the calls in the time loop are
+ * resolved statically and can be inlined by the compiler.
+ *
+ * LaasonenSolver, CrankNicholsonSolver, RichardsonSolver and
+ * DufortFrankelSolver are adapters over it for the solves on regular meshes.
+ * Used on its own, the first step of three-level schemes is computed with the
+ * Laasonen scheme and Richardson's extrapolation, as by default in
+ * ExplicitSolver.
+ */
+template <class Scheme> class SolverEngine {
+public:
+  /**
+   * @brief Function storing the temperatures at t=0 and t=deltaT of a
+   * three-level scheme in its two arguments
+   *
+   */
+  typedef std::function<void(double *, double *)> FirstStepFunction;
+
+  /**
+   * @brief Minimal number of points of a time step for the implicit schemes to
+   * use a ParallelTridiagonalSolver, when it has several threads
+   *
+   */
+  static const int DEFAULT_PARALLEL_THRESHOLD = 200000;
+
+  /**
+   * @brief Set up parameters of the problem to solve
+   *
+   * Can throw an invalid_argument exception if they are not all initialized
+   */
+  void setParameters(const HeatDiffusionParameters &problemParameters) {
+    if (!problemParameters.checkInitialization()) {
+      throw(std::invalid_argument(
+          "Parameters have not yet been properly initialized"));
+    }
+    parameters = problemParameters;
+  }
+
+  /**
+   * @brief Set the minimal number of points of a time step for the implicit
+   * schemes to use a ParallelTridiagonalSolver
+   *
+   */
+  void setParallelThreshold(int numberOfSpacePoints) {
+    parallelThreshold = numberOfSpacePoints;
+  }
+
+  /**
+   * @brief Set the tiles used by the explicit schemes when all the time steps
+   * are stored (see advanceByTiles)
+   *
+   * @param ptileWidth : number of points of a tile at each level, 0 to
+   * compute the time steps row by row
+   * @param plevelsPerTile : number of time levels of a tile
+   */
+  void setTiles(int ptileWidth, int plevelsPerTile) {
+    tileWidth = ptileWidth;
+    levelsPerTile = plevelsPerTile;
+  }
+
+  /**
+   * @brief Set the function giving the first two time steps of three-level
+   * schemes, an empty one for the Laasonen scheme with Richardson's
+   * extrapolation
+   *
+   */
+  void setFirstStep(const FirstStepFunction &pfirstStep) {
+    firstStep = pfirstStep;
+  }
+
+  /**
+   * @brief Number of time steps per second measured during the last solve
+   *
+   */
+  double getStepsPerSecond() const { return stepsPerSecond; }
+
+  /**
+   * @brief Solve the problem on a regular mesh
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param TSolutionPtr : grid where the solution is stored
+   */
+  void solveRegularMeshes(double deltaX, double deltaT,
+                          SolutionGrid *TSolutionPtr) {
+    solveInGrid(deltaX, deltaT, TSolutionPtr, false, AbstractSolver::RowSink());
+  }
+
+  /**
+   * @brief Solve the problem storing the time steps in storage and handing
+   * them to sink (if any) once computed
+   *
+   * @param deltaX : size if the space step
+   * @param deltaT : size of the time step
+   * @param storage : grid where the time steps are computed. It holds all
+   * the time steps, or only the ones needed by the scheme if rollingWindow is
+   * true
+   * @param rollingWindow : whether storage is used as a rolling window
+   * @param sink : function called with each time step, can be empty
+   */
+  void solveInGrid(double deltaX, double deltaT, SolutionGrid *storage,
+                   bool rollingWindow, const AbstractSolver::RowSink &sink) {
+    if (!parameters.checkInitialization()) {
+      throw(std::invalid_argument(
+          "Parameters have not yet been properly initialized"));
+    }
+    solve(deltaX, deltaT, storage, rollingWindow, sink,
+          std::integral_constant<bool, Scheme::isImplicit>());
+  }
+
+private:
+  HeatDiffusionParameters parameters;
+  int parallelThreshold = DEFAULT_PARALLEL_THRESHOLD;
+  int tileWidth = 0;
+  int levelsPerTile = 0;
+  FirstStepFunction firstStep;
+  double stepsPerSecond = 0;
+  std::vector<double> lowerDiagonal, mainDiagonal, upperDiagonal, pivots,
+      modifiedUpperDiagonal, matrixB;
+  ParallelTridiagonalSolver parallelSolver;
+  bool useParallelSolver = false;
+
+  void recordStepRate(int numberOfSteps,
+                      std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    stepsPerSecond =
+        (elapsed.count() > 0) ? numberOfSteps / elapsed.count() : 0;
+  }
+
+  /**
+   * @brief Fill and factorize the A matrix of an implicit scheme
+   *
+   */
+  void factorize(double c, int numberOfSpacePoints) {
+    lowerDiagonal.resize(numberOfSpacePoints);
+    mainDiagonal.resize(numberOfSpacePoints);
+    upperDiagonal.resize(numberOfSpacePoints);
+    pivots.resize(numberOfSpacePoints);
+    modifiedUpperDiagonal.resize(numberOfSpacePoints);
+    matrixB.resize(numberOfSpacePoints);
+    ImplicitKernels<Scheme>::fillDiagonals(c, numberOfSpacePoints,
+                                           lowerDiagonal.data(),
+                                           mainDiagonal.data(),
+                                           upperDiagonal.data());
+    useParallelSolver = numberOfSpacePoints >= parallelThreshold &&
+                        ThreadPool::shared().getNumberOfThreads() > 1;
+    if (useParallelSolver) {
+      parallelSolver.factorize(numberOfSpacePoints, lowerDiagonal.data(),
+                               mainDiagonal.data(), upperDiagonal.data());
+    } else {
+      factorizeTridiagonal(numberOfSpacePoints, lowerDiagonal.data(),
+                           mainDiagonal.data(), upperDiagonal.data(),
+                           pivots.data(), modifiedUpperDiagonal.data());
+    }
+  }
+
+  /**
+   * @brief Time loop of the implicit schemes
+   *
+   */
+  void solve(double deltaX, double deltaT, SolutionGrid *storage,
+             bool rollingWindow, const AbstractSolver::RowSink &sink,
+             std::true_type) {
+    int numberOfSpacePoints = parameters.getNumberOfSpacePoints(deltaX);
+    int numberOfTimeSteps = parameters.getNumberOfTimeSteps(deltaT);
+    // With a rolling window, only the previous time step is kept : time step
+    // n is stored in row n % 2
+    (*storage).resize(rollingWindow ? 2 : numberOfTimeSteps,
+                      numberOfSpacePoints);
+    int numberOfRows = (*storage).getNumberOfRows();
+    fillInitialState(parameters, (*storage).row(0), numberOfSpacePoints);
+    if (sink) {
+      sink(0, (*storage).row(0), numberOfSpacePoints);
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    double c = Scheme::coupling(parameters.getDiffusivity(), deltaT, deltaX);
+    {
+      HEAT_TIMED_SCOPE("implicit.matrix_setup");
+      factorize(c, numberOfSpacePoints);
+    }
+
+    // Right hand side and Thomas algorithm of each time step
+    HEAT_TIMED_SCOPE("implicit.time_steps");
+    for (int timeIndex = 1; timeIndex < numberOfTimeSteps; timeIndex++) {
+      double *TSolutionAtOneTime = (*storage).row(timeIndex % numberOfRows);
+      ImplicitKernels<Scheme>::rightHandSide(
+          (*storage).row((timeIndex - 1) % numberOfRows), matrixB.data(),
+          numberOfSpacePoints, c);
+      if (useParallelSolver) {
+        parallelSolver.solve(matrixB.data(), TSolutionAtOneTime);
+      } else {
+        solveFactorizedTridiagonal(numberOfSpacePoints, lowerDiagonal.data(),
+                                   pivots.data(), modifiedUpperDiagonal.data(),
+                                   matrixB.data(), TSolutionAtOneTime);
+      }
+      if (sink) {
+        sink(timeIndex, TSolutionAtOneTime, numberOfSpacePoints);
+      }
+    }
+    int numberOfSteps = numberOfTimeSteps - 1;
+    HEAT_COUNT("implicit.steps", numberOfSteps);
+    recordStepRate(numberOfSteps, start);
+  }
+
+  /**
+   * @brief Time loop of the explicit schemes
+   *
+   */
+  void solve(double deltaX, double deltaT, SolutionGrid *storage,
+             bool rollingWindow, const AbstractSolver::RowSink &sink,
+             std::false_type) {
+    static_assert(Scheme::isThreeLevel,
+                  "explicit schemes are expected to be three-level schemes");
+    int numberOfSpacePoints = parameters.getNumberOfSpacePoints(deltaX);
+    int numberOfTimeSteps = parameters.getNumberOfTimeSteps(deltaT);
+    // With a rolling window, time step n is stored in row n % 3
+    (*storage).resize(rollingWindow ? 3 : std::max(numberOfTimeSteps, 2),
+                      numberOfSpacePoints);
+    if (firstStep) {
+      firstStep((*storage).row(0), (*storage).row(1));
+    } else {
+      computeFirstStep(deltaX, deltaT, (*storage).row(0), (*storage).row(1));
+    }
+    if (sink) {
+      sink(0, (*storage).row(0), numberOfSpacePoints);
+      sink(1, (*storage).row(1), numberOfSpacePoints);
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    HEAT_TIMED_SCOPE("explicit.time_steps");
+    double r = Scheme::coupling(parameters.getDiffusivity(), deltaT, deltaX);
+    // Scheme::row is inlined in the loops
+    auto row = [r](int, const double *previousTimeStep,
+                   const double *beforePreviousTimeStep,
+                   double *TSolutionAtOneTime, int firstSpaceStep,
+                   int lastSpaceStep) {
+      Scheme::row(previousTimeStep, beforePreviousTimeStep, TSolutionAtOneTime,
+                  firstSpaceStep, lastSpaceStep, r);
+    };
+    double surfaceTemperature = parameters.getSurfaceTemperature();
+    if (!rollingWindow && tileWidth > 0) {
+      advanceByTiles(storage, 2, numberOfTimeSteps, tileWidth, levelsPerTile,
+                     surfaceTemperature, true, row, sink);
+    } else {
+      advanceRowByRow(storage, 2, numberOfTimeSteps, surfaceTemperature, true,
+                      row, sink);
+    }
+    int numberOfSteps = std::max(numberOfTimeSteps - 2, 0);
+    HEAT_COUNT("explicit.steps", numberOfSteps);
+    recordStepRate(numberOfSteps, start);
+  }
+
+  /**
+   * @brief First two time steps of three-level schemes : Laasonen scheme with
+   * Richardson's extrapolation Tc = 4/3 Tb - Ta/3
+   *
+   */
+  void computeFirstStep(double deltaX, double deltaT, double *initialStep,
+                        double *TFirstStep) const {
+    HEAT_TIMED_SCOPE("explicit.first_step");
+    HeatDiffusionParameters firstStepParameters(parameters);
+    firstStepParameters.setTimeLimit(1 * deltaT);
+    SolverEngine<scheme::Laasonen> firstStepEngine;
+    firstStepEngine.setParameters(firstStepParameters);
+    firstStepEngine.setParallelThreshold(parallelThreshold);
+    SolutionGrid TSolutionGridA, TSolutionGridB;
+    firstStepEngine.solveRegularMeshes(deltaX, deltaT, &TSolutionGridA);
+    firstStepEngine.solveRegularMeshes(deltaX / 2, deltaT / 4,
+                                       &TSolutionGridB);
+    int numberOfSpacePoints = TSolutionGridA.getNumberOfColumns();
+    fillInitialState(parameters, initialStep, numberOfSpacePoints);
+    extrapolateFirstStep(TSolutionGridA.lastRow(), TSolutionGridB.lastRow(),
+                         TFirstStep, numberOfSpacePoints);
+  }
+};
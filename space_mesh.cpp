@@ -0,0 +1,248 @@
+#include "space_mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SpaceMesh::SpaceMesh(){};
+
+SpaceMesh::SpaceMesh(const std::vector<double> &ppositions)
+    : positions(ppositions) {
+  int numberOfPoints = positions.size();
+  if (numberOfPoints < 3) {
+    throw(std::invalid_argument("a mesh should have at least 3 points"));
+  }
+  for (int j = 1; j < numberOfPoints; j++) {
+    if (!(positions[j] > positions[j - 1])) {
+      throw(std::invalid_argument(
+          "the points of a mesh should be strictly increasing"));
+    }
+  }
+  lowerCoefficients.assign(numberOfPoints, 0);
+  upperCoefficients.assign(numberOfPoints, 0);
+  for (int j = 1; j < numberOfPoints - 1; j++) {
+    double stepBefore = positions[j] - positions[j - 1];
+    double stepAfter = positions[j + 1] - positions[j];
+    lowerCoefficients[j] = 2 / (stepBefore * (stepBefore + stepAfter));
+    upperCoefficients[j] = 2 / (stepAfter * (stepBefore + stepAfter));
+  }
+};
+
+SpaceMesh SpaceMesh::uniform(double width, double deltaX) {
+  if (width <= 0 || deltaX <= 0) {
+    throw(std::invalid_argument("width and deltaX should be positive"));
+  }
+  int numberOfPoints = (int)(width / deltaX) + 1;
+  std::vector<double> positions(numberOfPoints);
+  for (int j = 0; j < numberOfPoints; j++) {
+    positions[j] = j * deltaX;
+  }
+  return SpaceMesh(positions);
+}
+
+SpaceMesh SpaceMesh::graded(double width, double smallestStep,
+                            double growthRate, double largestStep) {
+  if (width <= 0 || smallestStep <= 0 || largestStep < smallestStep ||
+      growthRate < 1) {
+    throw(std::invalid_argument(
+        "a graded mesh needs a positive width, 0 < smallestStep <= "
+        "largestStep and a growth rate of at least 1"));
+  }
+  // Steps of the left half, from the surface to the middle
+  double halfWidth = width / 2;
+  std::vector<double> steps;
+  double total = 0;
+  double step = smallestStep;
+  while (total < halfWidth) {
+    steps.push_back(step);
+    total += step;
+    step = std::min(step * growthRate, largestStep);
+  }
+  double scale = halfWidth / total;
+  int stepsPerHalf = steps.size();
+  std::vector<double> positions(2 * stepsPerHalf + 1);
+  positions[0] = 0;
+  positions[2 * stepsPerHalf] = width;
+  double x = 0;
+  for (int k = 0; k < stepsPerHalf - 1; k++) {
+    x += steps[k] * scale;
+    positions[k + 1] = x;
+    positions[2 * stepsPerHalf - 1 - k] = width - x;
+  }
+  positions[stepsPerHalf] = halfWidth;
+  return SpaceMesh(positions);
+}
+
+int SpaceMesh::getNumberOfPoints() const { return positions.size(); };
+
+double SpaceMesh::getPosition(int j) const { return positions[j]; };
+
+const double *SpaceMesh::getPositions() const { return positions.data(); };
+
+double SpaceMesh::getStep(int j) const {
+  return positions[j + 1] - positions[j];
+};
+
+double SpaceMesh::getSmallestStep() const {
+  double smallestStep = positions.back() - positions.front();
+  for (int j = 0; j + 1 < getNumberOfPoints(); j++) {
+    smallestStep = std::min(smallestStep, getStep(j));
+  }
+  return smallestStep;
+};
+
+double SpaceMesh::getLargestStep() const {
+  double largestStep = 0;
+  for (int j = 0; j + 1 < getNumberOfPoints(); j++) {
+    largestStep = std::max(largestStep, getStep(j));
+  }
+  return largestStep;
+};
+
+const double *SpaceMesh::getLowerCoefficients() const {
+  return lowerCoefficients.data();
+};
+
+const double *SpaceMesh::getUpperCoefficients() const {
+  return upperCoefficients.data();
+};
+
+SpaceMesh SpaceMesh::halved() const {
+  int numberOfPoints = getNumberOfPoints();
+  std::vector<double> halvedPositions(2 * numberOfPoints - 1);
+  for (int j = 0; j < numberOfPoints - 1; j++) {
+    halvedPositions[2 * j] = positions[j];
+    halvedPositions[2 * j + 1] = (positions[j] + positions[j + 1]) / 2;
+  }
+  halvedPositions[2 * numberOfPoints - 2] = positions.back();
+  return SpaceMesh(halvedPositions);
+}
+
+void SpaceMesh::interpolate(const SpaceMesh &source, const double *values,
+                            double *result) const {
+  const std::vector<double> &sourcePositions = source.positions;
+  int lastSourceStep = source.getNumberOfPoints() - 2;
+  // Both meshes are sorted : the step of source containing x only moves
+  // forward
+  int k = 0;
+  for (int j = 0; j < getNumberOfPoints(); j++) {
+    double x = positions[j];
+    while (k < lastSourceStep && sourcePositions[k + 1] < x) {
+      k++;
+    }
+    double weight = (x - sourcePositions[k]) /
+                    (sourcePositions[k + 1] - sourcePositions[k]);
+    weight = std::min(1., std::max(0., weight));
+    result[j] = (1 - weight) * values[k] + weight * values[k + 1];
+  }
+};
+
+bool SpaceMesh::operator==(const SpaceMesh &other) const {
+  return positions == other.positions;
+};
+
+bool SpaceMesh::operator!=(const SpaceMesh &other) const {
+  return !(*this == other);
+};
+
+/*=========== REFINEMENT ===============*/
+
+MeshRefinement::MeshRefinement(){};
+
+MeshRefinement::MeshRefinement(double pmaximumJump, double psmallestStep,
+                               double plargestStep,
+                               int pstepsBetweenRefinements)
+    : maximumJump(pmaximumJump), smallestStep(psmallestStep),
+      largestStep(plargestStep),
+      stepsBetweenRefinements(pstepsBetweenRefinements) {
+  if (maximumJump <= 0 || stepsBetweenRefinements <= 0 || smallestStep <= 0 ||
+      largestStep < smallestStep) {
+    throw(std::invalid_argument(
+        "the refinement needs a positive maximum jump and number of steps, "
+        "and 0 < smallestStep <= largestStep"));
+  }
+};
+
+bool MeshRefinement::isEnabled() const { return stepsBetweenRefinements > 0; };
+
+bool MeshRefinement::isDue(int timeIndex) const {
+  return isEnabled() && timeIndex % stepsBetweenRefinements == 0;
+};
+
+SpaceMesh MeshRefinement::refine(const SpaceMesh &mesh,
+                                 const double *temperatures) const {
+  if (!isEnabled()) {
+    return mesh;
+  }
+  int numberOfPoints = mesh.getNumberOfPoints();
+  const double *positions = mesh.getPositions();
+
+  // Coarsening : points kept, with their temperatures
+  std::vector<double> keptPositions, keptTemperatures;
+  keptPositions.push_back(positions[0]);
+  keptTemperatures.push_back(temperatures[0]);
+  bool previousRemoved = false;
+  for (int j = 1; j < numberOfPoints - 1; j++) {
+    double jumps = fabs(temperatures[j] - temperatures[j - 1]) +
+                   fabs(temperatures[j + 1] - temperatures[j]);
+    double mergedStep = positions[j + 1] - keptPositions.back();
+    int numberOfKept = keptPositions.size();
+    bool graded =
+        (numberOfKept < 2 ||
+         mergedStep <= 2 * (keptPositions.back() -
+                            keptPositions[numberOfKept - 2])) &&
+        (j + 2 >= numberOfPoints ||
+         mergedStep <= 2 * (positions[j + 2] - positions[j + 1]));
+    bool removed = !previousRemoved && jumps < maximumJump / 4 &&
+                   mergedStep <= largestStep && graded;
+    if (!removed) {
+      keptPositions.push_back(positions[j]);
+      keptTemperatures.push_back(temperatures[j]);
+    }
+    previousRemoved = removed;
+  }
+  keptPositions.push_back(positions[numberOfPoints - 1]);
+  keptTemperatures.push_back(temperatures[numberOfPoints - 1]);
+
+  // Refinement : each step is split in 2^k steps
+  std::vector<double> newPositions;
+  for (std::size_t j = 0; j + 1 < keptPositions.size(); j++) {
+    newPositions.push_back(keptPositions[j]);
+    double step = keptPositions[j + 1] - keptPositions[j];
+    double jump = fabs(keptTemperatures[j + 1] - keptTemperatures[j]);
+    int numberOfParts = 1;
+    while (jump / numberOfParts > maximumJump &&
+           step / (2 * numberOfParts) >= smallestStep) {
+      numberOfParts *= 2;
+    }
+    for (int part = 1; part < numberOfParts; part++) {
+      newPositions.push_back(keptPositions[j] + part * step / numberOfParts);
+    }
+  }
+  newPositions.push_back(keptPositions.back());
+
+  // Grading : steps more than twice as large as a neighbour are split until
+  // there is none left
+  bool split = true;
+  while (split) {
+    split = false;
+    std::vector<double> gradedPositions(1, newPositions[0]);
+    int lastStep = newPositions.size() - 2;
+    for (int j = 0; j <= lastStep; j++) {
+      double step = newPositions[j + 1] - newPositions[j];
+      if ((j > 0 && step > 2 * (newPositions[j] - newPositions[j - 1])) ||
+          (j < lastStep &&
+           step > 2 * (newPositions[j + 2] - newPositions[j + 1]))) {
+        gradedPositions.push_back(newPositions[j] + step / 2);
+        split = true;
+      }
+      gradedPositions.push_back(newPositions[j + 1]);
+    }
+    newPositions.swap(gradedPositions);
+  }
+
+  if (newPositions.size() == (std::size_t)numberOfPoints &&
+      std::equal(newPositions.begin(), newPositions.end(), positions)) {
+    return mesh;
+  }
+  return SpaceMesh(newPositions);
+}
@@ -0,0 +1,179 @@
+#pragma once // Include guard
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Points of the wall where the temperatures are computed, not
+ * necessarily evenly spaced
+ *
+ * The second derivative at an inner point j is approximated on the three
+ * points j-1, j, j+1 :
+ * d2T/dx2 = lower(j) T(j-1) - (lower(j) + upper(j)) T(j) + upper(j) T(j+1)
+ * with lower(j) = 2 / (h(j-1) (h(j-1) + h(j))), upper(j) = 2 / (h(j)
+ * (h(j-1) + h(j))) and h(j) = x(j+1) - x(j). On an evenly spaced mesh both
+ * coefficients are 1 / deltaX^2, which gives the usual schemes.
+ */
+class SpaceMesh {
+public:
+  /**
+   * @brief Empty mesh
+   *
+   */
+  SpaceMesh();
+
+  /**
+   * @brief Mesh made of the given points
+   *
+   * Can throw an invalid_argument exception if there are less than 3 points
+   * or if they are not strictly increasing
+   *
+   * @param positions : abscissa of the points, the first and the last ones
+   * being the surfaces of the wall
+   */
+  explicit SpaceMesh(const std::vector<double> &positions);
+
+  /**
+   * @brief Evenly spaced mesh, with the points of the regular meshes of the
+   * solvers : x(j) = j deltaX for j <= width / deltaX
+   *
+   * Can throw an invalid_argument exception if width or deltaX is not
+   * positive
+   */
+  static SpaceMesh uniform(double width, double deltaX);
+
+  /**
+   * @brief Mesh refined near both surfaces : the steps grow geometrically
+   * from smallestStep at the surfaces to at most largestStep, and the mesh is
+   * symmetric about the middle of the wall. The steps of each half are scaled
+   * so that it ends exactly in the middle, so the smallest step can be
+   * slightly below smallestStep.
+   *
+   * Can throw an invalid_argument exception if width is not positive, if
+   * 0 < smallestStep <= largestStep does not hold or if growthRate < 1
+   *
+   * @param width : width of the wall
+   * @param smallestStep : step at the surfaces
+   * @param growthRate : ratio between two successive steps
+   * @param largestStep : largest step, in the middle of the wall
+   */
+  static SpaceMesh graded(double width, double smallestStep,
+                          double growthRate, double largestStep);
+
+  int getNumberOfPoints() const;
+
+  double getPosition(int j) const;
+
+  const double *getPositions() const;
+
+  /**
+   * @brief Step after point j : x(j+1) - x(j)
+   *
+   */
+  double getStep(int j) const;
+
+  double getSmallestStep() const;
+
+  double getLargestStep() const;
+
+  /**
+   * @brief Coefficients of T(j-1) and T(j+1) in the second derivative at
+   * each point (see the class description), 0 at the surfaces
+   *
+   */
+  const double *getLowerCoefficients() const;
+  const double *getUpperCoefficients() const;
+
+  /**
+   * @brief Mesh with every step split in two : point j of this mesh is point
+   * 2j of the result. Used for Richardson's extrapolation in space and time.
+   *
+   */
+  SpaceMesh halved() const;
+
+  /**
+   * @brief Linear interpolation on the points of this mesh of values given
+   * on the points of another mesh covering the same wall
+   *
+   * @param source : mesh of the values
+   * @param values : one value per point of source
+   * @param result : where to store one value per point of this mesh
+   */
+  void interpolate(const SpaceMesh &source, const double *values,
+                   double *result) const;
+
+  bool operator==(const SpaceMesh &other) const;
+  bool operator!=(const SpaceMesh &other) const;
+
+private:
+  std::vector<double> positions;
+  std::vector<double> lowerCoefficients;
+  std::vector<double> upperCoefficients;
+};
+
+/**
+ * @brief Function receiving each time step of a solve on a SpaceMesh : (time
+ * index, mesh of the time step, temperatures at its points). The mesh and the
+ * temperatures are only valid during the call.
+ *
+ */
+typedef std::function<void(int, const SpaceMesh &, const double *)>
+    MeshRowSink;
+
+/**
+ * @brief Settings of the refinement and coarsening of a mesh during a solve,
+ * driven by the jumps of temperature between neighbouring points
+ *
+ * Every stepsBetweenRefinements time steps :
+ * - an inner point is removed if the jumps on both of its sides add up to
+ *   less than maximumJump / 4, if the merged step stays below largestStep and
+ *   at most twice as large as the steps around it (two neighbouring points
+ *   are never removed at once)
+ * - a step with a jump above maximumJump is split in 2^k steps, k being the
+ *   smallest number giving jumps below maximumJump (the temperatures are
+ *   interpolated linearly), as long as the steps stay above smallestStep
+ * - the steps more than twice as large as a neighbouring step are split in
+ *   two until there is none left, so that the mesh stays graded
+ * The temperatures are then interpolated on the new mesh. The margin between
+ * maximumJump / 4 and maximumJump keeps a point from being added and removed
+ * again at the next refinement.
+ */
+class MeshRefinement {
+public:
+  /**
+   * @brief No refinement : the mesh stays the same
+   *
+   */
+  MeshRefinement();
+
+  /**
+   * @brief Can throw an invalid_argument exception if maximumJump or
+   * stepsBetweenRefinements is not positive or if
+   * 0 < smallestStep <= largestStep does not hold
+   *
+   */
+  MeshRefinement(double maximumJump, double smallestStep, double largestStep,
+                 int stepsBetweenRefinements);
+
+  bool isEnabled() const;
+
+  /**
+   * @brief Whether the mesh should be adapted after time step timeIndex
+   *
+   */
+  bool isDue(int timeIndex) const;
+
+  /**
+   * @brief Mesh adapted to the temperatures (see the class description)
+   *
+   * @param mesh : current mesh
+   * @param temperatures : temperatures at the points of mesh
+   * @return SpaceMesh : the new mesh, equal to mesh if nothing changed
+   */
+  SpaceMesh refine(const SpaceMesh &mesh, const double *temperatures) const;
+
+private:
+  double maximumJump = 0;
+  double smallestStep = 0;
+  double largestStep = 0;
+  int stepsBetweenRefinements = 0;
+};
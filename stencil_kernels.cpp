@@ -0,0 +1,176 @@
+#include "stencil_kernels.h"
+#include "simd_dispatch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// The vectorized versions apply exactly the same operations in the same order
+// as the scalar one, and no fused multiply-add is used, so that all the
+// versions give bit-identical results.
+
+namespace stencil {
+
+namespace {
+
+void richardsonRowScalar(const double *Tn, const double *Tnm1, double *Tnp1,
+                         int first, int last, double r) {
+  for (int j = first; j < last; j++) {
+    Tnp1[j] = Tnm1[j] + r * (Tn[j + 1] - 2 * Tn[j] + Tn[j - 1]);
+  }
+}
+
+void dufortFrankelRowScalar(const double *Tn, const double *Tnm1, double *Tnp1,
+                            int first, int last, double r) {
+  double denominator = 1 + r;
+  for (int j = first; j < last; j++) {
+    Tnp1[j] = (Tnm1[j] + r * (Tn[j + 1] - Tnm1[j] + Tn[j - 1])) / denominator;
+  }
+}
+
+#ifdef HEAT_SIMD_X86
+__attribute__((target("sse2"))) void
+richardsonRowSSE2(const double *Tn, const double *Tnm1, double *Tnp1,
+                  int first, int last, double r) {
+  const __m128d vr = _mm_set1_pd(r);
+  const __m128d two = _mm_set1_pd(2);
+  int j = first;
+  for (; j + 2 <= last; j += 2) {
+    __m128d laplacian =
+        _mm_add_pd(_mm_sub_pd(_mm_loadu_pd(Tn + j + 1),
+                              _mm_mul_pd(two, _mm_loadu_pd(Tn + j))),
+                   _mm_loadu_pd(Tn + j - 1));
+    _mm_storeu_pd(Tnp1 + j, _mm_add_pd(_mm_loadu_pd(Tnm1 + j),
+                                       _mm_mul_pd(vr, laplacian)));
+  }
+  richardsonRowScalar(Tn, Tnm1, Tnp1, j, last, r);
+}
+
+__attribute__((target("sse2"))) void
+dufortFrankelRowSSE2(const double *Tn, const double *Tnm1, double *Tnp1,
+                     int first, int last, double r) {
+  const __m128d vr = _mm_set1_pd(r);
+  const __m128d denominator = _mm_set1_pd(1 + r);
+  int j = first;
+  for (; j + 2 <= last; j += 2) {
+    __m128d before = _mm_loadu_pd(Tnm1 + j);
+    __m128d sum = _mm_add_pd(_mm_sub_pd(_mm_loadu_pd(Tn + j + 1), before),
+                             _mm_loadu_pd(Tn + j - 1));
+    _mm_storeu_pd(Tnp1 + j,
+                  _mm_div_pd(_mm_add_pd(before, _mm_mul_pd(vr, sum)),
+                             denominator));
+  }
+  dufortFrankelRowScalar(Tn, Tnm1, Tnp1, j, last, r);
+}
+
+__attribute__((target("avx2"))) void
+richardsonRowAVX2(const double *Tn, const double *Tnm1, double *Tnp1,
+                  int first, int last, double r) {
+  const __m256d vr = _mm256_set1_pd(r);
+  const __m256d two = _mm256_set1_pd(2);
+  int j = first;
+  for (; j + 4 <= last; j += 4) {
+    __m256d laplacian =
+        _mm256_add_pd(_mm256_sub_pd(_mm256_loadu_pd(Tn + j + 1),
+                                    _mm256_mul_pd(two, _mm256_loadu_pd(Tn + j))),
+                      _mm256_loadu_pd(Tn + j - 1));
+    _mm256_storeu_pd(Tnp1 + j, _mm256_add_pd(_mm256_loadu_pd(Tnm1 + j),
+                                             _mm256_mul_pd(vr, laplacian)));
+  }
+  richardsonRowScalar(Tn, Tnm1, Tnp1, j, last, r);
+}
+
+__attribute__((target("avx2"))) void
+dufortFrankelRowAVX2(const double *Tn, const double *Tnm1, double *Tnp1,
+                     int first, int last, double r) {
+  const __m256d vr = _mm256_set1_pd(r);
+  const __m256d denominator = _mm256_set1_pd(1 + r);
+  int j = first;
+  for (; j + 4 <= last; j += 4) {
+    __m256d before = _mm256_loadu_pd(Tnm1 + j);
+    __m256d sum =
+        _mm256_add_pd(_mm256_sub_pd(_mm256_loadu_pd(Tn + j + 1), before),
+                      _mm256_loadu_pd(Tn + j - 1));
+    _mm256_storeu_pd(Tnp1 + j,
+                     _mm256_div_pd(_mm256_add_pd(before, _mm256_mul_pd(vr, sum)),
+                                   denominator));
+  }
+  dufortFrankelRowScalar(Tn, Tnm1, Tnp1, j, last, r);
+}
+#endif
+
+} // namespace
+
+void richardsonRow(const double *previousTimeStep,
+                   const double *beforePreviousTimeStep,
+                   double *TSolutionAtOneTime, int firstSpaceStep,
+                   int lastSpaceStep, double r) {
+  switch (simd::activeInstructionSet()) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    richardsonRowAVX2(previousTimeStep, beforePreviousTimeStep,
+                      TSolutionAtOneTime, firstSpaceStep, lastSpaceStep, r);
+    break;
+  case simd::SSE2:
+    richardsonRowSSE2(previousTimeStep, beforePreviousTimeStep,
+                      TSolutionAtOneTime, firstSpaceStep, lastSpaceStep, r);
+    break;
+#endif
+  default:
+    richardsonRowScalar(previousTimeStep, beforePreviousTimeStep,
+                        TSolutionAtOneTime, firstSpaceStep, lastSpaceStep, r);
+  }
+}
+
+void dufortFrankelRow(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep,
+                      double *TSolutionAtOneTime, int firstSpaceStep,
+                      int lastSpaceStep, double r) {
+  switch (simd::activeInstructionSet()) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    dufortFrankelRowAVX2(previousTimeStep, beforePreviousTimeStep,
+                         TSolutionAtOneTime, firstSpaceStep, lastSpaceStep, r);
+    break;
+  case simd::SSE2:
+    dufortFrankelRowSSE2(previousTimeStep, beforePreviousTimeStep,
+                         TSolutionAtOneTime, firstSpaceStep, lastSpaceStep, r);
+    break;
+#endif
+  default:
+    dufortFrankelRowScalar(previousTimeStep, beforePreviousTimeStep,
+                           TSolutionAtOneTime, firstSpaceStep, lastSpaceStep,
+                           r);
+  }
+}
+
+// The mesh kernels are only used on the graded meshes, which have far less
+// points than the regular ones : they are left to the compiler
+
+void richardsonMeshRow(const double *Tn, const double *Tnm1, double *Tnp1,
+                       const double *lower, const double *upper, int first,
+                       int last, double diffusivityDeltaT) {
+  double twoDiffusivityDeltaT = 2 * diffusivityDeltaT;
+  for (int j = first; j < last; j++) {
+    Tnp1[j] = Tnm1[j] + twoDiffusivityDeltaT *
+                            (lower[j] * Tn[j - 1] -
+                             (lower[j] + upper[j]) * Tn[j] +
+                             upper[j] * Tn[j + 1]);
+  }
+}
+
+void dufortFrankelMeshRow(const double *Tn, const double *Tnm1, double *Tnp1,
+                          const double *lower, const double *upper, int first,
+                          int last, double diffusivityDeltaT) {
+  double twoDiffusivityDeltaT = 2 * diffusivityDeltaT;
+  for (int j = first; j < last; j++) {
+    double s = diffusivityDeltaT * (lower[j] + upper[j]);
+    Tnp1[j] = ((1 - s) * Tnm1[j] +
+               twoDiffusivityDeltaT * (lower[j] * Tn[j - 1] +
+                                       upper[j] * Tn[j + 1])) /
+              (1 + s);
+  }
+}
+
+} // namespace stencil
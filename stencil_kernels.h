@@ -0,0 +1,155 @@
+#pragma once // Include guard
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Row kernels of the three-level explicit schemes
+ * Each kernel computes the points [firstSpaceStep, lastSpaceStep) of a new
+ * time step from the two previous ones. The vectorized version used is chosen
+ * at runtime (see simd_dispatch.h); all versions give bit-identical results.
+ *
+ */
+namespace stencil {
+
+/**
+ * @brief Richardson scheme :
+ * T(n+1,j) = T(n-1,j) + r (T(n,j+1) - 2 T(n,j) + T(n,j-1))
+ *
+ * @param previousTimeStep : temperatures at time step n
+ * @param beforePreviousTimeStep : temperatures at time step n-1
+ * @param TSolutionAtOneTime : where to store the temperatures at time step n+1
+ * @param firstSpaceStep : first point to compute
+ * @param lastSpaceStep : point after the last one to compute
+ * @param r : 2 * diffusivity * deltaT / deltaX^2
+ */
+void richardsonRow(const double *previousTimeStep,
+                   const double *beforePreviousTimeStep,
+                   double *TSolutionAtOneTime, int firstSpaceStep,
+                   int lastSpaceStep, double r);
+
+/**
+ * @brief DuFort-Frankel scheme :
+ * T(n+1,j) = (T(n-1,j) + r (T(n,j+1) - T(n-1,j) + T(n,j-1))) / (1 + r)
+ *
+ * @param previousTimeStep : temperatures at time step n
+ * @param beforePreviousTimeStep : temperatures at time step n-1
+ * @param TSolutionAtOneTime : where to store the temperatures at time step n+1
+ * @param firstSpaceStep : first point to compute
+ * @param lastSpaceStep : point after the last one to compute
+ * @param r : 2 * diffusivity * deltaT / deltaX^2
+ */
+void dufortFrankelRow(const double *previousTimeStep,
+                      const double *beforePreviousTimeStep,
+                      double *TSolutionAtOneTime, int firstSpaceStep,
+                      int lastSpaceStep, double r);
+
+/**
+ * @brief Richardson scheme on a mesh that is not evenly spaced (see
+ * SpaceMesh) :
+ * T(n+1,j) = T(n-1,j) + 2 D deltaT (lower(j) T(n,j-1)
+ *            - (lower(j) + upper(j)) T(n,j) + upper(j) T(n,j+1))
+ *
+ * @param previousTimeStep : temperatures at time step n
+ * @param beforePreviousTimeStep : temperatures at time step n-1
+ * @param TSolutionAtOneTime : where to store the temperatures at time step n+1
+ * @param lowerCoefficients : coefficients of T(j-1) of the mesh
+ * @param upperCoefficients : coefficients of T(j+1) of the mesh
+ * @param firstSpaceStep : first point to compute
+ * @param lastSpaceStep : point after the last one to compute
+ * @param diffusivityDeltaT : diffusivity * deltaT
+ */
+void richardsonMeshRow(const double *previousTimeStep,
+                       const double *beforePreviousTimeStep,
+                       double *TSolutionAtOneTime,
+                       const double *lowerCoefficients,
+                       const double *upperCoefficients, int firstSpaceStep,
+                       int lastSpaceStep, double diffusivityDeltaT);
+
+/**
+ * @brief DuFort-Frankel scheme on a mesh that is not evenly spaced : the
+ * Richardson scheme with 2 T(n,j) replaced by T(n+1,j) + T(n-1,j), which
+ * gives with s(j) = D deltaT (lower(j) + upper(j)) :
+ * T(n+1,j) = ((1 - s(j)) T(n-1,j) + 2 D deltaT (lower(j) T(n,j-1)
+ *            + upper(j) T(n,j+1))) / (1 + s(j))
+ *
+ * @param previousTimeStep : temperatures at time step n
+ * @param beforePreviousTimeStep : temperatures at time step n-1
+ * @param TSolutionAtOneTime : where to store the temperatures at time step n+1
+ * @param lowerCoefficients : coefficients of T(j-1) of the mesh
+ * @param upperCoefficients : coefficients of T(j+1) of the mesh
+ * @param firstSpaceStep : first point to compute
+ * @param lastSpaceStep : point after the last one to compute
+ * @param diffusivityDeltaT : diffusivity * deltaT
+ */
+void dufortFrankelMeshRow(const double *previousTimeStep,
+                          const double *beforePreviousTimeStep,
+                          double *TSolutionAtOneTime,
+                          const double *lowerCoefficients,
+                          const double *upperCoefficients, int firstSpaceStep,
+                          int lastSpaceStep, double diffusivityDeltaT);
+
+/**
+ * @brief Rows shorter than this number of points are better computed by the
+ * inline kernels below : the call of a dispatched kernel then costs more than
+ * the few points it computes
+ *
+ */
+const int SHORT_ROW_LENGTH = 512;
+
+/**
+ * @brief Inline version of richardsonRow for short rows, vectorized with the
+ * SSE2 instructions when the compiler targets them. It gives the same results
+ * as richardsonRow.
+ *
+ */
+inline void richardsonShortRow(const double *Tn, const double *Tnm1,
+                               double *Tnp1, int first, int last, double r) {
+  int j = first;
+#if defined(__GNUC__) && defined(__SSE2__)
+  const __m128d vr = _mm_set1_pd(r);
+  const __m128d two = _mm_set1_pd(2);
+  for (; j + 2 <= last; j += 2) {
+    __m128d laplacian =
+        _mm_add_pd(_mm_sub_pd(_mm_loadu_pd(Tn + j + 1),
+                              _mm_mul_pd(two, _mm_loadu_pd(Tn + j))),
+                   _mm_loadu_pd(Tn + j - 1));
+    _mm_storeu_pd(Tnp1 + j, _mm_add_pd(_mm_loadu_pd(Tnm1 + j),
+                                       _mm_mul_pd(vr, laplacian)));
+  }
+#endif
+  for (; j < last; j++) {
+    Tnp1[j] = Tnm1[j] + r * (Tn[j + 1] - 2 * Tn[j] + Tn[j - 1]);
+  }
+}
+
+/**
+ * @brief Inline version of dufortFrankelRow for short rows, vectorized with
+ * the SSE2 instructions when the compiler targets them. It gives the same
+ * results as dufortFrankelRow.
+ *
+ */
+inline void dufortFrankelShortRow(const double *Tn, const double *Tnm1,
+                                  double *Tnp1, int first, int last,
+                                  double r) {
+  int j = first;
+#if defined(__GNUC__) && defined(__SSE2__)
+  const __m128d vr = _mm_set1_pd(r);
+  const __m128d vdenominator = _mm_set1_pd(1 + r);
+  for (; j + 2 <= last; j += 2) {
+    __m128d before = _mm_loadu_pd(Tnm1 + j);
+    __m128d sum = _mm_add_pd(_mm_sub_pd(_mm_loadu_pd(Tn + j + 1), before),
+                             _mm_loadu_pd(Tn + j - 1));
+    _mm_storeu_pd(Tnp1 + j,
+                  _mm_div_pd(_mm_add_pd(before, _mm_mul_pd(vr, sum)),
+                             vdenominator));
+  }
+#endif
+  double denominator = 1 + r;
+  for (; j < last; j++) {
+    Tnp1[j] = (Tnm1[j] + r * (Tn[j + 1] - Tnm1[j] + Tn[j - 1])) / denominator;
+  }
+}
+
+} // namespace stencil
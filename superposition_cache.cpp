@@ -0,0 +1,191 @@
+#include "superposition_cache.h"
+#include "instrumentation.h"
+#include "simd_dispatch.h"
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEAT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// As for the stencil kernels, the vectorized versions do the same operations
+// as the scalar one, without fused multiply-add, so that they all give
+// bit-identical results.
+
+void rescaleRowScalar(const double *normalized, double *temperatures,
+                      int numberOfPoints, double offset, double scale) {
+  for (int j = 0; j < numberOfPoints; j++) {
+    temperatures[j] = offset + scale * normalized[j];
+  }
+}
+
+#ifdef HEAT_SIMD_X86
+__attribute__((target("sse2"))) void
+rescaleRowSSE2(const double *normalized, double *temperatures,
+               int numberOfPoints, double offset, double scale) {
+  const __m128d voffset = _mm_set1_pd(offset);
+  const __m128d vscale = _mm_set1_pd(scale);
+  int j = 0;
+  for (; j + 2 <= numberOfPoints; j += 2) {
+    _mm_storeu_pd(temperatures + j,
+                  _mm_add_pd(voffset,
+                             _mm_mul_pd(vscale, _mm_loadu_pd(normalized + j))));
+  }
+  rescaleRowScalar(normalized + j, temperatures + j, numberOfPoints - j,
+                   offset, scale);
+}
+
+__attribute__((target("avx2"))) void
+rescaleRowAVX2(const double *normalized, double *temperatures,
+               int numberOfPoints, double offset, double scale) {
+  const __m256d voffset = _mm256_set1_pd(offset);
+  const __m256d vscale = _mm256_set1_pd(scale);
+  int j = 0;
+  for (; j + 4 <= numberOfPoints; j += 4) {
+    _mm256_storeu_pd(
+        temperatures + j,
+        _mm256_add_pd(voffset,
+                      _mm256_mul_pd(vscale, _mm256_loadu_pd(normalized + j))));
+  }
+  rescaleRowScalar(normalized + j, temperatures + j, numberOfPoints - j,
+                   offset, scale);
+}
+#endif
+
+/**
+ * @brief temperatures = offset + scale * normalized on numberOfPoints points,
+ * with the instruction set chosen by simd::activeInstructionSet()
+ */
+void rescaleRow(const double *normalized, double *temperatures,
+                int numberOfPoints, double offset, double scale) {
+  switch (simd::activeInstructionSet()) {
+#ifdef HEAT_SIMD_X86
+  case simd::AVX2:
+    rescaleRowAVX2(normalized, temperatures, numberOfPoints, offset, scale);
+    break;
+  case simd::SSE2:
+    rescaleRowSSE2(normalized, temperatures, numberOfPoints, offset, scale);
+    break;
+#endif
+  default:
+    rescaleRowScalar(normalized, temperatures, numberOfPoints, offset, scale);
+  }
+}
+
+} // namespace
+
+bool SuperpositionCache::Key::operator<(const Key &other) const {
+  return std::tie(solverConfiguration, diffusivity, width, timeStop, deltaX,
+                  deltaT) < std::tie(other.solverConfiguration,
+                                     other.diffusivity, other.width,
+                                     other.timeStop, other.deltaX,
+                                     other.deltaT);
+}
+
+SuperpositionCache::SuperpositionCache(int pmaximumNumberOfGrids)
+    : maximumNumberOfGrids(pmaximumNumberOfGrids) {
+  if (maximumNumberOfGrids <= 0) {
+    throw(std::invalid_argument(
+        "the cache should keep at least one normalized solution"));
+  }
+};
+
+bool SuperpositionCache::solve(AbstractSolver *solver,
+                               const HeatDiffusionParameters &parameters,
+                               double deltaX, double deltaT,
+                               SolutionGrid *solution) {
+  HEAT_TIMED_SCOPE("superposition.solve");
+  Key key = {(*solver).getConfigurationName(),
+             parameters.getDiffusivity(),
+             parameters.getWidth(),
+             parameters.getTimeStop(),
+             deltaX,
+             deltaT};
+  double surfaceTemperature = parameters.getSurfaceTemperature();
+  double internalTemperature = parameters.getInternalTemperature();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  std::map<Key, Entry>::iterator entry = entries.find(key);
+  if (entry != entries.end()) {
+    numberOfHits++;
+    HEAT_COUNT("superposition.hits", 1);
+    usageOrder.splice(usageOrder.end(), usageOrder, (*entry).second.usage);
+    Grid grid = (*entry).second.grid;
+    lock.unlock();
+    // Waits if another thread is still solving the normalized solution
+    rescale(*grid.get(), surfaceTemperature, internalTemperature, solution);
+    return true;
+  }
+  long long solveNumber = ++numberOfSolves;
+  HEAT_COUNT("superposition.solves", 1);
+  std::promise<std::shared_ptr<const SolutionGrid>> promise;
+  usageOrder.push_back(key);
+  Entry added = {promise.get_future().share(), --usageOrder.end(),
+                 solveNumber};
+  entries.insert(std::make_pair(key, added));
+  if ((int)usageOrder.size() > maximumNumberOfGrids) {
+    // The threads waiting for it keep their own copy of the grid
+    entries.erase(usageOrder.front());
+    usageOrder.pop_front();
+  }
+  lock.unlock();
+
+  try {
+    HeatDiffusionParameters normalizedParameters = parameters;
+    normalizedParameters.setSurfaceTemperature(0);
+    normalizedParameters.setInternalTemperature(1);
+    (*solver).setParameters(normalizedParameters);
+    std::shared_ptr<SolutionGrid> normalized(new SolutionGrid());
+    (*solver).solveRegularMeshes(deltaX, deltaT, normalized.get());
+    promise.set_value(normalized);
+    rescale(*normalized, surfaceTemperature, internalTemperature, solution);
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+    lock.lock();
+    // Unless it has been removed meanwhile, the entry is removed so that the
+    // next call solves again
+    entry = entries.find(key);
+    if (entry != entries.end() && (*entry).second.solve == solveNumber) {
+      usageOrder.erase((*entry).second.usage);
+      entries.erase(entry);
+    }
+    throw;
+  }
+  return false;
+}
+
+void SuperpositionCache::rescale(const SolutionGrid &normalized,
+                                 double surfaceTemperature,
+                                 double internalTemperature,
+                                 SolutionGrid *solution) {
+  HEAT_TIMED_SCOPE("superposition.rescale");
+  int numberOfRows = normalized.getNumberOfRows();
+  int numberOfColumns = normalized.getNumberOfColumns();
+  (*solution).resize(numberOfRows, numberOfColumns);
+  double scale = internalTemperature - surfaceTemperature;
+  // Row by row : the padding of the rows stays at 0
+  for (int i = 0; i < numberOfRows; i++) {
+    rescaleRow(normalized.row(i), (*solution).row(i), numberOfColumns,
+               surfaceTemperature, scale);
+  }
+}
+
+void SuperpositionCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  usageOrder.clear();
+}
+
+long long SuperpositionCache::getNumberOfHits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfHits;
+}
+
+long long SuperpositionCache::getNumberOfSolves() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numberOfSolves;
+}
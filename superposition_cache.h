@@ -0,0 +1,133 @@
+#pragma once // Include guard
+#include "abstract_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "solution_grid.h"
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Solutions of problems differing only by their temperatures, computed
+ * from a single solve
+ *
+ * All the schemes are linear with constant boundary conditions, so the
+ * solution is affine in the surface and internal temperatures :
+ * T = Tsur + (Tin - Tsur) T*
+ * where T* is the normalized solution, with Tsur = 0 and Tin = 1. The cache
+ * keeps T* for each solver configuration, diffusivity, width, time limit,
+ * deltaX and deltaT, and computes the solution for any temperatures by
+ * rescaling it, one multiplication and one addition per point.
+ *
+ * The rescaled solution is equal to a direct solve up to the rounding errors
+ * accumulated over the time steps, not bit-identical. An analytical solver
+ * with a tolerance (see ExactSolver::setTolerance) cuts the series of the
+ * normalized solution for a temperature difference of 1 : the error of the
+ * rescaled solution is then below tolerance * |Tin - Tsur|.
+ *
+ * The cache can be used by several threads at once : when several threads
+ * need a normalized solution that is not computed yet, only the first one
+ * solves it. At most maximumNumberOfGrids normalized solutions are kept, the
+ * least recently used one being removed first.
+ */
+class SuperpositionCache {
+public:
+  static const int DEFAULT_MAXIMUM_NUMBER_OF_GRIDS = 16;
+
+  /**
+   * @brief Construct a new Superposition Cache object
+   *
+   * Can throw an invalid_argument exception if maximumNumberOfGrids is not
+   * positive
+   *
+   * @param maximumNumberOfGrids : number of normalized solutions kept
+   */
+  explicit SuperpositionCache(
+      int maximumNumberOfGrids = DEFAULT_MAXIMUM_NUMBER_OF_GRIDS);
+
+  /**
+   * @brief Solution of a problem with solver, rescaled from the normalized
+   * solution, which is solved first if it is not in the cache. The
+   * parameters of solver are then the normalized ones.
+   *
+   * Can throw the exceptions of the solver
+   *
+   * @param solver : solver of the problem, with its settings
+   * @param parameters : parameters of the problem
+   * @param deltaX : size of the space step
+   * @param deltaT : size of the time step
+   * @param solution : grid where the solution is stored
+   * @return true if the normalized solution was in the cache
+   */
+  bool solve(AbstractSolver *solver, const HeatDiffusionParameters &parameters,
+             double deltaX, double deltaT, SolutionGrid *solution);
+
+  /**
+   * @brief Compute solution = surfaceTemperature + (internalTemperature -
+   * surfaceTemperature) * normalized on each point
+   *
+   */
+  static void rescale(const SolutionGrid &normalized,
+                      double surfaceTemperature, double internalTemperature,
+                      SolutionGrid *solution);
+
+  /**
+   * @brief Remove all the normalized solutions
+   *
+   */
+  void clear();
+
+  /**
+   * @brief Number of solutions rescaled from a cached normalized solution,
+   * and of normalized solutions solved
+   *
+   */
+  long long getNumberOfHits() const;
+  long long getNumberOfSolves() const;
+
+private:
+  /**
+   * @brief Everything the normalized solution depends on
+   *
+   */
+  struct Key {
+    /**
+     * @brief AbstractSolver::getConfigurationName() of the solver
+     *
+     */
+    std::string solverConfiguration;
+    double diffusivity;
+    double width;
+    double timeStop;
+    double deltaX;
+    double deltaT;
+
+    bool operator<(const Key &other) const;
+  };
+
+  typedef std::shared_future<std::shared_ptr<const SolutionGrid>> Grid;
+
+  /**
+   * @brief Normalized solution, being solved or solved, with its position in
+   * usageOrder and the number of the solve that added it
+   *
+   */
+  struct Entry {
+    Grid grid;
+    std::list<Key>::iterator usage;
+    long long solve;
+  };
+
+  int maximumNumberOfGrids;
+  mutable std::mutex mutex;
+  std::map<Key, Entry> entries;
+  /**
+   * @brief Keys from the least to the most recently used
+   *
+   */
+  std::list<Key> usageOrder;
+  long long numberOfHits = 0;
+  long long numberOfSolves = 0;
+};
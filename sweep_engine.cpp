@@ -0,0 +1,113 @@
+#include "sweep_engine.h"
+#include "crank-nicholson_solver.h"
+#include "dufort-frankel_solver.h"
+#include "exact_solver.h"
+#include "explicit_solver.h"
+#include "first_step_cache.h"
+#include "instrumentation.h"
+#include "laasonen_simple_implicit_solver.h"
+#include "richardson_solver.h"
+#include <chrono>
+#include <stdexcept>
+
+SweepEngine::SweepEngine(int numberOfThreads)
+    : pool(numberOfThreads), solversPerThread(pool.getNumberOfThreads()){};
+
+int SweepEngine::getNumberOfThreads() const {
+  return pool.getNumberOfThreads();
+};
+
+std::unique_ptr<AbstractSolver>
+SweepEngine::createSolver(const std::string &schemeName) {
+  if (schemeName == "Analytical") {
+    return std::unique_ptr<AbstractSolver>(new ExactSolver());
+  } else if (schemeName == "Laasonen") {
+    return std::unique_ptr<AbstractSolver>(new LaasonenSolver());
+  } else if (schemeName == "Crank-Nicholson") {
+    return std::unique_ptr<AbstractSolver>(new CrankNicholsonSolver());
+  } else if (schemeName == "Richardson") {
+    return std::unique_ptr<AbstractSolver>(new RichardsonSolver());
+  } else if (schemeName == "Dufort-Frankel") {
+    return std::unique_ptr<AbstractSolver>(new DufortFrankelSolver());
+  }
+  throw(std::invalid_argument("unknown scheme : " + schemeName));
+};
+
+AbstractSolver *SweepEngine::getSolver(
+    std::map<std::string, std::unique_ptr<AbstractSolver>> *solvers,
+    const std::string &schemeName) {
+  std::unique_ptr<AbstractSolver> &solver = (*solvers)[schemeName];
+  if (!solver) {
+    solver = createSolver(schemeName);
+  }
+  return solver.get();
+}
+
+void SweepEngine::solve(const SweepJob &job, ThreadSolvers *threadSolvers,
+                        ResultCache *resultCache,
+                        SuperpositionCache *superpositionCache,
+                        SweepResult *result) {
+  HEAT_TIMED_SCOPE("sweep.job");
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  AbstractSolver *solver =
+      getSolver(&(*threadSolvers).solvers, job.schemeName);
+  ExplicitSolver *explicitSolver = dynamic_cast<ExplicitSolver *>(solver);
+  if (explicitSolver) {
+    (*explicitSolver)
+        .setFirstStepSolver(getSolver(&(*threadSolvers).firstStepSolvers,
+                                      job.firstStepSchemeName),
+                            job.firstStepWithRichardsonsExtrapolation);
+    (*explicitSolver).setFirstStepCache(&FirstStepCache::shared());
+  }
+  (*solver).setParameters(job.parameters);
+  std::string key;
+  if (resultCache) {
+    // The key holds the first step solver of a three-level scheme
+    key = ResultCache::keyOf(*solver, job.parameters, job.deltaX, job.deltaT);
+    if ((*resultCache).load(key, job.deltaX, job.deltaT,
+                            &(*result).solution)) {
+      (*result).fromCache = true;
+      (*result).seconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+      return;
+    }
+  }
+  if (superpositionCache) {
+    (*result).fromCache =
+        (*superpositionCache)
+            .solve(solver, job.parameters, job.deltaX, job.deltaT,
+                   &(*result).solution);
+    if (!(*result).fromCache) {
+      (*result).stepsPerSecond = (*solver).getStepsPerSecond();
+    }
+  } else {
+    (*solver).solveRegularMeshes(job.deltaX, job.deltaT, &(*result).solution);
+    (*result).stepsPerSecond = (*solver).getStepsPerSecond();
+  }
+  // Only the direct solves are stored, the rescaled solutions are not exactly
+  // the same
+  if (resultCache && !superpositionCache) {
+    (*resultCache)
+        .store(key, job.schemeName, (*result).solution, job.deltaX, job.deltaT);
+  }
+  (*result).seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+}
+
+std::vector<SweepResult> SweepEngine::run(const std::vector<SweepJob> &jobs) {
+  std::vector<SweepResult> results(jobs.size());
+  pool.run(jobs.size(), [&](int thread, int job) {
+    solve(jobs[job], &solversPerThread[thread], resultCache,
+          superpositionCache, &results[job]);
+  });
+  return results;
+};
+
+void SweepEngine::setResultCache(ResultCache *cache) { resultCache = cache; };
+
+void SweepEngine::setSuperpositionCache(SuperpositionCache *cache) {
+  superpositionCache = cache;
+};
@@ -0,0 +1,168 @@
+#pragma once // Include guard
+#include "abstract_solver.h"
+#include "heat_diffusion_parameters.h"
+#include "result_cache.h"
+#include "solution_grid.h"
+#include "superposition_cache.h"
+#include "work_stealing_pool.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One solve of a parameter sweep
+ *
+ */
+struct SweepJob {
+  /**
+   * @brief name of the scheme, as given by AbstractSolver::getSchemeName()
+   *
+   */
+  std::string schemeName;
+  HeatDiffusionParameters parameters;
+  double deltaX;
+  double deltaT;
+  /**
+   * @brief name of the scheme computing the first step of a three-level
+   * scheme, and whether it uses a Richardson's extrapolation. Ignored for
+   * the other schemes.
+   *
+   */
+  std::string firstStepSchemeName;
+  bool firstStepWithRichardsonsExtrapolation;
+
+  SweepJob(const std::string &pschemeName,
+           const HeatDiffusionParameters &pparameters, double pdeltaX,
+           double pdeltaT, const std::string &pfirstStepSchemeName = "Laasonen",
+           bool pfirstStepWithRichardsonsExtrapolation = true)
+      : schemeName(pschemeName), parameters(pparameters), deltaX(pdeltaX),
+        deltaT(pdeltaT), firstStepSchemeName(pfirstStepSchemeName),
+        firstStepWithRichardsonsExtrapolation(
+            pfirstStepWithRichardsonsExtrapolation){};
+};
+
+/**
+ * @brief Result of a SweepJob
+ *
+ */
+struct SweepResult {
+  SolutionGrid solution;
+  /**
+   * @brief time steps computed per second (see
+   * AbstractSolver::getStepsPerSecond)
+   *
+   */
+  double stepsPerSecond = 0;
+  /**
+   * @brief whether the solution has been loaded from the ResultCache or
+   * rescaled from a normalized solution of the SuperpositionCache instead of
+   * being solved (stepsPerSecond is then 0)
+   *
+   */
+  bool fromCache = false;
+  /**
+   * @brief time spent on the job, in seconds
+   *
+   */
+  double seconds = 0;
+};
+
+/**
+ * @brief Run a list of independent solves on a WorkStealingPool
+ *
+ * Solvers keep the state of the problem being solved, so each thread of the
+ * pool has its own solver of each scheme. The results are stored in the
+ * order of the jobs and do not depend on the number of threads.
+ */
+class SweepEngine {
+public:
+  /**
+   * @brief Construct a new Sweep Engine object
+   *
+   * @param numberOfThreads : number of threads solving the jobs. 0 means one
+   * per hardware thread.
+   */
+  explicit SweepEngine(int numberOfThreads = 0);
+
+  /**
+   * @brief Get the number of threads solving the jobs
+   *
+   */
+  int getNumberOfThreads() const;
+
+  /**
+   * @brief Solve all the jobs
+   *
+   * Can throw an invalid_argument exception if a scheme is unknown or if the
+   * parameters of a job are not initialized
+   *
+   * @param jobs : solves to run
+   * @return std::vector<SweepResult> : result of each job, in the same order
+   */
+  std::vector<SweepResult> run(const std::vector<SweepJob> &jobs);
+
+  /**
+   * @brief Set the cache where the solutions are looked up before being
+   * solved, and stored once solved. There is no cache by default.
+   *
+   * @param cache : cache to use, or nullptr to always solve
+   */
+  void setResultCache(ResultCache *cache);
+
+  /**
+   * @brief Set the cache computing the solutions from the normalized ones,
+   * so that the jobs differing only by their temperatures need one solve.
+   * The solutions are then only equal to the direct solves up to the
+   * rounding errors, and are not stored in the ResultCache. There is no
+   * cache by default.
+   *
+   * @param cache : cache to use, or nullptr to solve each job directly
+   */
+  void setSuperpositionCache(SuperpositionCache *cache);
+
+  /**
+   * @brief Create a solver from the name of its scheme ("Analytical",
+   * "Laasonen", "Crank-Nicholson", "Richardson" or "Dufort-Frankel")
+   *
+   * Can throw an invalid_argument exception if the scheme is unknown
+   */
+  static std::unique_ptr<AbstractSolver>
+  createSolver(const std::string &schemeName);
+
+private:
+  /**
+   * @brief Solvers owned by one thread, created when first needed
+   *
+   */
+  struct ThreadSolvers {
+    std::map<std::string, std::unique_ptr<AbstractSolver>> solvers;
+    /**
+     * @brief kept apart so that a scheme can compute its own first step
+     *
+     */
+    std::map<std::string, std::unique_ptr<AbstractSolver>> firstStepSolvers;
+  };
+
+  /**
+   * @brief Get the solver of a scheme in solvers, creating it if needed
+   *
+   */
+  static AbstractSolver *
+  getSolver(std::map<std::string, std::unique_ptr<AbstractSolver>> *solvers,
+            const std::string &schemeName);
+
+  /**
+   * @brief Solve a job with the solvers of a thread
+   *
+   */
+  static void solve(const SweepJob &job, ThreadSolvers *threadSolvers,
+                    ResultCache *resultCache,
+                    SuperpositionCache *superpositionCache,
+                    SweepResult *result);
+
+  WorkStealingPool pool;
+  ResultCache *resultCache = nullptr;
+  SuperpositionCache *superpositionCache = nullptr;
+  std::vector<ThreadSolvers> solversPerThread;
+};
@@ -0,0 +1,114 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+
+ThreadPool::ThreadPool(int numberOfThreads)
+    : busy(false), generation(0), stopping(false) {
+  if (numberOfThreads <= 0) {
+    numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 1; i < numberOfThreads; i++) {
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+  }
+};
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+};
+
+int ThreadPool::getNumberOfThreads() const { return (workers.size() + 1); };
+
+ThreadPool &ThreadPool::shared() {
+  // The size of the shared pool can be set with the HEAT_THREADS environment
+  // variable
+  static const char *requestedThreads = std::getenv("HEAT_THREADS");
+  static ThreadPool sharedPool(requestedThreads ? std::atoi(requestedThreads)
+                                                : 0);
+  return (sharedPool);
+};
+
+void ThreadPool::runIterations(Job &job) {
+  for (int i = job.nextIteration.fetch_add(1); i < job.end;
+       i = job.nextIteration.fetch_add(1)) {
+    try {
+      (*job.body)(i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!job.firstException) {
+        job.firstException = std::current_exception();
+      }
+    }
+    if (job.remainingIterations.fetch_sub(1) == 1) {
+      // Last iteration : waking up the thread waiting in parallelFor
+      std::lock_guard<std::mutex> lock(mutex);
+      workDone.notify_all();
+    }
+  }
+}
+
+void ThreadPool::workerLoop() {
+  unsigned long seenGeneration = 0;
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      workAvailable.wait(lock, [this, seenGeneration]() {
+        return stopping || generation != seenGeneration;
+      });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+      job = currentJob;
+    }
+    if (job) {
+      runIterations(*job);
+    }
+  }
+}
+
+void ThreadPool::parallelFor(int begin, int end,
+                             const std::function<void(int)> &body) {
+  bool wasBusy = false;
+  if (workers.empty() || end - begin <= 1 ||
+      !busy.compare_exchange_strong(wasBusy, true)) {
+    for (int i = begin; i < end; i++) {
+      body(i);
+    }
+    return;
+  }
+  std::shared_ptr<Job> job = std::make_shared<Job>();
+  job->body = &body;
+  job->end = end;
+  job->nextIteration.store(begin);
+  job->remainingIterations.store(end - begin);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentJob = job;
+    generation++;
+  }
+  workAvailable.notify_all();
+  runIterations(*job);
+  std::exception_ptr firstException;
+  {
+    // All the iterations have been taken, waiting for the ones still running
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock,
+                  [&job]() { return job->remainingIterations.load() == 0; });
+    currentJob.reset();
+    // Taken out of the job, which can be destroyed by a worker at any time
+    firstException = job->firstException;
+    job->firstException = nullptr;
+  }
+  busy.store(false);
+  if (firstException) {
+    std::rethrow_exception(firstException);
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once // Include guard
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads used to run the iterations of a loop in
+ * parallel
+ *
+ * The thread calling parallelFor takes part in the work, so a pool of N
+ * threads starts N-1 workers. Only one parallelFor runs on a pool at a time :
+ * a parallelFor called while the pool is busy (for example from inside
+ * another parallelFor) runs its iterations sequentially in the calling
+ * thread.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Construct a new Thread Pool object
+   *
+   * @param numberOfThreads : number of threads working on a parallelFor,
+   * including the calling thread. 0 means one per hardware thread.
+   */
+  explicit ThreadPool(int numberOfThreads = 0);
+
+  /**
+   * @brief Stop and join the workers
+   *
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Get the number of threads working on a parallelFor, including the
+   * calling thread
+   *
+   */
+  int getNumberOfThreads() const;
+
+  /**
+   * @brief Call body(i) for every i in [begin, end), spreading the
+   * iterations over the threads of the pool. Returns once all the iterations
+   * are done. If an iteration throws, the first exception is rethrown in the
+   * calling thread.
+   *
+   */
+  void parallelFor(int begin, int end, const std::function<void(int)> &body);
+
+  /**
+   * @brief Pool shared by the whole programm, with one thread per hardware
+   * thread unless the HEAT_THREADS environment variable gives another number
+   *
+   */
+  static ThreadPool &shared();
+
+private:
+  /**
+   * @brief Iterations of one parallelFor. Workers keep a reference on it so
+   * that a worker waking up late never touches the next parallelFor.
+   *
+   */
+  struct Job {
+    const std::function<void(int)> *body;
+    int end;
+    std::atomic<int> nextIteration;
+    std::atomic<int> remainingIterations;
+    std::exception_ptr firstException;
+  };
+
+  void workerLoop();
+  void runIterations(Job &job);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable workDone;
+  /**
+   * @brief Set during a whole parallelFor, to detect a busy pool. It is not a
+   * mutex : the calling thread of a parallelFor can itself call parallelFor
+   * from an iteration.
+   *
+   */
+  std::atomic<bool> busy;
+
+  std::shared_ptr<Job> currentJob;
+  /**
+   * @brief Incremented for each new parallelFor, to wake up the workers
+   *
+   */
+  unsigned long generation;
+  bool stopping;
+};
@@ -0,0 +1,44 @@
+/*! \file */
+
+#include "batch_runner.h"
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+/**
+ * @brief Run the studies described in a batch file (see readBatchFile) and
+ * write the run summary
+ *
+ * Usage : heat_batch <batch file>
+ *
+ */
+int main(int argc, const char **argv) {
+  if (argc != 2) {
+    std::cerr << "usage : " << argv[0] << " <batch file>" << std::endl;
+    return 1;
+  }
+  try {
+    BatchFile batch = readBatchFile(argv[1]);
+    BatchRunner runner(batch.settings);
+    BatchSummary summary = runner.run(batch.studies);
+
+    std::ofstream summaryFile(batch.settings.summaryFilename);
+    if (!summaryFile) {
+      std::cerr << "cannot write " << batch.settings.summaryFilename
+                << std::endl;
+      return 1;
+    }
+    writeBatchSummary(summaryFile, summary);
+    std::cout << batch.studies.size() << " studies : "
+              << summary.outputs.size() << " outputs, "
+              << summary.solves.size() << " solves ("
+              << summary.numberOfRequestedSolves << " requested), "
+              << summary.numberOfBatches << " groups, "
+              << summary.peakMemory << " bytes at most, " << summary.seconds
+              << " s" << std::endl;
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*! \file */
+
+#include "result_file.h"
+#include <exception>
+#include <iostream>
+
+/**
+ * @brief Convert binary result files (see result_file.h) to the CSV layout
+ * written by resultToFile
+ *
+ * Usage : result_to_csv <result file> <csv file> [<result file> <csv file>
+ * ...]
+ *
+ */
+int main(int argc, const char **argv) {
+  if (argc < 3 || argc % 2 == 0) {
+    std::cerr << "usage : " << argv[0]
+              << " <result file> <csv file> [<result file> <csv file> ...]"
+              << std::endl;
+    return 1;
+  }
+  try {
+    for (int i = 1; i + 1 < argc; i += 2) {
+      resultFileToCsv(argv[i], argv[i + 1]);
+    }
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int pnumberOfThreads)
+    : numberOfThreads(pnumberOfThreads), generation(0), stopping(false) {
+  if (numberOfThreads <= 0) {
+    numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int thread = 1; thread < numberOfThreads; thread++) {
+    workers.push_back(std::thread(&WorkStealingPool::workerLoop, this, thread));
+  }
+};
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  workAvailable.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+};
+
+int WorkStealingPool::getNumberOfThreads() const { return numberOfThreads; };
+
+bool WorkStealingPool::takeTask(Job &job, int thread, int *task) {
+  {
+    TaskQueue &ownQueue = *job.queues[thread];
+    std::lock_guard<std::mutex> lock(ownQueue.mutex);
+    if (!ownQueue.tasks.empty()) {
+      *task = ownQueue.tasks.front();
+      ownQueue.tasks.pop_front();
+      return true;
+    }
+  }
+  // Stealing from the end of the other queues, starting with the next thread
+  for (int offset = 1; offset < numberOfThreads; offset++) {
+    TaskQueue &victim = *job.queues[(thread + offset) % numberOfThreads];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = victim.tasks.back();
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::runTasks(Job &job, int thread) {
+  int task;
+  while (takeTask(job, thread, &task)) {
+    try {
+      (*job.body)(thread, task);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!job.firstException) {
+        job.firstException = std::current_exception();
+      }
+    }
+    if (job.remainingTasks.fetch_sub(1) == 1) {
+      // Last task : waking up the thread waiting in run
+      std::lock_guard<std::mutex> lock(mutex);
+      workDone.notify_all();
+    }
+  }
+}
+
+void WorkStealingPool::workerLoop(int thread) {
+  unsigned long seenGeneration = 0;
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      workAvailable.wait(lock, [this, seenGeneration]() {
+        return stopping || generation != seenGeneration;
+      });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+      job = currentJob;
+    }
+    if (job) {
+      runTasks(*job, thread);
+    }
+  }
+}
+
+void WorkStealingPool::run(int numberOfTasks,
+                           const std::function<void(int, int)> &body) {
+  std::unique_lock<std::mutex> busyLock(busy, std::try_to_lock);
+  if (workers.empty() || numberOfTasks <= 1 || !busyLock.owns_lock()) {
+    for (int task = 0; task < numberOfTasks; task++) {
+      body(0, task);
+    }
+    return;
+  }
+  std::shared_ptr<Job> job = std::make_shared<Job>();
+  job->body = &body;
+  job->remainingTasks.store(numberOfTasks);
+  // Consecutive tasks go to the same thread
+  for (int thread = 0; thread < numberOfThreads; thread++) {
+    job->queues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    int firstTask = (int)((long)thread * numberOfTasks / numberOfThreads);
+    int lastTask = (int)((long)(thread + 1) * numberOfTasks / numberOfThreads);
+    for (int task = firstTask; task < lastTask; task++) {
+      job->queues[thread]->tasks.push_back(task);
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentJob = job;
+    generation++;
+  }
+  workAvailable.notify_all();
+  runTasks(*job, 0);
+  std::exception_ptr firstException;
+  {
+    // All the queues are empty, waiting for the tasks still running
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [&job]() { return job->remainingTasks.load() == 0; });
+    currentJob.reset();
+    // Taken out of the job, which can be destroyed by a worker at any time
+    firstException = job->firstException;
+    job->firstException = nullptr;
+  }
+  if (firstException) {
+    std::rethrow_exception(firstException);
+  }
+}
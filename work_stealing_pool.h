@@ -0,0 +1,107 @@
+#pragma once // Include guard
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running independent tasks of uneven
+ * length
+ *
+ * The tasks of a run are split in one queue per thread. Each thread takes the
+ * tasks of its own queue in order, and once it is empty steals the last tasks
+ * of the other queues. As for ThreadPool, the thread calling run takes part
+ * in the work (as thread 0), and only one run goes on at a time : a run
+ * called while the pool is busy runs its tasks sequentially in the calling
+ * thread.
+ */
+class WorkStealingPool {
+public:
+  /**
+   * @brief Construct a new Work Stealing Pool object
+   *
+   * @param numberOfThreads : number of threads working on a run, including
+   * the calling thread. 0 means one per hardware thread.
+   */
+  explicit WorkStealingPool(int numberOfThreads = 0);
+
+  /**
+   * @brief Stop and join the workers
+   *
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  /**
+   * @brief Get the number of threads working on a run, including the calling
+   * thread
+   *
+   */
+  int getNumberOfThreads() const;
+
+  /**
+   * @brief Call body(thread, task) for every task in [0, numberOfTasks),
+   * thread being the index in [0, getNumberOfThreads()) of the thread running
+   * it. Returns once all the tasks are done. If a task throws, the first
+   * exception is rethrown in the calling thread.
+   *
+   */
+  void run(int numberOfTasks, const std::function<void(int, int)> &body);
+
+private:
+  /**
+   * @brief Tasks waiting to be run by one thread
+   *
+   */
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  /**
+   * @brief Tasks of one run. Workers keep a reference on it so that a worker
+   * waking up late never touches the next run.
+   *
+   */
+  struct Job {
+    const std::function<void(int, int)> *body;
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::atomic<int> remainingTasks;
+    std::exception_ptr firstException;
+  };
+
+  void workerLoop(int thread);
+  void runTasks(Job &job, int thread);
+
+  /**
+   * @brief Take the next task of the queue of thread, or steal one from
+   * another queue. Returns false if all the queues are empty.
+   *
+   */
+  bool takeTask(Job &job, int thread, int *task);
+
+  int numberOfThreads;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable workAvailable;
+  std::condition_variable workDone;
+  /**
+   * @brief Held during a whole run, to detect a busy pool
+   *
+   */
+  std::mutex busy;
+
+  std::shared_ptr<Job> currentJob;
+  /**
+   * @brief Incremented for each new run, to wake up the workers
+   *
+   */
+  unsigned long generation;
+  bool stopping;
+};